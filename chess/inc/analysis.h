@@ -0,0 +1,71 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <engine_player.h>
+#include <search.h>
+
+#include <SDL.h>
+
+#define ANALYSIS_MAX_LINES 3
+#define ANALYSIS_DEFAULT_LINES 3
+#define ANALYSIS_SLOTS 3
+#define ANALYSIS_FRESH 0x4 // set on the middle slot index while the gui hasn't taken it
+
+typedef struct analysis_line {
+    int score; // from white's point of view
+    int depth;
+    char text[MAX_BUFFER_SIZE]; // "d12 +0.35 e4 e5 Nf3 Nc6", as much of the pv as fits
+} analysis_line_t;
+
+// everything the gui needs from one iteration, copied as a whole through the channel
+typedef struct analysis_update {
+    unsigned long long hash; // position the lines belong to, updates for an older one are stale
+    analysis_line_t lines[ANALYSIS_MAX_LINES];
+    int lines_count;
+    unsigned long long nodes;
+    unsigned long long nps;
+} analysis_update_t;
+
+// Searches the position on screen on its own thread until told otherwise, best lines first.
+// Results go back through a triple buffer: the search thread fills its back slot and swaps it with the middle one,
+// the gui swaps its front slot with the middle one when it's marked fresh. Neither side ever waits on the other.
+typedef struct analysis {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* changed;
+    SDL_atomic_t stop;
+    search_t* search;
+    int lines;
+
+    // only touched with the lock held
+    engine_job_t pending;
+    char has_pending;
+    char is_busy;
+    char is_quitting;
+
+    // search thread only
+    engine_job_t* job;
+    int back;
+
+    // gui thread only
+    unsigned long long requested_hash;
+    int front;
+
+    analysis_update_t slots[ANALYSIS_SLOTS];
+    SDL_atomic_t middle;
+} analysis_t;
+
+char analysis_new(analysis_t* analysis, const eval_params_t* params, int lines);
+
+// restarts the search only when the position changed, cheap enough to call every frame
+void analysis_set_position(analysis_t* analysis, const position_t* position, const unsigned long long* hashes, int hashes_count);
+
+// stops searching until the next position is set
+void analysis_pause(analysis_t* analysis);
+
+// the newest update since the last call, NULL if there is none
+const analysis_update_t* analysis_poll(analysis_t* analysis);
+
+void analysis_destroy(analysis_t* analysis);
+
+#endif
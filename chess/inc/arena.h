@@ -0,0 +1,21 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 16
+
+// Linear allocator: objects are bumped out of one block and released all together with arena_reset.
+typedef struct arena {
+    unsigned char* memory;
+    size_t capacity;
+    size_t offset;
+    size_t peak;
+} arena_t;
+
+void arena_new(arena_t* arena, size_t capacity);
+void* arena_alloc(arena_t* arena, size_t size);
+void arena_reset(arena_t* arena);
+void arena_destroy(arena_t* arena);
+
+#endif
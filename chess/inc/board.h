@@ -1,10 +1,14 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <arena.h>
 #include <private.h>
+#include <utils.h>
 
 typedef struct cell cell_t;
 typedef struct chess_piece chess_piece_t;
+typedef struct texture texture_t;
+typedef struct chess_piece_pool chess_piece_pool_t;
 
 static const int board_matrix[BOARD_SZ] = {
     ROOK,
@@ -75,10 +79,16 @@ static const int board_matrix[BOARD_SZ] = {
 
 typedef struct board {
     cell_t* cells[BOARD_SZ];
+    texture_t* background;
+    chess_piece_pool_t* piece_pool;
+    int hovered_cell_index;
     void (*draw)(struct board* board);
 } board_t;
 
-void board_new(board_t* board);
+void board_new(board_t* board, arena_t* cells_arena, chess_piece_pool_t* piece_pool);
+void board_highlight_cell(board_t* board, int cell_index);
+chess_piece_t* board_place_piece(board_t* board, unsigned index, piece_type_t type, char is_white);
+void board_clear(board_t* board);
 void board_restore_state(board_t* board);
 void board_destroy(board_t* board);
 
@@ -0,0 +1,45 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <mapped_file.h>
+#include <position.h>
+
+// Polyglot .bin opening books: 16 byte big endian entries (key, move, weight, learn) sorted by key.
+// The file is mapped read-only and never copied, one book_t can be probed by any number of threads.
+
+#define BOOK_ENTRY_SIZE 16
+#define POLYGLOT_KEYS_COUNT 781 // 12 * 64 pieces, 4 castling rights, 8 en passant columns, side to move
+
+typedef enum book_selection { book_weighted = 0, book_best } book_selection_t;
+
+typedef struct book_entry {
+    unsigned long long key;
+    unsigned short move;
+    unsigned short weight;
+    unsigned int learn;
+} book_entry_t;
+
+typedef struct book {
+    mapped_file_t file;
+    size_t count;
+    unsigned long long keys[POLYGLOT_KEYS_COUNT];
+} book_t;
+
+// keys_path is optional: the standard polyglot Random64 numbers are built in, so books made by other tools read as is.
+// A text file with 781 hex numbers overrides them, only for books hashed with different keys.
+char book_open(book_t* book, const char* path, const char* keys_path);
+void book_close(book_t* book);
+
+// only fills book->keys, for code that hashes positions without reading a book
+char book_load_keys(book_t* book, const char* keys_path);
+
+unsigned long long book_hash(const book_t* book, const position_t* position);
+unsigned short book_encode_move(move_t move);
+
+// every legal book move for the position with its weight, returns how many were found
+int book_probe(const book_t* book, const position_t* position, move_t* moves, int* weights, int max_count);
+
+// random is only used by book_weighted, entries with weight 0 are never played
+char book_pick_move(const book_t* book, const position_t* position, book_selection_t selection, unsigned long long random, move_t* move);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef BOOK_BUILDER_H
+#define BOOK_BUILDER_H
+
+#include <book.h>
+
+#define BOOK_BUILDER_DEFAULT_MAX_PLIES 30
+#define BOOK_BUILDER_DEFAULT_MIN_GAMES 3
+#define BOOK_BUILDER_DEFAULT_MEMORY_MB 512
+#define BOOK_BUILDER_CHUNK_SIZE (16 * 1024 * 1024)
+#define BOOK_BUILDER_MERGE_FAN_IN 64 // runs open at once while merging, more are merged in several passes
+
+typedef struct book_builder_options {
+    const char* output_path;
+    char** input_paths; // pgn files, mapped and split in chunks between the workers
+    int inputs_count;
+    int threads;
+    int max_plies; // positions deeper in the game are not recorded
+    int min_games; // moves played less often are left out of the book
+    int memory_mb; // shared by all the workers' record buffers, runs are spilled to disk beyond it
+    const char* keys_path;
+} book_builder_options_t;
+
+// chess --build-book <output.bin> <games.pgn>... [--threads n] [--max-plies n] [--min-games n] [--memory mb] [--book-keys file]
+//
+// Positions are hashed with the standard polyglot keys unless --book-keys says otherwise, so the book is read by any
+// polyglot tool and not only by this program
+int book_builder_main(int argc, char** argv);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The asset bundle is produced at build time by tools/asset_cooker.c and mapped read-only at startup.
+// Layout: header, entries sorted by name, then every payload aligned to BUNDLE_ALIGNMENT.
+// Textures are stored as raw RGBA pixels, fonts as the untouched ttf file and sounds as PCM
+// already converted to the format the mixer is opened with, so nothing gets decoded at runtime.
+
+#define BUNDLE_MAGIC 0x42534843 // "CHSB"
+#define BUNDLE_VERSION 1
+#define BUNDLE_NAME_SZ 48
+#define BUNDLE_ALIGNMENT 16
+
+#define ASSET_BUNDLE_PATH "../assets/assets.bundle"
+
+typedef enum bundle_asset_type { bundle_texture = 1, bundle_font, bundle_sound } bundle_asset_type_t;
+
+typedef struct bundle_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+} bundle_header_t;
+
+typedef struct bundle_entry {
+    char name[BUNDLE_NAME_SZ]; // path relative to the assets folder, e.g. "textures/rook_w.comp"
+    uint32_t type;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t width;  // textures: pixels, sounds: frequency
+    uint32_t height; // textures: pixels, sounds: channels
+    uint32_t format; // sounds: SDL audio format
+    uint32_t reserved[2];
+} bundle_entry_t;
+
+char bundle_open(const char* path);
+const bundle_entry_t* bundle_find(const char* asset_path, bundle_asset_type_t type);
+const void* bundle_data(const bundle_entry_t* entry);
+void bundle_close();
+
+#endif
@@ -1,28 +1,25 @@
 #ifndef CELL_H
 #define CELL_H
 
+#include <arena.h>
 #include <cglm/vec2.h>
 #include <color.h>
 
-typedef struct texture texture_t;
 typedef struct chess_piece chess_piece_t;
 
+// cells are plain board data, their colors are baked into the board background texture
 typedef struct cell {
-    texture_t* cell_texture;
     chess_piece_t* entity;
     char is_occupied;
     int pos_x, pos_y;
-    void (*draw)(struct cell* cell);
 } cell_t;
 
-cell_t* cell_new(vec2 pos, vec2 sz, color_t);
-void cell_highlight(cell_t* cell, float x, float y, color_t);
+cell_t* cell_new(arena_t* arena, vec2 pos);
 char is_cell_busy(cell_t* cell);
 char is_cell_upper_bound(cell_t* cell);
 char is_cell_lower_bound(cell_t* cell);
 char is_cell_left_bound(cell_t* cell);
 char is_cell_right_bound(cell_t* cell);
 void cell_restore_state(cell_t* cell);
-void cell_destroy(cell_t* cell);
 
 #endif
\ No newline at end of file
@@ -1,23 +1,20 @@
 #ifndef CESS_PIECE_H
 #define CESS_PIECE_H
 
+#include <arena.h>
 #include <private.h>
 #include <queue.h>
+#include <texture.h>
 #include <utils.h>
 
 typedef struct board board_t;
 typedef struct cell cell_t;
-typedef struct texture texture_t;
 
 // pawn moves
 typedef struct piece_move {
     cell_t* possible_cells;
-    texture_t* markers;
 } piece_move_t;
 
-piece_move_t* piece_move_new();
-void piece_move_destroy(piece_move_t* move);
-
 // move data
 typedef struct chess_piece_move_data {
     int index_array[MAX_QUEUE_SIZE];
@@ -37,6 +34,7 @@ typedef struct chess_piece_data {
 typedef struct chess_piece {
     piece_type_t piece_type;
     texture_t* chess_texture;
+    texture_t texture_instance; // shares the SDL texture of its type, only the quad is per piece
     piece_move_t moves[MAX_QUEUE_SIZE];
     chess_piece_data_t piece_data;
     chess_piece_move_data_t possible_squares;
@@ -59,14 +57,27 @@ char get_rook_legal_moves(chess_piece_t* piece, board_t* board, char simulate);
 char get_bishop_legal_moves(chess_piece_t* piece, board_t* board, char simulate);
 char get_king_legal_moves(chess_piece_t* piece, board_t* board, char simulate);
 
-chess_piece_t* chess_piece_new(piece_type_t type, char is_white, const char use_blending);
+// fixed set of piece slots, one per piece on the board. Captured pieces give their slot back and a promoting pawn
+// releases its own before the new piece takes one, so there is never more than PIECE_POOL_SIZE in use
+typedef struct chess_piece_pool {
+    chess_piece_t* slots;
+    chess_piece_t* free_pieces[PIECE_POOL_SIZE];
+    int free_count;
+} chess_piece_pool_t;
+
+void chess_piece_init(chess_piece_t* piece, piece_type_t type, char is_white, const char use_blending);
+chess_piece_t* chess_piece_new(arena_t* arena, piece_type_t type, char is_white, const char use_blending);
+void chess_piece_pool_new(chess_piece_pool_t* pool, arena_t* arena);
+chess_piece_t* chess_piece_pool_acquire(chess_piece_pool_t* pool, piece_type_t type, char is_white, const char use_blending);
+void chess_piece_pool_release(chess_piece_pool_t* pool, chess_piece_t* piece);
+void chess_piece_pool_reset(chess_piece_pool_t* pool);
 void chess_piece_set_entity_cell(board_t* board, chess_piece_t* piece, int index);
 void chess_piece_set_entity_null(board_t* board, unsigned index);
 char chess_piece_is_near_upper_bound(chess_piece_t* piece);
 char chess_piece_is_near_lower_bound(chess_piece_t* piece);
 char chess_piece_is_near_left_bound(chess_piece_t* piece);
 char chess_piece_is_near_right_bound(chess_piece_t* piece);
-void chess_piece_destroy(chess_piece_t* piece);
+void chess_piece_release_textures();
 const char* chess_piece_to_string(chess_piece_t* piece);
 
 #endif
\ No newline at end of file
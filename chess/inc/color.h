@@ -20,6 +20,7 @@ static const color_t BLUE = {0, 0, 0xFF, 0xFF};
 
 static const color_t TURN = {0xFF, 0xFF, 0xFF, 0xFF};
 
-static const color_t SELECTION_BLACK = {125, 125, 125, 0xFF};
+// blended over the hovered cell, darkens it roughly like the old (125, 125, 125) color mod did
+static const color_t SELECTION_OVERLAY = {0, 0, 0, 130};
 
 #endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef ENGINE_GAME_H
+#define ENGINE_GAME_H
+
+#include <book.h>
+#include <pgn.h>
+#include <search.h>
+
+// one engine setup: search limits and evaluation weights
+typedef struct engine_config {
+    char name[MAX_PGN_TAG_SIZE];
+    search_limits_t limits;
+    eval_params_t params;
+} engine_config_t;
+
+// how a game between two searches is started and cut short
+typedef struct engine_game_options {
+    int random_plies;
+    int max_plies;
+    unsigned long long seed;
+    SDL_atomic_t* stop; // optional, aborts the game in progress
+    const book_t* book; // optional, shared by every game, its moves are played without searching
+    book_selection_t book_selection;
+    const tablebases_t* tablebases; // optional, the game is adjudicated as soon as it reaches a table
+} engine_game_options_t;
+
+// parses "name=a,depth=5,nodes=20000,time=100,eval=weights.txt", missing keys keep the defaults
+char engine_config_parse(engine_config_t* config, const char* spec);
+
+// plays a whole game, searches[1] plays white and searches[0] black. Returns FALSE when it was stopped.
+char engine_game_play(pgn_game_t* game, const position_t* start, search_t* searches[MAX_PLAYERS], const search_limits_t* limits[MAX_PLAYERS], const engine_game_options_t* options);
+
+#endif
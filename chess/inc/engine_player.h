@@ -0,0 +1,68 @@
+#ifndef ENGINE_PLAYER_H
+#define ENGINE_PLAYER_H
+
+#include <search.h>
+#include <time_manager.h>
+
+#include <SDL.h>
+
+#define ENGINE_PLAYER_DEFAULT_TIME_MS 1000
+
+// what the search thread is asked to do, hashes are the game plies since the last capture or pawn move
+typedef struct engine_job {
+    position_t position;
+    unsigned long long hashes[MAX_GAME_PLIES];
+    int hashes_count;
+    char is_ponder;
+    char has_clock; // the time manager splits the clock, otherwise the player's limits apply
+    time_control_t clock;
+} engine_job_t;
+
+// A computer opponent for the gui: one search on its own thread, the render loop only polls it.
+// During the other side's turn it searches the position after the reply it expects, a ponder hit turns that
+// search into the real one and keeps the time already spent, a miss aborts it and starts over from the
+// transposition table the aborted search filled.
+typedef struct engine_player {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* changed;
+    SDL_atomic_t stop;
+    SDL_atomic_t ponder;
+    search_t* search;
+    search_limits_t limits;
+    time_manager_t time_manager; // search thread only
+    char is_timed;
+
+    // only touched with the lock held
+    engine_job_t pending;
+    char has_pending;
+    char is_busy;
+    char is_quitting;
+    char is_new_game; // the next job clears the transposition table first
+    unsigned long long current_hash; // position being searched
+    char is_current_ponder;
+    search_result_t result;
+    unsigned long long result_hash;
+    char has_result;
+    char is_result_ponder;
+
+    // the reply the last search expects, and the position it is a reply to
+    move_t predicted_move;
+    unsigned long long predicted_hash;
+} engine_player_t;
+
+char engine_player_new(engine_player_t* engine, const eval_params_t* params, const search_limits_t* limits);
+
+// call every frame on the engine's turn: returns TRUE with the move once it's found, otherwise makes sure the position is searched.
+// clock is the engine's own, NULL plays with the fixed limits
+char engine_player_think(engine_player_t* engine, const position_t* position, const unsigned long long* hashes, int hashes_count, const time_control_t* clock, move_t* move);
+
+// call every frame on the other side's turn: searches the expected reply if there is one
+void engine_player_ponder(engine_player_t* engine, const position_t* position, const unsigned long long* hashes, int hashes_count, const time_control_t* clock);
+
+// drops whatever is searched or found, the transposition table is cleared before the next search
+void engine_player_new_game(engine_player_t* engine);
+
+void engine_player_destroy(engine_player_t* engine);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include <search.h>
+
+#define EPD_MAX_MOVES 8
+#define EPD_MAX_ID 64
+#define EPD_DEFAULT_TIME_MS 1000
+
+// one test position: the engine has to play one of the best moves, or none of the avoided ones
+typedef struct epd_position {
+    position_t position;
+    char id[EPD_MAX_ID];
+    move_t best_moves[EPD_MAX_MOVES]; // bm
+    int best_moves_count;
+    move_t avoid_moves[EPD_MAX_MOVES]; // am
+    int avoid_moves_count;
+} epd_position_t;
+
+typedef struct epd_result {
+    search_result_t search;
+    char is_solved;
+
+    // from the iteration that found the move it kept until the end
+    unsigned solution_time_ms;
+    unsigned long long solution_nodes;
+    int solution_depth;
+} epd_result_t;
+
+typedef struct epd_options {
+    const char* path;
+    const char* csv_path; // one line per position, to compare engine versions
+    const char* eval_path;
+    search_limits_t limits;
+    int threads;
+} epd_options_t;
+
+// fen without clocks followed by operations: bm Qg6; am Bxh7; id "WAC.001";
+char epd_parse(const char* line, epd_position_t* epd);
+char epd_is_solution(const epd_position_t* epd, move_t move);
+
+// chess --epd <suite.epd> [--time ms | --nodes n | --depth n] [--threads n] [--eval file] [--csv file]
+int epd_main(int argc, char** argv);
+
+#endif
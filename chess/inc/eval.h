@@ -0,0 +1,26 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <position.h>
+
+// Every weight is a plain int so that tools can treat the whole struct as an array of parameters.
+// Piece square tables are seen from white's side with a8 first, black pieces read them mirrored.
+typedef struct eval_params {
+    int material[PAWN + 1];
+    int piece_square[PAWN + 1][BOARD_SZ];
+    int bishop_pair;
+    int tempo;
+} eval_params_t;
+
+extern const eval_params_t default_eval_params;
+
+#define EVAL_PARAMS_COUNT ((int)(sizeof(eval_params_t) / sizeof(int)))
+
+// text files with a name followed by its values on each line, missing entries keep the defaults
+char eval_params_load(eval_params_t* params, const char* path);
+char eval_params_save(const eval_params_t* params, const char* path);
+
+// centipawns from the side to move point of view
+int evaluate(const position_t* position, const eval_params_t* params);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#define FONT_FIRST_GLYPH 32
+#define FONT_LAST_GLYPH 126
+#define FONT_GLYPH_COUNT (FONT_LAST_GLYPH - FONT_FIRST_GLYPH + 1)
+#define FONT_ATLAS_W 512
+
+#define MAX_FONT_FILES 4
+#define MAX_FONTS 8
+
+// where a printable ascii glyph lives inside the atlas and how far it moves the pen
+typedef struct glyph {
+    SDL_Rect atlas_rect;
+    int advance;
+} glyph_t;
+
+// a font rasterized once for a given size, strings are drawn as quads sampling the atlas
+typedef struct font {
+    char* path;
+    uint16_t size;
+    int line_height;
+    SDL_Texture* atlas;
+    glyph_t glyphs[FONT_GLYPH_COUNT];
+} font_t;
+
+font_t* font_get(const char* path, uint16_t size);
+int font_measure(font_t* font, const char* text);
+void font_cache_destroy();
+
+#endif
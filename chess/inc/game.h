@@ -1,18 +1,28 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <analysis.h>
+#include <arena.h>
 #include <board.h>
 #include <chess_piece.h>
+#include <engine_player.h>
 #include <player.h>
 #include <queue.h>
 #include <scoreboard.h>
+#include <snapshot.h>
+#include <tablebase.h>
 #include <text.h>
+#include <uci_engine.h>
 
+#define MOVETEXT_SIZE (HISTORY_SIZE * 12)
 
-typedef struct texture_pool {
-    texture_t textures[TEXTURE_POOL_SIZE];
-    int i, j;
-} texture_pool_t;
+
+// legal move markers: one shared dot texture drawn at every marker position
+typedef struct marker_pool {
+    texture_t* dot;
+    SDL_Point positions[MAX_QUEUE_SIZE];
+    int count;
+} marker_pool_t;
 
 typedef struct {
     int swap_index;
@@ -32,9 +42,11 @@ struct game_state {
     game_state_t* next[2]; // this should be a hashmap
 };
 
-game_state_t* game_state_new();
+game_state_t* game_state_new(arena_t* arena);
 
 struct game {
+    arena_t arena;       // lives as long as the game: states, cells
+    arena_t match_arena; // reset on every restart: players, turn queue
     board_t board;
     queue_t* players_queue;
     player_t* current_player;
@@ -42,9 +54,60 @@ struct game {
     chess_piece_t* promoted_piece;
     render_text_t* player_turn_text;
     scoreboard_t scoreboard;
-    chess_piece_t* promotion_pieces[PROMOTION_PIECES_COUNT];
+    chess_piece_t* promotion_pieces[MAX_PLAYERS][PROMOTION_PIECES_COUNT]; // [is_white][piece], created once at startup
+    chess_piece_pool_t piece_pool;
+    marker_pool_t legal_move_markers;
     char is_promoting_pawn;
 
+    // undo/redo: one snapshot per ply, the clocks are only tracked to fill them in
+    history_t history;
+    int halfmove_clock;
+    int fullmove_number;
+
+    // the move that led to each ply and the hash of the position it gave, same ring indexes as the history
+    move_t moves[HISTORY_SIZE];
+    unsigned long long hashes[HISTORY_SIZE];
+
+    // endgames with few pieces left are decided as soon as they are reached
+    tablebases_t tablebases;
+
+    // chess clocks, off while clock_ms is 0. Both sides get clock_ms for every clock_moves moves (0: the whole game)
+    // and clock_increment_ms back after each move, all set before game_init
+    unsigned clock_ms;
+    unsigned clock_increment_ms;
+    int clock_moves;
+    double clock_remaining_ms[MAX_PLAYERS]; // [is_white]
+    Uint64 clock_last_tick;
+    render_text_t* clock_texts[MAX_PLAYERS];
+
+    // optional computer opponent, set before game_init
+    char has_engine;
+    char is_engine_white;
+    unsigned engine_time_ms;
+    engine_player_t engine;
+
+    // an external uci engine plays that side instead when its command is set before game_init
+    const char* uci_command;
+    char has_uci_engine;
+    char is_uci_ready;
+    uci_engine_t uci_engine;
+    int uci_searches;            // go commands not answered yet, only the last bestmove can be played
+    unsigned long long uci_hash; // position of the last search, 0 once it's stopped
+    uci_message_t uci_info;      // last info line, logged with the move
+
+    // live analysis of the position on screen, drawn in the bottom strip instead of the scores. F2 toggles it
+    char is_analysis_visible; // set before game_init to start with it on
+    int analysis_lines;       // set before game_init, 0 keeps the default
+    char has_analysis;
+    char was_analysis_toggle_pressed;
+    analysis_t analysis;
+    unsigned long long analysis_hash; // position the panel shows
+    int analysis_white_score;
+    float analysis_refresh_ms;        // one display refresh
+    float since_analysis_refresh_ms;
+    render_text_t* analysis_texts[ANALYSIS_MAX_LINES];
+    render_text_t* analysis_nps_text;
+
     // FSM
     game_state_t* game_states[MAX_GAME_STATES];
     game_state_t* current_state;
@@ -55,6 +118,8 @@ game_t* game_new();
 void game_init(game_t* game);
 void game_reset_state(game_t* game);
 void game_update(game_t* game);
+// san moves from the first stored ply to the current one: "1. e4 e5 2. Nf3"
+int game_get_movetext(const game_t* game, char* buffer, int size);
 void game_destroy(game_t* game);
 
 #endif
\ No newline at end of file
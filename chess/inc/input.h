@@ -0,0 +1,32 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL.h>
+
+#define INPUT_RECORD_HEADER "# chess input 1"
+
+// Everything the game reads from the mouse and keyboard goes through here, once per frame.
+// Recording writes one line per change, stamped with the frame and the ms since the first frame:
+//   <frame> <ms> mouse <x> <y> <buttons>
+//   <frame> <ms> key <scancode> <0|1>
+//   <frame> <ms> end
+// Replaying applies the changes on the same frames, ignores the real devices and stops after the end line,
+// so a session plays back identically at full speed, even under the dummy video driver.
+typedef enum input_event_type { input_mouse = 0, input_key, input_end } input_event_type_t;
+
+typedef struct input_event {
+    Uint32 frame;
+    Uint32 time_ms;
+    input_event_type_t type;
+    int x, y;       // mouse position, or scancode and pressed state for keys
+    Uint32 buttons;
+} input_event_t;
+
+void input_new(const char* record_path, const char* replay_path);
+char input_update(); // FALSE once the replay is over
+char input_is_replaying();
+Uint32 input_get_mouse_state(int* x, int* y);
+const unsigned char* input_get_keys();
+void input_destroy();
+
+#endif
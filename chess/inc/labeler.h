@@ -0,0 +1,34 @@
+#ifndef LABELER_H
+#define LABELER_H
+
+#include <position.h>
+
+#include <stdio.h>
+
+#define LABELER_CHUNK_SIZE (64 * 1024)   // input bytes per job, so that a chunk and its output stay in cache
+#define LABELER_POSITIONS_PER_CHUNK 64   // same idea for arrays of positions
+#define LABELER_SLOTS_PER_THREAD 2       // finished chunks waiting for the writer, per worker
+#define LABELER_MAX_LINE (MAX_FEN_SIZE * 2)
+
+// what the rules say about one position
+typedef struct position_label {
+    move_t moves[MAX_MOVES];
+    int moves_count;
+    char in_check;
+    outcome_t outcome;
+    const char* reason; // checkmate, stalemate..., NULL while the game goes on
+} position_label_t;
+
+void labeler_label_position(const position_t* position, position_label_t* label);
+
+// labels every position, the array is split in chunks between the threads
+void labeler_label_positions(const position_t* positions, position_label_t* labels, int count, int threads);
+
+// one fen per line in, one line per fen out in the same order: fen, uci moves, in check, result, reason, separated by tabs.
+// Invalid lines come out as the line followed by "error". Returns the number of lines, -1 if the output couldn't be written.
+long long labeler_label_text(const char* text, size_t size, FILE* output, int threads);
+
+// chess --label <positions.fen | -> [--output file] [--threads n]
+int labeler_main(int argc, char** argv);
+
+#endif
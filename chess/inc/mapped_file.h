@@ -0,0 +1,17 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// a whole file mapped read-only, pages are shared by every thread and loaded on first touch
+typedef struct mapped_file {
+    const unsigned char* data;
+    size_t size;
+    void* file;    // windows file and mapping handles
+    void* mapping;
+} mapped_file_t;
+
+char mapped_file_open(mapped_file_t* file, const char* path);
+void mapped_file_close(mapped_file_t* file);
+
+#endif
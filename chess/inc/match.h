@@ -0,0 +1,37 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <engine_game.h>
+
+#define MATCH_DEFAULT_GAMES 20000
+#define MATCH_DEFAULT_ELO0 0.0
+#define MATCH_DEFAULT_ELO1 5.0
+#define MATCH_DEFAULT_ALPHA 0.05
+#define MATCH_DEFAULT_BETA 0.05
+#define MATCH_DEFAULT_OUTPUT "match.pgn"
+#define MATCH_SPRT_PSEUDO_COUNT 0.5 // added to each kind of result, a prior that keeps the variance away from zero
+
+typedef struct match_options {
+    int max_games;
+    int threads;
+    int random_plies;
+    int max_plies;
+    unsigned long long seed;
+    engine_config_t engines[MAX_PLAYERS]; // engine a and engine b
+    const char* openings_path;
+    const char* book_path;
+    const char* book_keys_path;
+    book_selection_t book_selection;
+    const char* tablebases_path; // directory of endgame tables, probed by the searches and to adjudicate
+    const char* output_path;
+
+    // sprt: h0 is "a is elo0 stronger than b", h1 "a is elo1 stronger than b"
+    double elo0, elo1;
+    double alpha, beta;
+} match_options_t;
+
+// chess --match [games] --engine-a spec --engine-b spec [--threads n] [--openings file] [--book file] [--book-keys file] [--book-best] [--tablebases dir] [--random-plies n] [--max-plies n]
+//               [--elo0 x] [--elo1 x] [--alpha x] [--beta x] [--seed n] [--pgn file]
+int match_main(int argc, char** argv);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef OPENINGS_H
+#define OPENINGS_H
+
+#include <position.h>
+
+// start positions for engine games: one fen or epd per line, empty lines and '#' comments are skipped
+typedef struct openings {
+    position_t* positions;
+    int count;
+} openings_t;
+
+char openings_load(openings_t* openings, const char* path);
+void openings_destroy(openings_t* openings);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <stdio.h>
+
+#define PERF_HISTORY_SIZE 600
+#define PERF_HUD_REFRESH_MS 250.0f
+#define PERF_HUD_LINES 5
+
+// Set CHESS_PERF_DUMP=<file.csv|file.json> to stream one record per frame, F1 toggles the overlay.
+#define PERF_DUMP_ENV "CHESS_PERF_DUMP"
+
+typedef enum perf_counter {
+    perf_draw_calls = 0,
+    perf_texture_uploads,
+    perf_text_updates,
+    perf_glyph_rasterizations,
+    perf_allocations, // heap and arena allocations made while the game runs
+    perf_moves,       // moves played, their frames measure how long handling a move takes
+    // ---
+    MAX_PERF_COUNTERS
+} perf_counter_t;
+
+typedef struct perf_frame {
+    float frame_ms;
+    float movegen_ms;
+    unsigned counters[MAX_PERF_COUNTERS];
+} perf_frame_t;
+
+// a summary keeps every frame time to report percentiles over the whole run
+typedef struct perf_summary {
+    float* frame_times;
+    unsigned long long frames_count;
+    unsigned long long capacity;
+    double total_ms;
+    double total_movegen_ms;
+    float max_movegen_ms;
+    unsigned long long move_frames_count;
+    double move_frames_ms;
+    float max_move_frame_ms;
+    unsigned long long counters[MAX_PERF_COUNTERS];
+} perf_summary_t;
+
+void perf_new(char keep_summary);
+void perf_count(perf_counter_t counter);
+void perf_movegen_begin();
+void perf_movegen_end();
+void perf_frame_end(float frame_ms, const unsigned char* keys);
+void perf_hud_draw();
+void perf_print_summary(FILE* stream);
+void perf_destroy();
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <position.h>
+
+#define MAX_PGN_TAG_SIZE 64
+#define PGN_BUFFER_SIZE (16 * 1024)
+#define PGN_LINE_WIDTH 80
+
+typedef struct pgn_game {
+    char event[MAX_PGN_TAG_SIZE];
+    char white[MAX_PGN_TAG_SIZE];
+    char black[MAX_PGN_TAG_SIZE];
+    char termination[MAX_PGN_TAG_SIZE];
+    char date[MAX_PGN_TAG_SIZE]; // yyyy.mm.dd, "????.??.??" until someone sets it
+    int round;
+    char fen[MAX_FEN_SIZE]; // empty when the game starts from the initial position
+    move_t moves[MAX_GAME_PLIES];
+    int moves_count;
+    outcome_t outcome;
+} pgn_game_t;
+
+void pgn_game_new(pgn_game_t* game, const position_t* start);
+
+// today's date for the Date tag. It reads the local time, which isn't thread safe: call it once before the workers
+// start and copy the result into their games
+void pgn_get_date(char* date, size_t size);
+
+// returns the length written or -1 when the buffer is too small
+int pgn_write_game(const pgn_game_t* game, char* buffer, size_t size);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <private.h>
+#include <snapshot.h>
+#include <utils.h>
+
+#include <stddef.h>
+
+#define MAX_MOVES 256
+#define MAX_FEN_SIZE 128
+#define MAX_SAN_SIZE 8
+#define MAX_UCI_SIZE 6
+#define MAX_GAME_PLIES 1024
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+// move flags
+#define MOVE_CAPTURE 0x1
+#define MOVE_DOUBLE_PUSH 0x2
+#define MOVE_ENPASSANT 0x4
+#define MOVE_CASTLING 0x8
+
+typedef struct move {
+    unsigned char from, to;
+    unsigned char promotion; // piece_type_t or none
+    unsigned char flags;
+} move_t;
+
+// Headless rules: no cells, textures or sounds, small enough to be copied to every thread.
+// squares hold +type for white and -type for black pieces, index 0 is the upper left cell (a8) like the gui board.
+typedef struct position {
+    signed char squares[BOARD_SZ];
+    unsigned long long hash;
+    int king_index[MAX_PLAYERS]; // [is_white]
+    int halfmove_clock;
+    int fullmove_number;
+    signed char enpassant_index; // cell a pawn can move to capturing en passant or INVALID_INDEX
+    unsigned char castling;      // CASTLE_* flags from snapshot.h
+    char is_white_to_move;
+} position_t;
+
+typedef enum outcome { outcome_none = 0, outcome_white_wins, outcome_black_wins, outcome_draw } outcome_t;
+
+// what position_make_move needs to take the move back
+typedef struct undo {
+    unsigned long long hash;
+    int halfmove_clock;
+    signed char captured;
+    signed char enpassant_index;
+    unsigned char castling;
+} undo_t;
+
+// must be called once before any other position function, it's not thread safe
+void position_init();
+
+void position_set_start(position_t* position);
+char position_from_fen(position_t* position, const char* fen);
+void position_to_fen(const position_t* position, char* buffer, size_t size);
+void position_from_snapshot(position_t* position, const snapshot_t* snapshot);
+void position_to_snapshot(const position_t* position, snapshot_t* snapshot);
+// no castling rights, en passant or clocks, for positions built piece by piece
+void position_set_squares(position_t* position, const signed char* squares, char is_white_to_move);
+
+int position_generate_moves(const position_t* position, move_t* moves, char captures_only);
+void position_make_move(position_t* position, move_t move, undo_t* undo);
+void position_unmake_move(position_t* position, move_t move, const undo_t* undo);
+void position_make_null_move(position_t* position, undo_t* undo);
+void position_unmake_null_move(position_t* position, const undo_t* undo);
+
+char position_is_attacked(const position_t* position, int index, char by_white);
+char position_in_check(const position_t* position);
+char position_has_insufficient_material(const position_t* position);
+char position_is_repetition(const unsigned long long* hashes, int count, int halfmove_clock, int times);
+piece_type_t position_get_piece(const position_t* position, int index, char* is_white);
+outcome_t position_get_outcome(const position_t* position, const unsigned long long* hashes, int hashes_count, const char** reason);
+const char* outcome_to_string(outcome_t outcome);
+
+char move_equals(move_t a, move_t b);
+void move_to_uci(move_t move, char* buffer);
+char position_parse_uci(const position_t* position, const char* text, move_t* move);
+char position_parse_san(const position_t* position, const char* text, move_t* move);
+void position_move_to_san(const position_t* position, move_t move, char* buffer);
+// the legal move that turns one position into the other, for moves made by hand on the board
+char position_find_move(const position_t* before, const position_t* after, move_t* move);
+
+#endif
@@ -28,7 +28,7 @@
 #define TRUE 1
 #define FALSE 0
 
-#define TEXTURE_POOL_SIZE 32
+#define MAX_TEXTURE_INSTANCES 64
 #define PIECE_POOL_SIZE 32
 #define PROMOTION_PIECES_POOL_SIZE 4
 
@@ -44,6 +44,10 @@
 
 #define MAX_GAME_STATES 4
 
+// game lifetime objects (states, cells, piece slots) and objects that only live for one match (players)
+#define GAME_ARENA_SIZE (128 * 1024)
+#define MATCH_ARENA_SIZE (4 * 1024)
+
 #define UPPER_LEFT_ROOK_INDEX 0
 #define UPPER_RIGHT_ROOK_INDEX 7
 #define LOWER_LEFT_ROOK_INDEX 56
@@ -54,6 +58,12 @@
 
 #define LMB_INDEX 1
 
+// mixer output format, sounds in the asset bundle are cooked for it
+#define AUDIO_FREQUENCY 44000
+#define AUDIO_SAMPLE_FORMAT AUDIO_S32LSB
+#define AUDIO_CHANNELS 2
+#define AUDIO_CHUNK_SIZE 4096
+
 #define CHECK(f, ret, msg) if(!f){\
     fprintf(stderr, strcat_macro(msg, "\n"));\
     return ret;\
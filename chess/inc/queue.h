@@ -1,6 +1,8 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include <arena.h>
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,7 +15,7 @@ typedef struct queue {
     void** data;
 } queue_t;
 
-queue_t* queue_new(size_t size, size_t allocation_size);
+queue_t* queue_new(arena_t* arena, size_t size, size_t allocation_size);
 void queue_enqueue(queue_t* queue, void* data);
 void queue_dequeue(queue_t* queue);
 void* queue_peek(queue_t* queue);
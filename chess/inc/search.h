@@ -0,0 +1,88 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <eval.h>
+#include <position.h>
+#include <tablebase.h>
+
+#include <SDL.h>
+
+#define MAX_SEARCH_DEPTH 64
+#define MATE_SCORE 30000
+#define INFINITE_SCORE 32000
+#define MAX_MULTIPV 8
+#define SEARCH_TT_SIZE (1 << 17) // entries, a power of two: 2 MB in every search
+
+// mate scores are the only ones above this, the distance to mate is MATE_SCORE - |score|
+#define IS_MATE_SCORE(score) ((score) > MATE_SCORE - MAX_SEARCH_DEPTH || (score) < -MATE_SCORE + MAX_SEARCH_DEPTH)
+
+// zero means no limit, a search without any limit stops at MAX_SEARCH_DEPTH
+typedef struct search_limits {
+    int depth;
+    unsigned long long nodes;
+    unsigned time_ms;
+} search_limits_t;
+
+typedef struct search_result {
+    move_t best_move;
+    int score;
+    int depth;
+    unsigned long long nodes;
+    unsigned time_ms;
+    move_t pv[MAX_SEARCH_DEPTH];
+    int pv_length;
+} search_result_t;
+
+typedef enum tt_bound { tt_none = 0, tt_upper, tt_lower, tt_exact } tt_bound_t;
+
+// mate scores are stored as distances from the entry's position, not from the root
+typedef struct tt_entry {
+    unsigned long long key;
+    move_t move;
+    short score;
+    signed char depth;
+    unsigned char bound;
+} tt_entry_t;
+
+// called after every completed iteration with the results so far, one per line. Returning FALSE ends the search there
+typedef char (*search_callback_t)(const search_result_t* results, int lines, void* data);
+
+// One search per thread: everything it touches lives here, the eval params are only read.
+typedef struct search {
+    position_t position;
+    const eval_params_t* params;
+    search_limits_t limits;
+    SDL_atomic_t* stop; // optional, another thread sets it to abort the search
+    SDL_atomic_t* ponder; // optional, the node and time limits wait while another thread keeps it set
+    const tablebases_t* tablebases; // optional, probed once few enough pieces are left
+    search_callback_t on_iteration; // optional
+    void* callback_data;
+    unsigned long long nodes;
+    Uint32 start_ticks;
+    char is_aborted;
+
+    // game positions before the root plus the ones on the current path, for repetitions
+    unsigned long long hashes[MAX_GAME_PLIES + MAX_SEARCH_DEPTH];
+    int hashes_count;
+
+    move_t pv[MAX_SEARCH_DEPTH][MAX_SEARCH_DEPTH];
+    int pv_length[MAX_SEARCH_DEPTH];
+    move_t killers[MAX_SEARCH_DEPTH][2];
+
+    // multi pv: the root moves of the lines already found at this depth are skipped
+    move_t excluded_moves[MAX_MULTIPV];
+    int excluded_count;
+
+    // transposition table, kept from one search to the next so a worker reusing its search starts warm
+    tt_entry_t tt[SEARCH_TT_SIZE];
+} search_t;
+
+void search_new(search_t* search, const eval_params_t* params);
+// forgets the transposition table, like ucinewgame: results of a game don't depend on the games before it
+void search_clear(search_t* search);
+void search_set_position(search_t* search, const position_t* position, const unsigned long long* game_hashes, int game_hashes_count);
+void search_run(search_t* search, const search_limits_t* limits, search_result_t* result);
+// the best lines with different first moves, best first. results must hold lines entries, at most MAX_MULTIPV
+void search_run_multipv(search_t* search, const search_limits_t* limits, search_result_t* results, int lines);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <book.h>
+#include <search.h>
+
+#define SELFPLAY_DEFAULT_DEPTH 4
+#define SELFPLAY_DEFAULT_RANDOM_PLIES 8
+#define SELFPLAY_DEFAULT_MAX_PLIES 400
+#define SELFPLAY_DEFAULT_OUTPUT "selfplay.pgn"
+
+typedef struct selfplay_options {
+    int games;
+    int threads;        // defaults to one per core
+    int random_plies;   // random moves played before the engine takes over, so that games differ
+    int max_plies;      // longer games are adjudicated as draws
+    unsigned long long seed;
+    search_limits_t limits;
+    const char* openings_path; // one fen per line, games cycle through them
+    const char* book_path;     // polyglot book played from the start position or the opening
+    const char* book_keys_path;
+    book_selection_t book_selection;
+    const char* tablebases_path; // directory of endgame tables, probed by the searches and to adjudicate
+    const char* output_path;
+} selfplay_options_t;
+
+// chess --selfplay <games> [--threads n] [--depth n] [--nodes n] [--openings file] [--book file] [--book-keys file] [--book-best] [--tablebases dir] [--random-plies n] [--max-plies n] [--seed n] [--pgn file]
+int selfplay_main(int argc, char** argv);
+
+#endif
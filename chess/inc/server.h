@@ -0,0 +1,29 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <search.h>
+#include <tablebase.h>
+
+#define SERVER_DEFAULT_PORT 7780
+#define SERVER_MAX_CONNECTIONS 256
+#define SERVER_MAX_LINE 4096
+#define SERVER_MAX_RESPONSE 2048
+
+typedef struct server_options {
+    const char* socket_path; // unix domain socket, without it the server listens on localhost
+    int port;
+    int threads; // searches running at the same time, defaults to one per core
+    const char* tablebases_path;
+} server_options_t;
+
+// chess --serve [--socket path | --port n] [--threads n] [--tablebases dir]
+//
+// One request per line, one answer per line in the same order, so clients can send many requests in one write:
+//   ping                 -> ok
+//   moves <fen>          -> ok e2e4 d2d4 ...
+//   status <fen>         -> ok <1-0|0-1|1/2-1/2|*> <checkmate|stalemate|fifty move rule|insufficient material|check|->
+//   best <depth> <fen>   -> ok <move> <score> <depth> <nodes>
+// anything else gets "error <reason>". Rules requests are answered by the event loop, searches by the worker pool.
+int server_main(int argc, char** argv);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <private.h>
+#include <utils.h>
+
+#define SNAPSHOT_SIZE 40
+
+// must hold a full 500 ply game, older plies are overwritten once it's full
+#define HISTORY_SIZE 1024
+
+// one nibble per square: low 3 bits are the piece type, the high bit marks white pieces
+#define SNAPSHOT_WHITE_BIT 0x8
+#define SNAPSHOT_TYPE_MASK 0x7
+
+// castling rights, stored next to the side to move in snapshot_t.flags
+#define CASTLE_WHITE_SHORT 0x1
+#define CASTLE_WHITE_LONG 0x2
+#define CASTLE_BLACK_SHORT 0x4
+#define CASTLE_BLACK_LONG 0x8
+#define SNAPSHOT_WHITE_TO_MOVE 0x10
+
+// The whole game state in 40 bytes, squares go from the upper left cell (a8) to the lower right one (h1).
+typedef struct snapshot {
+    unsigned char squares[BOARD_SZ / 2];
+    unsigned short fullmove_number;
+    unsigned char flags;
+    signed char enpassant_index; // cell of the pawn that can be taken en passant or INVALID_INDEX
+    unsigned char halfmove_clock;
+    unsigned char white_score;
+    unsigned char black_score;
+    unsigned char reserved;
+} snapshot_t;
+
+typedef char snapshot_size_check[sizeof(snapshot_t) == SNAPSHOT_SIZE ? 1 : -1];
+
+// Ring buffer of one snapshot per ply. Plies are absolute numbers so that the cursor can scrub
+// back and forth, pushing after an undo drops the plies that could have been redone.
+typedef struct history {
+    snapshot_t plies[HISTORY_SIZE];
+    int first_ply;
+    int last_ply;
+    int current_ply;
+} history_t;
+
+void snapshot_clear(snapshot_t* snapshot);
+void snapshot_set_square(snapshot_t* snapshot, int index, piece_type_t type, char is_white);
+piece_type_t snapshot_get_square(const snapshot_t* snapshot, int index, char* is_white);
+char snapshot_is_white_to_move(const snapshot_t* snapshot);
+
+void history_reset(history_t* history, const snapshot_t* initial);
+void history_push(history_t* history, const snapshot_t* snapshot);
+const snapshot_t* history_undo(history_t* history);
+const snapshot_t* history_redo(history_t* history);
+const snapshot_t* history_seek(history_t* history, int ply);
+const snapshot_t* history_current(const history_t* history);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef STARTUP_PROFILER_H
+#define STARTUP_PROFILER_H
+
+#define MAX_STARTUP_PHASES 32
+#define MAX_STARTUP_PHASE_DEPTH 8
+
+// Set CHESS_PROFILE_STARTUP=1 (or pass --profile-startup) to print startup phase timings on stderr,
+// set it to a file path (or pass --profile-startup <file.json>) to dump them as json instead.
+#define STARTUP_PROFILER_ENV "CHESS_PROFILE_STARTUP"
+
+typedef struct startup_phase {
+    const char* name;
+    int depth;
+    unsigned long long begin;
+    unsigned long long end;
+} startup_phase_t;
+
+void startup_profiler_init(const char* output);
+void startup_profiler_begin(const char* phase);
+void startup_profiler_end();
+void startup_profiler_finish();
+
+#endif
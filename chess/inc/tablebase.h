@@ -0,0 +1,83 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <mapped_file.h>
+#include <position.h>
+
+#include <stdint.h>
+
+// Endgame tables for up to TABLEBASE_MAX_PIECES pieces, kings included, built offline by tablebase_generator.c.
+// One value per position: side to move, white king, black king, then the other pieces, each one a cell.
+// The white king is folded into the a1-d1-d4 triangle (files a-d with pawns) by mirroring the board.
+// Files are split in blocks of run length encoded values, so probing maps the file and decodes one block.
+
+#define TABLEBASE_MAX_PIECES 4
+#define TABLEBASE_MAGIC 0x42544843 // "CHTB"
+#define TABLEBASE_VERSION 1
+#define TABLEBASE_BLOCK_SIZE 4096 // positions per block
+#define TABLEBASE_SIGNATURE_SIZE 8
+#define TABLEBASE_EXTENSION ".tb"
+#define MAX_TABLEBASES 64
+
+#define TABLEBASES_PATH "../assets/tablebases"
+
+// values: the distance to mate is in plies, odd when the side to move mates and even when it gets mated
+#define TABLEBASE_UNKNOWN 0
+#define TABLEBASE_ILLEGAL 1
+#define TABLEBASE_DRAW 2
+#define TABLEBASE_MATE 3 // + distance to mate
+#define TABLEBASE_MAX_DTM (255 - TABLEBASE_MATE)
+
+typedef struct tablebase_header {
+    uint32_t magic;
+    uint32_t version;
+    char signature[TABLEBASE_SIGNATURE_SIZE];
+    uint32_t positions_count;
+    uint32_t blocks_count;
+    uint32_t max_dtm;
+    uint32_t reserved;
+} tablebase_header_t; // followed by blocks_count + 1 offsets from the start of the blocks, then the blocks
+
+typedef struct tablebase {
+    char signature[TABLEBASE_SIGNATURE_SIZE]; // white pieces then black ones, kings first: "KQK", "KRKP"
+    signed char pieces[TABLEBASE_MAX_PIECES]; // white king, black king, then the others as +type for white and -type for black
+    int pieces_count;
+    char has_pawns;
+    unsigned int positions_count;
+    int max_dtm;
+
+    // a table is either being generated (values) or mapped from its file (blocks)
+    unsigned char* values;
+    mapped_file_t file;
+    const uint32_t* offsets;
+    const unsigned char* blocks;
+} tablebase_t;
+
+typedef struct tablebases {
+    tablebase_t tables[MAX_TABLEBASES];
+    int count;
+} tablebases_t;
+
+// parses "KQK" like material, the stronger side must come first. Doesn't allocate anything
+char tablebase_init(tablebase_t* table, const char* signature);
+unsigned int tablebase_index(const tablebase_t* table, const signed char* squares, char is_white_to_move);
+// FALSE for the indexes that don't hold a position: pieces on top of each other, or another index already has it
+char tablebase_decode(const tablebase_t* table, unsigned int index, signed char* squares, char* is_white_to_move);
+unsigned char tablebase_get(const tablebase_t* table, unsigned int index);
+char tablebase_write(const tablebase_t* table, const char* path);
+
+// writes the name of the table for this material (e.g. "KRKP"), returns TRUE when black is the stronger side
+char tablebase_get_signature(const signed char* squares, char* signature);
+
+// maps every table found in the directory, returns FALSE if there's none
+char tablebases_open(tablebases_t* tablebases, const char* directory);
+void tablebases_close(tablebases_t* tablebases);
+const tablebase_t* tablebases_find(const tablebases_t* tablebases, const char* signature);
+
+// raw value for the position, TABLEBASE_UNKNOWN when no table has it
+unsigned char tablebases_get_value(const tablebases_t* tablebases, const position_t* position);
+
+// TRUE when the position is in a table: wdl is 1, 0 or -1 for the side to move and dtm the plies to mate
+char tablebases_probe(const tablebases_t* tablebases, const position_t* position, int* wdl, int* dtm);
+
+#endif
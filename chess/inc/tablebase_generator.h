@@ -0,0 +1,10 @@
+#ifndef TABLEBASE_GENERATOR_H
+#define TABLEBASE_GENERATOR_H
+
+#include <tablebase.h>
+
+// chess --generate-tablebases <directory> [KQK KRK KBNK ... | all] [--threads n]
+// tables needed after a capture or a promotion are generated first, existing files in the directory are reused
+int tablebase_generator_main(int argc, char** argv);
+
+#endif
@@ -3,14 +3,15 @@
 
 #include <color.h>
 #include <context.h>
+#include <font.h>
+#include <private.h>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
 typedef struct render_text {
-    SDL_Surface* text_surface;
-    SDL_Texture* copy_texture;
-    TTF_Font* font;
+    font_t* font;
+    char text[MAX_BUFFER_SIZE];
     SDL_Color color;
     int width;
     int height;
@@ -18,7 +19,7 @@ typedef struct render_text {
 
 render_text_t* text_new(const char* font, uint16_t font_size, const char* text, color_t color);
 void text_draw(render_text_t* render_text, int screen_x, int screen_y);
-void text_update(render_text_t* render_text, char* new_text);
+void text_update(render_text_t* render_text, const char* new_text);
 void text_destroy(render_text_t* render_text);
 
-#endif
\ No newline at end of file
+#endif
@@ -20,6 +20,8 @@ typedef struct texture {
 
 texture_t* texture_load_from_file(const char* path, const char use_blending);
 texture_t* texture_create_raw(uint32_t width, uint32_t height, color_t color);
+texture_t* texture_create_static(uint32_t width, uint32_t height, const void* rgba_pixels);
+void texture_render_instances(texture_t* texture, const SDL_Point* positions, int count, uint8_t alpha);
 void texture_destroy(texture_t* texture);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+
+#include <search.h>
+
+#include <SDL.h>
+
+#define TIME_MANAGER_MOVES_TO_GO 30     // sudden death is planned as if that many moves were left
+#define TIME_MANAGER_OVERHEAD_MS 30     // lost between the end of the search and the clock stopping
+#define TIME_MANAGER_FAIL_LOW_CP 30     // a best score dropping that much since the last iteration buys more time
+#define TIME_MANAGER_EASY_ITERATIONS 4  // the same best move that many iterations in a row is an easy move
+
+// what's left on the clock of the side to move
+typedef struct time_control {
+    unsigned remaining_ms;
+    unsigned increment_ms;
+    int moves_to_go; // until the next time control, 0 for sudden death
+} time_control_t;
+
+// Decides after every iteration whether the next one is worth starting. A move normally gets the optimal time,
+// more when the best move keeps changing or its score drops, less when it stays the same, never the maximum.
+typedef struct time_manager {
+    Uint64 start;
+    double optimal_ms;
+    double maximum_ms;
+    char is_forced; // only one legal move, the first iteration is enough
+    move_t best_move;
+    int best_score;
+    int stable_iterations;
+    double instability; // best move changes, the older ones count less
+} time_manager_t;
+
+void time_manager_start(time_manager_t* manager, const time_control_t* control, const position_t* position);
+
+// call with the best line of each completed iteration: FALSE once the search should stop
+char time_manager_should_continue(time_manager_t* manager, const search_result_t* result);
+
+double time_manager_elapsed_ms(const time_manager_t* manager);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <eval.h>
+
+#define TUNER_MAX_PIECES 32
+#define TUNER_DEFAULT_ITERATIONS 1000
+#define TUNER_DEFAULT_RATE 1.0 // centipawns per step, adam scales it per parameter
+#define TUNER_DEFAULT_OUTPUT "tuned_eval.txt"
+#define TUNER_REPORT_EVERY 100
+
+// One labeled position, only what the evaluation reads from it. Each piece packs the square it reads its table at
+// (already mirrored for black), its type and its color: square | type << 6 | is_white << 9.
+typedef struct tuner_entry {
+    float result;            // for white: 1 won, 0.5 drawn, 0 lost
+    signed char bishop_pair; // 1 white has it, -1 black has it, 0 both or none
+    signed char tempo;       // 1 white to move, -1 black to move
+    unsigned char count;
+    unsigned short pieces[TUNER_MAX_PIECES];
+} tuner_entry_t;
+
+typedef struct tuner_options {
+    const char* path;
+    const char* eval_path; // starting weights, the defaults otherwise
+    const char* output_path;
+    int iterations;
+    double rate;
+    int threads;
+} tuner_options_t;
+
+// fen followed by the game result: 1-0, 0-1, 1/2-1/2 or white's score as a number like 0.5, quoted or in brackets or not.
+// Positions in check are refused, the static evaluation says nothing useful about them
+char tuner_parse_entry(const char* line, tuner_entry_t* entry);
+
+// chess --tune <positions.txt> [--eval file] [--output file] [--iterations n] [--rate r] [--threads n]
+//
+// Texel tuning: the weights minimize the squared error between the results and a sigmoid of the evaluation,
+// scaled by the constant that fits the starting weights best. Material, piece square tables, bishop pair and
+// tempo are all tuned, the result is written with eval_params_save.
+int tuner_main(int argc, char** argv);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef UCI_ENGINE_H
+#define UCI_ENGINE_H
+
+#include <position.h>
+
+#include <SDL.h>
+
+#define UCI_MAX_LINE 4096
+#define UCI_MAX_OUTPUT 8192
+#define UCI_QUEUE_SIZE 64
+#define UCI_QUIT_TIMEOUT_MS 500
+#define UCI_POLL_MS 5        // windows only, anonymous pipes are polled
+#define UCI_PIPE_SIZE 65536 // windows only, posix pipes keep their default size
+
+typedef enum uci_message_type {
+    uci_message_uciok = 0,
+    uci_message_readyok,
+    uci_message_info,
+    uci_message_bestmove,
+    uci_message_exited, // the engine closed its output, nothing else will come
+} uci_message_type_t;
+
+// one line from the engine, parsed on the i/o thread. Moves stay in uci notation, only the game knows the position
+typedef struct uci_message {
+    uci_message_type_t type;
+    int depth;
+    int score;    // centipawns from the side to move, or moves to mate if is_mate
+    char is_mate;
+    unsigned long long nodes;
+    unsigned long long nps;
+    char move[8];   // bestmove, or the first pv move for info
+    char ponder[8]; // the reply the engine expects
+} uci_message_t;
+
+// An external engine speaking uci, run as a child process. A dedicated thread owns the pipes: it polls them
+// non-blocking, writes what the game queued and parses every line the engine prints into the message queue,
+// so the render loop only ever copies messages in and out under a lock. Posix waits on the pipes with poll,
+// windows drains its anonymous pipes in PIPE_NOWAIT mode and sleeps on an event in between.
+typedef struct uci_engine {
+#ifdef _WIN32
+    void* process;     // windows handles
+    void* to_engine;   // the engine's stdin
+    void* from_engine; // the engine's stdout
+    void* wake;        // event set when there is output to send or the thread has to quit
+#else
+    int pid;
+    int to_engine;   // the engine's stdin
+    int from_engine; // the engine's stdout
+    int wake[2];     // written to when there is output to send or the thread has to quit
+#endif
+
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+
+    // only touched with the lock held
+    char output[UCI_MAX_OUTPUT];
+    int output_length;
+    uci_message_t messages[UCI_QUEUE_SIZE];
+    int first_message;
+    int messages_count;
+    char is_quitting;
+
+    // i/o thread only
+    char line[UCI_MAX_LINE];
+    int line_length;
+} uci_engine_t;
+
+// command can carry arguments: posix runs it with the shell, windows with CreateProcess. The uci handshake is
+// queued right away
+char uci_engine_new(uci_engine_t* engine, const char* command);
+
+// queues one line for the engine, printf style, the newline is added
+void uci_engine_send(uci_engine_t* engine, const char* format, ...);
+
+// takes the oldest message, FALSE when there is none
+char uci_engine_poll(uci_engine_t* engine, uci_message_t* message);
+
+// asks the engine to quit, kills it if it doesn't in time
+void uci_engine_destroy(uci_engine_t* engine);
+
+#endif
@@ -0,0 +1,196 @@
+#include <analysis.h>
+
+#include <stdlib.h>
+
+static void format_line(const position_t* root, const search_result_t* result, analysis_line_t* line)
+{
+    line->score = root->is_white_to_move ? result->score : -result->score;
+    line->depth = result->depth;
+
+    char score[16];
+    if (IS_MATE_SCORE(line->score))
+    {
+        const int moves = (MATE_SCORE - SDL_abs(line->score) + 1) / 2;
+        SDL_snprintf(score, sizeof(score), "%s#%d", line->score > 0 ? "" : "-", moves);
+    } else
+    {
+        SDL_snprintf(score, sizeof(score), "%+.2f", line->score / 100.0);
+    }
+
+    int length = SDL_snprintf(line->text, MAX_BUFFER_SIZE, "d%d %s", result->depth, score);
+
+    // the pv is played out to write it in san, it stops at the first move that doesn't fit
+    position_t position = *root;
+    for (int i = 0; i != result->pv_length; ++i)
+    {
+        char san[MAX_SAN_SIZE];
+        position_move_to_san(&position, result->pv[i], san);
+
+        const int san_length = (int)SDL_strlen(san);
+        if (length + 1 + san_length >= MAX_BUFFER_SIZE) break;
+
+        line->text[length++] = ' ';
+        SDL_memcpy(line->text + length, san, san_length + 1);
+        length += san_length;
+
+        undo_t undo;
+        position_make_move(&position, result->pv[i], &undo);
+    }
+}
+
+static char on_iteration(const search_result_t* results, int lines, void* data)
+{
+    analysis_t* analysis = (analysis_t*)data;
+    const position_t* root = &analysis->job->position;
+
+    analysis_update_t* update = &analysis->slots[analysis->back];
+    update->hash = root->hash;
+    update->lines_count = SDL_min(lines, ANALYSIS_MAX_LINES);
+    update->nodes = results[0].nodes;
+    update->nps = results[0].nodes * 1000ull / SDL_max(results[0].time_ms, 1u);
+
+    for (int i = 0; i != update->lines_count; ++i) format_line(root, &results[i], &update->lines[i]);
+
+    // publish: the filled slot becomes the middle one, the old middle one is free to write next time
+    analysis->back = SDL_AtomicSet(&analysis->middle, analysis->back | ANALYSIS_FRESH) & ~ANALYSIS_FRESH;
+    return TRUE;
+}
+
+static int analysis_worker(void* data)
+{
+    analysis_t* analysis = (analysis_t*)data;
+
+    // no limits: it goes on until the position changes or the depth runs out
+    const search_limits_t limits = {0, 0, 0};
+    search_result_t results[ANALYSIS_MAX_LINES];
+
+    for (ever)
+    {
+        SDL_LockMutex(analysis->lock);
+        while (!analysis->has_pending && !analysis->is_quitting) SDL_CondWait(analysis->changed, analysis->lock);
+
+        if (analysis->is_quitting)
+        {
+            SDL_UnlockMutex(analysis->lock);
+            break;
+        }
+
+        *analysis->job = analysis->pending;
+        analysis->has_pending = FALSE;
+        analysis->is_busy = TRUE;
+        SDL_AtomicSet(&analysis->stop, FALSE);
+        SDL_UnlockMutex(analysis->lock);
+
+        const engine_job_t* job = analysis->job;
+        search_set_position(analysis->search, &job->position, job->hashes, job->hashes_count);
+        search_run_multipv(analysis->search, &limits, results, analysis->lines);
+
+        SDL_LockMutex(analysis->lock);
+        analysis->is_busy = FALSE;
+        SDL_UnlockMutex(analysis->lock);
+    }
+
+    return 0;
+}
+
+char analysis_new(analysis_t* analysis, const eval_params_t* params, int lines)
+{
+    SDL_memset(analysis, 0, sizeof(analysis_t));
+
+    analysis->search = (search_t*)malloc(sizeof(search_t));
+    CHECK(analysis->search, FALSE, "Couldn't allocate memory for analysis search");
+
+    analysis->job = (engine_job_t*)malloc(sizeof(engine_job_t));
+    if (!analysis->job)
+    {
+        SDL_Log("Couldn't allocate memory for analysis job");
+        analysis_destroy(analysis);
+        return FALSE;
+    }
+
+    search_new(analysis->search, params);
+    analysis->search->stop = &analysis->stop;
+    analysis->search->on_iteration = on_iteration;
+    analysis->search->callback_data = analysis;
+    analysis->lines = SDL_max(1, SDL_min(lines, ANALYSIS_MAX_LINES));
+
+    // each side owns one slot, the third one is the middle
+    analysis->back = 0;
+    SDL_AtomicSet(&analysis->middle, 1);
+    analysis->front = 2;
+
+    analysis->lock = SDL_CreateMutex();
+    analysis->changed = SDL_CreateCond();
+    analysis->thread = SDL_CreateThread(analysis_worker, "analysis", analysis);
+
+    if (!analysis->lock || !analysis->changed || !analysis->thread)
+    {
+        SDL_Log("Couldn't start analysis thread: [%s]", SDL_GetError());
+        analysis_destroy(analysis);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void analysis_set_position(analysis_t* analysis, const position_t* position, const unsigned long long* hashes, int hashes_count)
+{
+    if (!analysis->thread || analysis->requested_hash == position->hash) return;
+
+    SDL_LockMutex(analysis->lock);
+
+    engine_job_t* job = &analysis->pending;
+    job->position = *position;
+    job->hashes_count = SDL_min(hashes_count, MAX_GAME_PLIES);
+    SDL_memcpy(job->hashes, hashes + hashes_count - job->hashes_count, sizeof(unsigned long long) * job->hashes_count);
+    job->is_ponder = FALSE;
+
+    analysis->has_pending = TRUE;
+    if (analysis->is_busy) SDL_AtomicSet(&analysis->stop, TRUE);
+    SDL_CondSignal(analysis->changed);
+
+    SDL_UnlockMutex(analysis->lock);
+
+    analysis->requested_hash = position->hash;
+}
+
+void analysis_pause(analysis_t* analysis)
+{
+    if (!analysis->thread) return;
+
+    SDL_LockMutex(analysis->lock);
+    analysis->has_pending = FALSE;
+    if (analysis->is_busy) SDL_AtomicSet(&analysis->stop, TRUE);
+    SDL_UnlockMutex(analysis->lock);
+
+    analysis->requested_hash = 0;
+}
+
+const analysis_update_t* analysis_poll(analysis_t* analysis)
+{
+    if (!(SDL_AtomicGet(&analysis->middle) & ANALYSIS_FRESH)) return NULL;
+
+    // only the search thread sets the fresh bit, so it can't be lost between the check and the swap
+    analysis->front = SDL_AtomicSet(&analysis->middle, analysis->front) & ~ANALYSIS_FRESH;
+    return &analysis->slots[analysis->front];
+}
+
+void analysis_destroy(analysis_t* analysis)
+{
+    if (analysis->thread)
+    {
+        SDL_LockMutex(analysis->lock);
+        analysis->is_quitting = TRUE;
+        SDL_AtomicSet(&analysis->stop, TRUE);
+        SDL_CondSignal(analysis->changed);
+        SDL_UnlockMutex(analysis->lock);
+
+        SDL_WaitThread(analysis->thread, NULL);
+    }
+
+    if (analysis->changed) SDL_DestroyCond(analysis->changed);
+    if (analysis->lock) SDL_DestroyMutex(analysis->lock);
+    free(analysis->job);
+    free(analysis->search);
+    SDL_memset(analysis, 0, sizeof(analysis_t));
+}
@@ -0,0 +1,52 @@
+#include <arena.h>
+#include <perf_hud.h>
+#include <private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+void arena_new(arena_t* arena, size_t capacity)
+{
+    SDL_memset(arena, 0, sizeof(arena_t));
+
+    arena->memory = (unsigned char*)malloc(capacity);
+    if (!arena->memory)
+    {
+        SDL_Log("Couldn't allocate %u bytes for arena", (unsigned)capacity);
+        return;
+    }
+
+    arena->capacity = capacity;
+}
+
+void* arena_alloc(arena_t* arena, size_t size)
+{
+    const size_t offset = (arena->offset + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    if (offset + size > arena->capacity)
+    {
+        SDL_Log("Arena exhausted: %u of %u bytes used, %u requested", (unsigned)arena->offset, (unsigned)arena->capacity, (unsigned)size);
+        return NULL;
+    }
+
+    arena->offset = offset + size;
+    arena->peak = SDL_max(arena->peak, arena->offset);
+    perf_count(perf_allocations);
+
+    // callers rely on zeroed memory like they did with calloc
+    void* memory = arena->memory + offset;
+    SDL_memset(memory, 0, size);
+
+    return memory;
+}
+
+void arena_reset(arena_t* arena) { arena->offset = 0; }
+
+void arena_destroy(arena_t* arena)
+{
+    free(arena->memory);
+    SDL_memset(arena, 0, sizeof(arena_t));
+}
@@ -3,6 +3,8 @@
 #include <cglm/vec2.h>
 #include <chess_piece.h>
 #include <context.h>
+#include <perf_hud.h>
+#include <texture.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,15 +17,20 @@ extern window_t *window;
 
 static void _draw_board(struct board *board)
 {
-    // draw board
-    for (unsigned long cellIndex = 0ul; cellIndex != BOARD_SZ; ++cellIndex)
+    SDL_Renderer *native_renderer = (SDL_Renderer *)renderer->sdl_renderer;
+
+    // draw the whole checkerboard with a single copy
+    board->background->render(board->background, 0, NULL);
+
+    // darken the hovered cell with an overlay quad
+    if (!CHECK_IDX_RANGE(board->hovered_cell_index))
     {
-        cell_t *current_cell = board->cells[cellIndex];
+        const cell_t *hovered_cell = board->cells[board->hovered_cell_index];
+        const SDL_Rect overlay = {hovered_cell->pos_x, hovered_cell->pos_y, CELL_SZ, CELL_SZ};
 
-        if (current_cell != NULL)
-        {
-            current_cell->draw(current_cell);
-        }
+        SDL_SetRenderDrawColor(native_renderer, SELECTION_OVERLAY.r, SELECTION_OVERLAY.g, SELECTION_OVERLAY.b, SELECTION_OVERLAY.a);
+        SDL_RenderFillRect(native_renderer, &overlay);
+        perf_count(perf_draw_calls);
     }
 
     // draw pieces
@@ -38,12 +45,28 @@ static void _draw_board(struct board *board)
     }
 }
 
-static void place_chess_piece(board_t *board, unsigned index, vec2 position, piece_type_t type, char is_upper_board)
+static texture_t *create_background()
 {
-    chess_piece_t *piece = chess_piece_new(type, !is_upper_board, TRUE);
-    piece->set_position(piece, (int)position[0], (int)position[1]);
-    board->cells[index]->entity = piece;
-    board->cells[index]->is_occupied = TRUE;
+    // one texel per cell, the texture is then stretched over the board with nearest filtering
+    color_t pixels[BOARD_SZ];
+
+    for (unsigned long cell_index = 0ul; cell_index != BOARD_SZ; ++cell_index)
+    {
+        const unsigned long row = cell_index / CELLS_PER_ROW;
+        const unsigned long column = cell_index % CELLS_PER_ROW;
+
+        // swap color based on cell oddity/evenly
+        pixels[cell_index] = ((row + column) % 2) ? BLACK : WHITE;
+    }
+
+    texture_t *background = texture_create_static(CELLS_PER_ROW, CELLS_PER_ROW, pixels);
+    CHECK(background, NULL, "Couldn't create board background texture");
+
+    SDL_SetTextureScaleMode(background->texture, SDL_ScaleModeNearest);
+    SDL_SetTextureBlendMode(background->texture, SDL_BLENDMODE_NONE);
+    background->set_size(background, SCREEN_W, SCREEN_H);
+
+    return background;
 }
 
 static void board_init(board_t *board)
@@ -52,80 +75,86 @@ static void board_init(board_t *board)
     // it's something i might want to implement later so that
     // i can also connect a chess engine for the AI.
 
-    color_t cell_color = color_create(0, 0, 0, 0);
-
-    // place down board cells
-    for (unsigned long columnIndex = 0ul; columnIndex != CELLS_PER_ROW; ++columnIndex)
+    for (unsigned long cell_index = 0ul; cell_index != BOARD_SZ; ++cell_index)
     {
-        const char is_odd = (columnIndex % 2);
-        char is_black = is_odd;
+        const int board_matrix_value = board_matrix[cell_index];
+        const piece_type_t type = (piece_type_t)board_matrix_value;
+        const char is_upper_board = (cell_index <= NUM_OF_CHESS_PIECES);
 
-        for (unsigned long rowIndex = 0ul; rowIndex != CELLS_PER_ROW; ++rowIndex)
+        // place down chess pieces for each of know type
+        switch (board_matrix_value)
         {
-            // transform b-dim array to mono dimensional
-            const int cell_index = (columnIndex * CELLS_PER_ROW) + rowIndex;
-
-            const int pos_x = (cell_index % CELLS_PER_ROW) * CELL_SZ;
-            const int pos_y = (cell_index / CELLS_PER_ROW) * CELL_SZ;
-
-            vec2 position = {(float)pos_x, (float)pos_y};
-            vec2 cell_size = {CELL_SZ, CELL_SZ};
-
-            // swap color based on cell oddity/evenly
-            cell_color = is_black ? BLACK : WHITE;
-            is_black = !is_black;
-
-            // after we calculated color of the cell and position, let's create it
-            board->cells[cell_index] = cell_new(position, cell_size, cell_color);
-            board->cells[cell_index]->pos_x = pos_x;
-            board->cells[cell_index]->pos_y = pos_y;
-
-            const int board_matrix_value = board_matrix[cell_index];
-            const piece_type_t type = (piece_type_t)board_matrix_value;
-            const char is_upper_board = (cell_index <= NUM_OF_CHESS_PIECES);
-
-            // place down chess pieces for each of know type
-            switch (board_matrix_value)
-            {
-            default: break;
-            case rook: place_chess_piece(board, cell_index, position, type, is_upper_board); break;
-            case knight: place_chess_piece(board, cell_index, position, type, is_upper_board); break;
-            case bishop: place_chess_piece(board, cell_index, position, type, is_upper_board); break;
-            case queen: place_chess_piece(board, cell_index, position, type, is_upper_board); break;
-            case king: place_chess_piece(board, cell_index, position, type, is_upper_board); break;
-            case pawn: place_chess_piece(board, cell_index, position, type, is_upper_board); break;
-            }
+        default: break;
+        case rook: board_place_piece(board, cell_index, type, !is_upper_board); break;
+        case knight: board_place_piece(board, cell_index, type, !is_upper_board); break;
+        case bishop: board_place_piece(board, cell_index, type, !is_upper_board); break;
+        case queen: board_place_piece(board, cell_index, type, !is_upper_board); break;
+        case king: board_place_piece(board, cell_index, type, !is_upper_board); break;
+        case pawn: board_place_piece(board, cell_index, type, !is_upper_board); break;
         }
     }
 }
 
-void board_new(board_t *board)
+void board_new(board_t *board, arena_t *cells_arena, chess_piece_pool_t *piece_pool)
 {
     // board_t *board = (board_t *)calloc(1, sizeof(board_t));
     // CHECK(board, NULL, "Could not allocate memory for board");
     memset(board, 0, sizeof(board_t));
 
     board->draw = _draw_board;
+    board->piece_pool = piece_pool;
+    board->hovered_cell_index = INVALID_INDEX;
+    board->background = create_background();
+
+    // cells are created once and survive restarts, only the pieces on them are placed again
+    for (unsigned long cell_index = 0ul; cell_index != BOARD_SZ; ++cell_index)
+    {
+        // transform mono dimensional index to screen coordinates
+        vec2 position = {(float)((cell_index % CELLS_PER_ROW) * CELL_SZ), (float)((cell_index / CELLS_PER_ROW) * CELL_SZ)};
+        board->cells[cell_index] = cell_new(cells_arena, position);
+    }
 
     board_init(board);
 }
 
-void board_restore_state(board_t *board)
+void board_highlight_cell(board_t *board, int cell_index) { board->hovered_cell_index = CHECK_IDX_RANGE(cell_index) ? INVALID_INDEX : cell_index; }
+
+chess_piece_t *board_place_piece(board_t *board, unsigned index, piece_type_t type, char is_white)
+{
+    chess_piece_t *piece = chess_piece_pool_acquire(board->piece_pool, type, is_white, TRUE);
+    CHECK(piece, NULL, "Couldn't place chess piece");
+
+    piece->set_position(piece, board->cells[index]->pos_x, board->cells[index]->pos_y);
+    board->cells[index]->entity = piece;
+    board->cells[index]->is_occupied = TRUE;
+
+    return piece;
+}
+
+void board_clear(board_t *board)
 {
+    // every piece goes back to the pool at once, the new ones reuse the same slots
+    chess_piece_pool_reset(board->piece_pool);
     for (unsigned long i = 0; i != BOARD_SZ; ++i)
     {
         cell_restore_state(board->cells[i]);
+        board->cells[i]->entity = NULL;
     }
+}
+
+void board_restore_state(board_t *board)
+{
+    board_clear(board);
+    board->hovered_cell_index = INVALID_INDEX;
 
     board_init(board);
 }
 
 void board_destroy(board_t *board)
 {
-    for (unsigned long i = 0; i != BOARD_SZ; ++i)
-    {
-        cell_destroy(board->cells[i]);
-    }
+    // cells and pieces belong to the game arenas, only GPU resources are released here
+    texture_destroy(board->background);
+    chess_piece_release_textures();
 
     // free(board);
-}
\ No newline at end of file
+}
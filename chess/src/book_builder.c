@@ -0,0 +1,629 @@
+#include <book_builder.h>
+
+#include <SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// one move seen in one position, once aggregated it also counts how every game that played it ended
+typedef struct book_record {
+    unsigned long long key;
+    unsigned int wins, draws, losses; // for the side that played the move
+    unsigned short move;              // polyglot encoding
+} book_record_t;
+
+typedef struct book_builder {
+    book_builder_options_t options;
+    book_t book; // only its keys are used, to hash positions: the polyglot ones unless --book-keys overrides them
+    mapped_file_t* inputs;
+    int chunks_count;
+    size_t records_per_worker;
+    SDL_atomic_t next_chunk;
+
+    // shared between workers, only touched with the lock held
+    SDL_mutex* lock;
+    int runs_count;
+    char is_failed;
+    int finished_chunks;
+    long long games, skipped_games, positions;
+} book_builder_t;
+
+typedef struct book_worker {
+    book_builder_t* builder;
+    book_record_t* records;
+    size_t count;
+    long long games, skipped_games, positions; // since the last chunk was reported
+} book_worker_t;
+
+static int compare_records(const void* a, const void* b)
+{
+    const book_record_t* first = (const book_record_t*)a;
+    const book_record_t* second = (const book_record_t*)b;
+
+    if (first->key != second->key) return first->key < second->key ? -1 : 1;
+    return (int)first->move - (int)second->move;
+}
+
+static void get_run_path(const book_builder_t* builder, int index, char* buffer, size_t size) { SDL_snprintf(buffer, size, "%s.%i.run", builder->options.output_path, index); }
+
+// sorts the records and sums up the ones for the same move in the same position
+static size_t aggregate_records(book_record_t* records, size_t count)
+{
+    if (!count) return 0;
+
+    qsort(records, count, sizeof(book_record_t), compare_records);
+
+    size_t aggregated = 0;
+    for (size_t i = 1; i != count; ++i)
+    {
+        if (!compare_records(&records[aggregated], &records[i]))
+        {
+            records[aggregated].wins += records[i].wins;
+            records[aggregated].draws += records[i].draws;
+            records[aggregated].losses += records[i].losses;
+        } else
+        {
+            records[++aggregated] = records[i];
+        }
+    }
+
+    return aggregated + 1;
+}
+
+static void write_run(book_worker_t* worker)
+{
+    book_builder_t* builder = worker->builder;
+
+    SDL_LockMutex(builder->lock);
+    const int index = builder->runs_count++;
+    SDL_UnlockMutex(builder->lock);
+
+    char path[MAX_BUFFER_SIZE * 4];
+    get_run_path(builder, index, path, sizeof(path));
+
+    FILE* file = fopen(path, "wb");
+    const char is_written = file && fwrite(worker->records, sizeof(book_record_t), worker->count, file) == worker->count;
+    if (file) fclose(file);
+
+    if (!is_written)
+    {
+        SDL_Log("Couldn't write book run %s", path);
+        SDL_LockMutex(builder->lock);
+        builder->is_failed = TRUE;
+        SDL_UnlockMutex(builder->lock);
+    }
+
+    worker->count = 0;
+}
+
+// the buffer is full: aggregating usually frees enough space, otherwise it goes to disk as a sorted run
+static void spill_records(book_worker_t* worker, char is_final)
+{
+    worker->count = aggregate_records(worker->records, worker->count);
+
+    if (worker->count && (is_final || worker->count > worker->builder->records_per_worker / 2)) write_run(worker);
+}
+
+static void add_record(book_worker_t* worker, unsigned long long key, move_t move, outcome_t outcome, char is_white)
+{
+    book_record_t* record = &worker->records[worker->count++];
+
+    record->key = key;
+    record->move = book_encode_move(move);
+    record->wins = outcome == (is_white ? outcome_white_wins : outcome_black_wins);
+    record->draws = outcome == outcome_draw;
+    record->losses = outcome == (is_white ? outcome_black_wins : outcome_white_wins);
+
+    worker->positions++;
+
+    if (worker->count == worker->builder->records_per_worker) spill_records(worker, FALSE);
+}
+
+// games are found by their "[Event" tag at the start of a line
+static size_t find_game_start(const char* text, size_t size, size_t offset)
+{
+    for (size_t i = offset; i + 7 <= size; ++i)
+    {
+        if (text[i] == '[' && (i == 0 || text[i - 1] == '\n') && !SDL_strncmp(text + i, "[Event ", 7)) return i;
+    }
+
+    return size;
+}
+
+static size_t skip_until(const char* text, size_t size, size_t i, char c)
+{
+    while (i < size && text[i] != c) i++;
+    return i < size ? i + 1 : size;
+}
+
+static char is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+static void parse_game(book_worker_t* worker, const char* text, size_t size)
+{
+    const int max_plies = worker->builder->options.max_plies;
+
+    outcome_t outcome = outcome_none;
+    char fen[MAX_FEN_SIZE] = {0};
+    size_t i = 0;
+
+    // tag pairs, only the result and the starting position matter here
+    for (;;)
+    {
+        while (i < size && is_space(text[i])) i++;
+        if (i >= size || text[i] != '[') break;
+
+        const size_t line_end = skip_until(text, size, i, '\n');
+        const size_t value_start = skip_until(text, line_end, i, '"');
+        size_t value_end = value_start;
+        while (value_end < line_end && text[value_end] != '"') value_end++;
+
+        const int value_length = (int)(value_end - value_start);
+
+        if (!SDL_strncmp(text + i, "[Result ", 8))
+        {
+            if (value_length == 3 && !SDL_strncmp(text + value_start, "1-0", 3)) outcome = outcome_white_wins;
+            else if (value_length == 3 && !SDL_strncmp(text + value_start, "0-1", 3)) outcome = outcome_black_wins;
+            else if (value_length == 7 && !SDL_strncmp(text + value_start, "1/2-1/2", 7)) outcome = outcome_draw;
+        } else if (!SDL_strncmp(text + i, "[FEN ", 5) && value_length < MAX_FEN_SIZE)
+        {
+            SDL_memcpy(fen, text + value_start, value_length);
+            fen[value_length] = '\0';
+        }
+
+        i = line_end;
+    }
+
+    position_t position;
+    position_set_start(&position);
+
+    // unfinished games can't tell which moves were good
+    if (outcome == outcome_none || (fen[0] && !position_from_fen(&position, fen)))
+    {
+        worker->skipped_games++;
+        return;
+    }
+
+    worker->games++;
+
+    for (int ply = 0; i < size && ply < max_plies;)
+    {
+        const char c = text[i];
+
+        if (is_space(c)) i++;
+        else if (c == '{') i = skip_until(text, size, i, '}');
+        else if (c == ';' || c == '%') i = skip_until(text, size, i, '\n');
+        else if (c == '(')
+        {
+            // variations can be nested
+            int depth = 0;
+            for (; i < size; ++i)
+            {
+                if (text[i] == '(') depth++;
+                else if (text[i] == ')' && --depth == 0) break;
+            }
+            i++;
+        } else
+        {
+            char token[MAX_BUFFER_SIZE];
+            int length = 0;
+
+            while (i < size && !is_space(text[i]) && text[i] != '{' && text[i] != '(' && text[i] != ';')
+            {
+                if (length != MAX_BUFFER_SIZE - 1) token[length++] = text[i];
+                i++;
+            }
+            token[length] = '\0';
+
+            // "12." and "12..." move numbers, possibly glued to the move
+            const char* san = token;
+            while (*san >= '0' && *san <= '9') san++;
+            if (*san == '.')
+            {
+                while (*san == '.') san++;
+            } else
+            {
+                san = token;
+            }
+
+            if (!*san || *san == '$' || *san == ')') continue;
+            if (!SDL_strcmp(san, "1-0") || !SDL_strcmp(san, "0-1") || !SDL_strcmp(san, "1/2-1/2") || !SDL_strcmp(san, "*")) break;
+
+            move_t move;
+            if (!position_parse_san(&position, san, &move)) break;
+
+            add_record(worker, book_hash(&worker->builder->book, &position), move, outcome, position.is_white_to_move);
+
+            undo_t undo;
+            position_make_move(&position, move, &undo);
+            ply++;
+        }
+    }
+}
+
+static void parse_chunk(book_worker_t* worker, const mapped_file_t* input, size_t start, size_t end)
+{
+    const char* text = (const char*)input->data;
+
+    // a chunk owns the games starting inside it, even if they end in the next one
+    for (size_t game = find_game_start(text, input->size, start); game < end;)
+    {
+        const size_t next = find_game_start(text, input->size, game + 1);
+        parse_game(worker, text + game, next - game);
+        game = next;
+    }
+}
+
+static void report_chunk(book_worker_t* worker)
+{
+    book_builder_t* builder = worker->builder;
+
+    SDL_LockMutex(builder->lock);
+
+    builder->games += worker->games;
+    builder->skipped_games += worker->skipped_games;
+    builder->positions += worker->positions;
+    builder->finished_chunks++;
+
+    const int progress_step = SDL_max(1, builder->chunks_count / 20);
+    if (builder->finished_chunks % progress_step == 0) fprintf(stderr, "book: %i/%i chunks, %lli games, %lli positions\n", builder->finished_chunks, builder->chunks_count, builder->games, builder->positions);
+
+    SDL_UnlockMutex(builder->lock);
+
+    worker->games = worker->skipped_games = worker->positions = 0;
+}
+
+static int book_worker_run(void* data)
+{
+    book_worker_t worker;
+    SDL_memset(&worker, 0, sizeof(book_worker_t));
+    worker.builder = (book_builder_t*)data;
+
+    const book_builder_t* builder = worker.builder;
+
+    worker.records = (book_record_t*)malloc(sizeof(book_record_t) * builder->records_per_worker);
+    if (!worker.records)
+    {
+        SDL_Log("Couldn't allocate memory for book worker");
+        SDL_LockMutex(worker.builder->lock);
+        worker.builder->is_failed = TRUE;
+        SDL_UnlockMutex(worker.builder->lock);
+        return -1;
+    }
+
+    for (ever)
+    {
+        int chunk = SDL_AtomicAdd(&worker.builder->next_chunk, 1);
+        if (chunk >= builder->chunks_count) break;
+
+        // chunks are numbered across all the inputs
+        int input = 0;
+        for (; chunk >= (int)((builder->inputs[input].size + BOOK_BUILDER_CHUNK_SIZE - 1) / BOOK_BUILDER_CHUNK_SIZE); ++input)
+        {
+            chunk -= (int)((builder->inputs[input].size + BOOK_BUILDER_CHUNK_SIZE - 1) / BOOK_BUILDER_CHUNK_SIZE);
+        }
+
+        const size_t start = (size_t)chunk * BOOK_BUILDER_CHUNK_SIZE;
+        parse_chunk(&worker, &builder->inputs[input], start, SDL_min(start + BOOK_BUILDER_CHUNK_SIZE, builder->inputs[input].size));
+        report_chunk(&worker);
+    }
+
+    spill_records(&worker, TRUE);
+    free(worker.records);
+
+    return 0;
+}
+
+#pragma region merge
+
+typedef struct run_reader {
+    FILE* file;
+    book_record_t record;
+} run_reader_t;
+
+typedef struct book_writer {
+    FILE* output;
+    int min_games;
+    book_record_t moves[MAX_MOVES]; // every move of the position being written
+    int moves_count;
+    long long entries;
+} book_writer_t;
+
+static void write_big_endian(unsigned char* bytes, unsigned long long value, int size)
+{
+    for (int i = size - 1; i >= 0; --i, value >>= 8) bytes[i] = (unsigned char)(value & 0xFF);
+}
+
+static int get_weight(const book_record_t* record) { return (int)SDL_min(2ull * record->wins + record->draws, (unsigned long long)SDL_MAX_SINT32); }
+
+static int compare_weights(const void* a, const void* b)
+{
+    const int first = get_weight((const book_record_t*)a), second = get_weight((const book_record_t*)b);
+    return (first < second) - (first > second);
+}
+
+// like polyglot, a win is worth two points and a draw one. Heaviest moves first, scaled down when they don't fit 16 bits
+static void write_position(book_writer_t* writer)
+{
+    int count = 0;
+    for (int i = 0; i != writer->moves_count; ++i)
+    {
+        const book_record_t* record = &writer->moves[i];
+        if (record->wins + record->draws + record->losses >= (unsigned)writer->min_games && get_weight(record) > 0) writer->moves[count++] = *record;
+    }
+
+    writer->moves_count = 0;
+    if (!count) return;
+
+    qsort(writer->moves, count, sizeof(book_record_t), compare_weights);
+
+    const int max_weight = get_weight(&writer->moves[0]);
+
+    for (int i = 0; i != count; ++i)
+    {
+        const int weight = max_weight > 0xFFFF ? (int)((long long)get_weight(&writer->moves[i]) * 0xFFFF / max_weight) : get_weight(&writer->moves[i]);
+
+        unsigned char entry[BOOK_ENTRY_SIZE] = {0};
+        write_big_endian(entry, writer->moves[i].key, 8);
+        write_big_endian(entry + 8, writer->moves[i].move, 2);
+        write_big_endian(entry + 10, SDL_max(weight, 1), 2);
+
+        fwrite(entry, 1, BOOK_ENTRY_SIZE, writer->output);
+        writer->entries++;
+    }
+}
+
+static void add_move(book_writer_t* writer, const book_record_t* record)
+{
+    if (writer->moves_count && writer->moves[0].key != record->key) write_position(writer);
+
+    // only key collisions can go past the legal moves count
+    if (writer->moves_count != MAX_MOVES) writer->moves[writer->moves_count++] = *record;
+}
+
+static void sift_down(run_reader_t** heap, int count, int index)
+{
+    for (;;)
+    {
+        int smallest = index;
+        const int left = index * 2 + 1, right = index * 2 + 2;
+
+        if (left < count && compare_records(&heap[left]->record, &heap[smallest]->record) < 0) smallest = left;
+        if (right < count && compare_records(&heap[right]->record, &heap[smallest]->record) < 0) smallest = right;
+        if (smallest == index) return;
+
+        run_reader_t* swap = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = swap;
+        index = smallest;
+    }
+}
+
+static void remove_run(const book_builder_t* builder, int index)
+{
+    char path[MAX_BUFFER_SIZE * 4];
+    get_run_path(builder, index, path, sizeof(path));
+    remove(path);
+}
+
+// k-way merge of the sorted runs [first, last), only one record per run is in memory. The merged records go to the
+// writer, or as they are to an intermediate run when there is none
+static char merge_range(const book_builder_t* builder, int first, int last, FILE* run, book_writer_t* writer)
+{
+    run_reader_t readers[BOOK_BUILDER_MERGE_FAN_IN];
+    run_reader_t* heap[BOOK_BUILDER_MERGE_FAN_IN];
+    SDL_memset(readers, 0, sizeof(readers));
+
+    const int count = last - first;
+    char is_merged = TRUE;
+
+    // a run that can't be read would silently drop games from the book
+    int heap_count = 0;
+    for (int i = 0; i != count; ++i)
+    {
+        char path[MAX_BUFFER_SIZE * 4];
+        get_run_path(builder, first + i, path, sizeof(path));
+
+        readers[i].file = fopen(path, "rb");
+        if (readers[i].file && fread(&readers[i].record, sizeof(book_record_t), 1, readers[i].file) == 1) heap[heap_count++] = &readers[i];
+        else if (!readers[i].file || ferror(readers[i].file))
+        {
+            SDL_Log("Couldn't read book run %s", path);
+            is_merged = FALSE;
+        }
+    }
+
+    if (!is_merged) heap_count = 0;
+
+    for (int i = heap_count / 2 - 1; i >= 0; --i) sift_down(heap, heap_count, i);
+
+    book_record_t pending;
+    char has_pending = FALSE;
+
+    while (heap_count)
+    {
+        run_reader_t* reader = heap[0];
+
+        if (has_pending && !compare_records(&pending, &reader->record))
+        {
+            pending.wins += reader->record.wins;
+            pending.draws += reader->record.draws;
+            pending.losses += reader->record.losses;
+        } else
+        {
+            if (has_pending && writer) add_move(writer, &pending);
+            else if (has_pending && fwrite(&pending, sizeof(book_record_t), 1, run) != 1) is_merged = FALSE;
+            pending = reader->record;
+            has_pending = TRUE;
+        }
+
+        if (fread(&reader->record, sizeof(book_record_t), 1, reader->file) != 1)
+        {
+            if (ferror(reader->file)) is_merged = FALSE;
+            heap[0] = heap[--heap_count];
+        }
+        sift_down(heap, heap_count, 0);
+    }
+
+    if (has_pending && writer) add_move(writer, &pending);
+    else if (has_pending && fwrite(&pending, sizeof(book_record_t), 1, run) != 1) is_merged = FALSE;
+    if (writer) write_position(writer);
+
+    for (int i = 0; i != count; ++i)
+    {
+        if (readers[i].file) fclose(readers[i].file);
+    }
+
+    return is_merged;
+}
+
+// runs are merged BOOK_BUILDER_MERGE_FAN_IN at a time into longer ones until the last pass can open them all at once
+static long long merge_runs(book_builder_t* builder, FILE* output)
+{
+    book_writer_t* writer = (book_writer_t*)calloc(1, sizeof(book_writer_t));
+    CHECK(writer, -1, "Couldn't allocate memory to merge book runs");
+
+    writer->output = output;
+    writer->min_games = builder->options.min_games;
+
+    int first = 0;
+    char is_merged = TRUE;
+
+    while (is_merged && builder->runs_count - first > BOOK_BUILDER_MERGE_FAN_IN)
+    {
+        // counted first, so that it's removed with the others whatever happens
+        const int index = builder->runs_count++;
+
+        char path[MAX_BUFFER_SIZE * 4];
+        get_run_path(builder, index, path, sizeof(path));
+
+        FILE* run = fopen(path, "wb");
+        is_merged = run && merge_range(builder, first, first + BOOK_BUILDER_MERGE_FAN_IN, run, NULL);
+        if (run && fclose(run)) is_merged = FALSE;
+        if (!is_merged) SDL_Log("Couldn't merge book runs into %s", path);
+
+        for (int i = first; i != first + BOOK_BUILDER_MERGE_FAN_IN; ++i) remove_run(builder, i);
+        first += BOOK_BUILDER_MERGE_FAN_IN;
+    }
+
+    if (is_merged && !merge_range(builder, first, builder->runs_count, NULL, writer))
+    {
+        SDL_Log("Couldn't merge book runs into %s", builder->options.output_path);
+        is_merged = FALSE;
+    }
+
+    const long long entries = is_merged ? writer->entries : -1;
+    free(writer);
+
+    return entries;
+}
+
+static void remove_runs(const book_builder_t* builder)
+{
+    for (int i = 0; i != builder->runs_count; ++i) remove_run(builder, i);
+}
+
+#pragma endregion
+
+static char parse_options(book_builder_options_t* options, int argc, char** argv)
+{
+    SDL_memset(options, 0, sizeof(book_builder_options_t));
+    options->threads = SDL_GetCPUCount();
+    options->max_plies = BOOK_BUILDER_DEFAULT_MAX_PLIES;
+    options->min_games = BOOK_BUILDER_DEFAULT_MIN_GAMES;
+    options->memory_mb = BOOK_BUILDER_DEFAULT_MEMORY_MB;
+
+    options->input_paths = (char**)calloc(argc, sizeof(char*));
+    if (!options->input_paths) return FALSE;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--build-book") && value) options->output_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--threads") && value) options->threads = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--max-plies") && value) options->max_plies = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--min-games") && value) options->min_games = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--memory") && value) options->memory_mb = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--book-keys") && value) options->keys_path = argv[++i];
+        else if (argv[i][0] != '-') options->input_paths[options->inputs_count++] = argv[i];
+        else
+        {
+            fprintf(stderr, "Unknown book builder option: %s\n", argv[i]);
+            return FALSE;
+        }
+    }
+
+    options->threads = SDL_max(1, options->threads);
+    options->min_games = SDL_max(1, options->min_games);
+
+    return options->output_path && options->inputs_count > 0 && options->memory_mb > 0;
+}
+
+int book_builder_main(int argc, char** argv)
+{
+    book_builder_t builder;
+    SDL_memset(&builder, 0, sizeof(book_builder_t));
+
+    if (!parse_options(&builder.options, argc, argv))
+    {
+        fprintf(stderr, "usage: chess --build-book <output.bin> <games.pgn>... [--threads n] [--max-plies n] [--min-games n] [--memory mb] [--book-keys file]\n");
+        free(builder.options.input_paths);
+        return 1;
+    }
+
+    const book_builder_options_t* options = &builder.options;
+
+    position_init();
+    if (!book_load_keys(&builder.book, options->keys_path)) return 1;
+
+    builder.inputs = (mapped_file_t*)calloc(options->inputs_count, sizeof(mapped_file_t));
+    CHECK(builder.inputs, 1, "Couldn't allocate book builder inputs");
+
+    // inputs are mapped, not read: the os pages them in and out, whatever their size
+    for (int i = 0; i != options->inputs_count; ++i)
+    {
+        if (!mapped_file_open(&builder.inputs[i], options->input_paths[i])) SDL_Log("Couldn't map %s, skipping it", options->input_paths[i]);
+        builder.chunks_count += (int)((builder.inputs[i].size + BOOK_BUILDER_CHUNK_SIZE - 1) / BOOK_BUILDER_CHUNK_SIZE);
+    }
+
+    const int threads_count = SDL_max(1, SDL_min(options->threads, builder.chunks_count));
+    builder.records_per_worker = SDL_max((size_t)1024, (size_t)options->memory_mb * 1024 * 1024 / threads_count / sizeof(book_record_t));
+    builder.lock = SDL_CreateMutex();
+
+    const Uint64 start_counter = SDL_GetPerformanceCounter();
+
+    SDL_Thread** threads = (SDL_Thread**)calloc(threads_count, sizeof(SDL_Thread*));
+    for (int i = 0; i != threads_count; ++i) threads[i] = SDL_CreateThread(book_worker_run, "book", &builder);
+    for (int i = 0; i != threads_count; ++i) SDL_WaitThread(threads[i], NULL);
+
+    const int runs_count = builder.runs_count; // before the merge passes add theirs
+    long long entries = -1;
+    FILE* output = builder.is_failed ? NULL : fopen(options->output_path, "wb");
+
+    if (output)
+    {
+        entries = merge_runs(&builder, output);
+        fclose(output);
+
+        // a book missing some of the games is worse than none
+        if (entries < 0) remove(options->output_path);
+    } else if (!builder.is_failed)
+    {
+        SDL_Log("Couldn't open book output file %s", options->output_path);
+    }
+
+    remove_runs(&builder);
+
+    const double seconds = (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency();
+
+    printf("book: %lli games (%lli skipped), %lli positions, %i runs, %lli entries in %.2fs on %i threads -> %s\n", builder.games, builder.skipped_games, builder.positions, runs_count, entries, seconds,
+           threads_count, options->output_path);
+
+    free(threads);
+    SDL_DestroyMutex(builder.lock);
+    for (int i = 0; i != options->inputs_count; ++i) mapped_file_close(&builder.inputs[i]);
+    free(builder.inputs);
+    free(builder.options.input_paths);
+
+    return entries >= 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include <bundle.h>
+#include <mapped_file.h>
+#include <private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+typedef struct bundle {
+    mapped_file_t file;
+    const unsigned char* base;
+    size_t size;
+    const bundle_header_t* header;
+    const bundle_entry_t* entries;
+} bundle_t;
+
+static bundle_t bundle;
+
+static void unmap_file()
+{
+    mapped_file_close(&bundle.file);
+    SDL_memset(&bundle, 0, sizeof(bundle_t));
+}
+
+char bundle_open(const char* path)
+{
+    if (!mapped_file_open(&bundle.file, path))
+    {
+        SDL_Log("No asset bundle at %s, assets will be decoded from their source files", path);
+        return FALSE;
+    }
+
+    const size_t size = bundle.file.size;
+    bundle.base = bundle.file.data;
+    bundle.size = size;
+    bundle.header = (const bundle_header_t*)bundle.base;
+    bundle.entries = (const bundle_entry_t*)(bundle.base + sizeof(bundle_header_t));
+
+    const char is_valid = size >= sizeof(bundle_header_t) && bundle.header->magic == BUNDLE_MAGIC && bundle.header->version == BUNDLE_VERSION &&
+                          size >= sizeof(bundle_header_t) + bundle.header->entry_count * sizeof(bundle_entry_t);
+
+    if (!is_valid)
+    {
+        SDL_Log("Asset bundle %s is invalid or out of date, ignoring it", path);
+        unmap_file();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static int compare_entry_name(const void* key, const void* entry) { return SDL_strncmp((const char*)key, ((const bundle_entry_t*)entry)->name, BUNDLE_NAME_SZ); }
+
+const bundle_entry_t* bundle_find(const char* asset_path, bundle_asset_type_t type)
+{
+    if (!bundle.header) return NULL;
+
+    // runtime paths look like "../assets/textures/rook_w.comp", the bundle only knows the part after "assets/"
+    const char* name = asset_path;
+    for (const char* found = SDL_strstr(name, "assets/"); found; found = SDL_strstr(found + 1, "assets/"))
+    {
+        name = found + SDL_strlen("assets/");
+    }
+
+    const bundle_entry_t* entry = (const bundle_entry_t*)bsearch(name, bundle.entries, bundle.header->entry_count, sizeof(bundle_entry_t), compare_entry_name);
+
+    if (!entry || entry->type != (uint32_t)type || (size_t)entry->offset + entry->size > bundle.size) return NULL;
+
+    return entry;
+}
+
+const void* bundle_data(const bundle_entry_t* entry) { return bundle.base + entry->offset; }
+
+void bundle_close() { unmap_file(); }
@@ -1,7 +1,9 @@
 #include <board.h>
 #include <cell.h>
 #include <chess_piece.h>
+#include <eval.h>
 #include <game.h>
+#include <perf_hud.h>
 #include <player.h>
 #include <texture.h>
 
@@ -11,8 +13,6 @@
 
 #include <sglib.h>
 
-extern texture_pool_t texture_pool;
-
 const char *white_png_postfix = "_w.comp";
 const char *black_png_postfix = "_b.comp";
 
@@ -28,7 +28,11 @@ const char *assets[7] = {
     "../assets/textures/pawn",
 };
 
-static texture_t *get_chess_texture(piece_type_t type, char is_white, const char use_blending)
+// every piece image is decoded and uploaded once, pieces only own a texture_t pointing to the shared SDL texture.
+// textures without blending are kept apart because the promotion menu color mods them.
+static texture_t *chess_textures[2][2][PAWN + 1];
+
+static texture_t *load_chess_texture(piece_type_t type, char is_white, const char use_blending)
 {
     texture_t *result = NULL;
 
@@ -40,6 +44,7 @@ static texture_t *get_chess_texture(piece_type_t type, char is_white, const char
 
     // need another buffer to store the concatenation result
     char *path = (char *)malloc(total_buf_len);
+    perf_count(perf_allocations);
     strcpy_s(path, total_buf_len, value);
     strcat_s(path, total_buf_len, is_white ? white_png_postfix : black_png_postfix);
     // path[total_buf_len] = '\0';
@@ -51,6 +56,19 @@ static texture_t *get_chess_texture(piece_type_t type, char is_white, const char
     return result;
 }
 
+static texture_t *get_chess_texture(piece_type_t type, char is_white, const char use_blending)
+{
+    texture_t **shared = &chess_textures[use_blending ? 1 : 0][is_white ? 1 : 0][(int)type];
+
+    if (!*shared)
+    {
+        *shared = load_chess_texture(type, is_white, use_blending);
+        CHECK(*shared, NULL, "Couldn't load chess piece texture");
+    }
+
+    return *shared;
+}
+
 static void _draw_piece(struct chess_piece *piece) { piece->chess_texture->render(piece->chess_texture, 0, NULL); }
 
 static void _set_position(struct chess_piece *piece, int x, int y)
@@ -60,21 +78,6 @@ static void _set_position(struct chess_piece *piece, int x, int y)
     piece->chess_texture->set_position(piece->chess_texture, x, y);
 }
 
-piece_move_t *piece_move_new()
-{
-    piece_move_t *move = (piece_move_t *)calloc(1, sizeof(piece_move_t));
-    move->markers = &SGLIB_QUEUE_FIRST_ELEMENT(texture_t, texture_pool.textures, texture_pool.i, texture_pool.j); // get texture from queue without allocating anything
-    SGLIB_QUEUE_DELETE_FIRST(texture_t *, texture_pool.textures, texture_pool.i, texture_pool.j, TEXTURE_POOL_SIZE);
-    return move;
-}
-
-void piece_move_destroy(piece_move_t *move)
-{
-    cell_destroy(move->possible_cells);
-    texture_destroy(move->markers);
-    free(move);
-}
-
 static int get_cell_index_by_piece_position(chess_piece_t *piece, int x_offset, int y_offset) { return (((piece->pos_y / CELL_SZ) * CELLS_PER_ROW) + (piece->pos_x / CELL_SZ) + x_offset) + (y_offset * CELLS_PER_ROW); }
 
 static char is_cell_occupied_by_friendly_piece(cell_t *cell, chess_piece_t *piece) { return (cell->is_occupied && cell->entity->piece_data.is_white == piece->piece_data.is_white); }
@@ -113,15 +116,12 @@ static char allocate_legal_moves(chess_piece_t *piece, board_t *board, char simu
             memset(&piece->moves[i], 0, sizeof(piece_move_t));
         }
 
-        // in this case we also allocate memory for possible moves that include markers which are textures.
+        // in this case we also keep the destination cells, the game draws its markers from them.
         for (unsigned long i = 0ul; i != piece->moves_number; ++i)
         {
             const int index = SGLIB_QUEUE_FIRST_ELEMENT(int, piece->index_queue.index_array, piece->index_queue.i, piece->index_queue.j);
 
-            piece_move_t move = *piece_move_new();
-            move.possible_cells = board->cells[index];
-            move.markers->set_position(move.markers, move.possible_cells->pos_x, move.possible_cells->pos_y);
-            piece->moves[i] = move;
+            piece->moves[i].possible_cells = board->cells[index];
 
             SGLIB_QUEUE_DELETE(int, piece->index_queue.index_array, piece->index_queue.i, piece->index_queue.j, MAX_QUEUE_SIZE);
         }
@@ -954,10 +954,9 @@ char _check_checkmate(board_t *board, struct chess_piece *piece, cell_t *destina
     return result;
 }
 
-chess_piece_t *chess_piece_new(piece_type_t type, char is_white, const char use_blending)
+void chess_piece_init(chess_piece_t *piece, piece_type_t type, char is_white, const char use_blending)
 {
-    chess_piece_t *piece = (chess_piece_t *)calloc(1, sizeof(chess_piece_t));
-    CHECK(piece, NULL, "Couldn't allocate memory for chess_piece_t");
+    SDL_memset(piece, 0, sizeof(chess_piece_t));
 
     piece->piece_type = type;
     piece->draw = _draw_piece;
@@ -966,23 +965,71 @@ chess_piece_t *chess_piece_new(piece_type_t type, char is_white, const char use_
     piece->check_checkmate = _check_checkmate;
     piece->piece_data.is_white = is_white;
     piece->piece_data.is_first_move = TRUE;
-    piece->chess_texture = get_chess_texture(type, is_white, use_blending);
 
-    // Setup score values for pieces
+    texture_t *shared_texture = get_chess_texture(type, is_white, use_blending);
+    if (shared_texture) piece->texture_instance = *shared_texture;
+    piece->chess_texture = &piece->texture_instance;
+
+    // Setup score values for pieces: the engine's default material rounded to pawns, 5 3 3 9 and 1 until it gets retuned
     switch (type)
     {
-    case rook: piece->score_value = 5; break;
-    case knight:
-    case bishop: piece->score_value = 3; break;
-    case queen: piece->score_value = 9; break;
     case king: piece->score_value = UINT_MAX; break;
-    case pawn: piece->score_value = 1; break;
-    default: break;
+    case none: break;
+    default: piece->score_value = (default_eval_params.material[type] + 50) / 100; break;
+    }
+}
+
+chess_piece_t *chess_piece_new(arena_t *arena, piece_type_t type, char is_white, const char use_blending)
+{
+    chess_piece_t *piece = (chess_piece_t *)arena_alloc(arena, sizeof(chess_piece_t));
+    CHECK(piece, NULL, "Couldn't allocate memory for chess_piece_t");
+
+    chess_piece_init(piece, type, is_white, use_blending);
+
+    return piece;
+}
+
+void chess_piece_pool_new(chess_piece_pool_t *pool, arena_t *arena)
+{
+    SDL_memset(pool, 0, sizeof(chess_piece_pool_t));
+
+    pool->slots = (chess_piece_t *)arena_alloc(arena, sizeof(chess_piece_t) * PIECE_POOL_SIZE);
+    if (!pool->slots)
+    {
+        SDL_Log("Couldn't allocate memory for chess piece pool");
+        return;
     }
 
+    chess_piece_pool_reset(pool);
+}
+
+chess_piece_t *chess_piece_pool_acquire(chess_piece_pool_t *pool, piece_type_t type, char is_white, const char use_blending)
+{
+    CHECK(pool->free_count, NULL, "Chess piece pool is empty");
+
+    chess_piece_t *piece = pool->free_pieces[--pool->free_count];
+    chess_piece_init(piece, type, is_white, use_blending);
+
     return piece;
 }
 
+void chess_piece_pool_release(chess_piece_pool_t *pool, chess_piece_t *piece)
+{
+    if (!piece || pool->free_count == PIECE_POOL_SIZE) return;
+
+    pool->free_pieces[pool->free_count++] = piece;
+}
+
+void chess_piece_pool_reset(chess_piece_pool_t *pool)
+{
+    // hand slots out in board order, it doesn't matter but makes debugging easier
+    pool->free_count = 0;
+    for (int i = PIECE_POOL_SIZE - 1; i >= 0; --i)
+    {
+        pool->free_pieces[pool->free_count++] = &pool->slots[i];
+    }
+}
+
 void chess_piece_set_entity_cell(board_t *board, chess_piece_t *piece, int index)
 {
     if (CHECK_IDX_RANGE(index))
@@ -1015,11 +1062,15 @@ char chess_piece_is_near_left_bound(chess_piece_t *piece) { return piece != NULL
 
 char chess_piece_is_near_right_bound(chess_piece_t *piece) { return piece != NULL && piece->pos_x == (SCREEN_W - CELL_SZ); }
 
-void chess_piece_destroy(chess_piece_t *piece)
+void chess_piece_release_textures()
 {
-    texture_destroy(piece->chess_texture);
+    texture_t **textures = &chess_textures[0][0][0];
 
-    free(piece);
+    for (unsigned long i = 0ul; i != sizeof(chess_textures) / sizeof(texture_t *); ++i)
+    {
+        texture_destroy(textures[i]);
+        textures[i] = NULL;
+    }
 }
 
 const char *chess_piece_to_string(chess_piece_t *piece)
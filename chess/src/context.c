@@ -1,5 +1,8 @@
+#include <bundle.h>
 #include <context.h>
+#include <input.h>
 #include <private.h>
+#include <startup_profiler.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,11 +22,15 @@ window_t *window_new(unsigned int width, unsigned int height, const char *title)
     window_t *win = (window_t *)calloc(1, sizeof(window_t));
     CHECK(win, NULL, "Couldn't allocate memory for window struct");
 
+    startup_profiler_begin("SDL_Init");
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
     {
         SDL_Log("Couldn't initialize SDL: [%s]", SDL_GetError());
         return NULL;
     }
+    startup_profiler_end();
+
+    startup_profiler_begin("SDL_CreateWindow");
 
     win->sdl_window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, 0x0);
     if (!win->sdl_window)
@@ -31,27 +38,47 @@ window_t *window_new(unsigned int width, unsigned int height, const char *title)
         SDL_Log("Couldn't initialize SDL window: [%s]", SDL_GetError());
         return NULL;
     }
+    startup_profiler_end();
+
+    startup_profiler_begin("window icon");
+
+    SDL_Surface *window_icon = NULL;
+
+    // the icon pixels are taken straight from the mapped bundle when it is available
+    const bundle_entry_t *icon_entry = bundle_find("../assets/textures/chess.comp", bundle_texture);
+    if (icon_entry)
+    {
+        window_icon = SDL_CreateRGBSurfaceWithFormatFrom((void *)bundle_data(icon_entry), icon_entry->width, icon_entry->height, 32, icon_entry->width * 4, SDL_PIXELFORMAT_RGBA32);
+    } else
+    {
+        window_icon = IMG_Load("../assets/textures/chess.comp");
+    }
 
-    SDL_Surface *window_icon = IMG_Load("../assets/textures/chess.comp");
     if (!window_icon)
     {
         SDL_Log("Couldn't load window icon: [%s]", SDL_GetError());
     }
     SDL_SetWindowIcon((SDL_Window *)win->sdl_window, window_icon);
+    SDL_FreeSurface(window_icon);
+    startup_profiler_end();
 
     win->width = width;
     win->height = height;
 
+    startup_profiler_begin("TTF_Init");
     if (TTF_Init() != 0)
     {
         SDL_Log("Couldn't initialize TTF Engine: [%s]", SDL_GetError());
         return NULL;
     }
+    startup_profiler_end();
 
-    if (Mix_OpenAudio(44000, AUDIO_S32LSB, 2, 4096) != 0)
+    startup_profiler_begin("Mix_OpenAudio");
+    if (Mix_OpenAudio(AUDIO_FREQUENCY, AUDIO_SAMPLE_FORMAT, AUDIO_CHANNELS, AUDIO_CHUNK_SIZE) != 0)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't init SDL_Mixer: %s", Mix_GetError());
     }
+    startup_profiler_end();
 
     return win;
 }
@@ -62,13 +89,16 @@ renderer_t *renderer_new(window_t *window)
     CHECK(rend, NULL, "Couldn't allocate memory for renderer struct");
 
     rend->sdl_renderer = SDL_CreateRenderer((SDL_Window *)window->sdl_window, -1, SDL_RENDERER_ACCELERATED);
+
+    // the dummy video driver used for headless replays only has the software renderer
+    if (!rend->sdl_renderer) rend->sdl_renderer = SDL_CreateRenderer((SDL_Window *)window->sdl_window, -1, SDL_RENDERER_SOFTWARE);
     if (!rend->sdl_renderer)
     {
         SDL_Log("Couldn't initialize SDL renderer: [%s]", SDL_GetError());
         return NULL;
     }
 
-    start = SDL_GetPerformanceFrequency();
+    end = SDL_GetPerformanceCounter();
     rend->is_running = 1;
 
     return rend;
@@ -86,6 +116,9 @@ void renderer_update_events_and_delta_time(window_t *window, renderer_t *rendere
         }
     }
 
+    // mouse and keyboard are read once per frame, from the devices or from a replay
+    if (!input_update()) renderer->is_running = 0;
+
     // clear screen and add alpha blending
     SDL_SetRenderDrawBlendMode((SDL_Renderer *)renderer->sdl_renderer, SDL_BLENDMODE_BLEND);
     SDL_SetRenderDrawColor((SDL_Renderer *)renderer->sdl_renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
@@ -96,7 +129,7 @@ void renderer_update_events_and_delta_time(window_t *window, renderer_t *rendere
     end = SDL_GetPerformanceCounter();
     window->delta_time = (float)(((end - start) * 1000) / (float)SDL_GetPerformanceFrequency());
 
-    window->keys = (Uint8 *)SDL_GetKeyboardState(NULL);
+    window->keys = (Uint8 *)input_get_keys();
 }
 
 void renderer_present(renderer_t *renderer) { SDL_RenderPresent((SDL_Renderer *)renderer->sdl_renderer); }
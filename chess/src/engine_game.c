@@ -0,0 +1,129 @@
+#include <engine_game.h>
+
+#include <stdio.h>
+
+// small per game generator, games are reproducible whatever thread plays them
+static unsigned long long next_random(unsigned long long* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+char engine_config_parse(engine_config_t* config, const char* spec)
+{
+    SDL_memset(config, 0, sizeof(engine_config_t));
+    config->params = default_eval_params;
+
+    char buffer[MAX_BUFFER_SIZE * 4];
+    SDL_strlcpy(buffer, spec ? spec : "", sizeof(buffer));
+
+    for (char* option = buffer; option && *option;)
+    {
+        char* next = SDL_strchr(option, ',');
+        if (next) *next++ = '\0';
+
+        char* value = SDL_strchr(option, '=');
+        if (!value)
+        {
+            fprintf(stderr, "Engine option without value: %s\n", option);
+            return FALSE;
+        }
+        *value++ = '\0';
+
+        if (!SDL_strcmp(option, "name")) SDL_strlcpy(config->name, value, sizeof(config->name));
+        else if (!SDL_strcmp(option, "depth")) config->limits.depth = SDL_atoi(value);
+        else if (!SDL_strcmp(option, "nodes")) config->limits.nodes = SDL_strtoull(value, NULL, 10);
+        else if (!SDL_strcmp(option, "time")) config->limits.time_ms = (unsigned)SDL_atoi(value);
+        else if (!SDL_strcmp(option, "eval"))
+        {
+            if (!eval_params_load(&config->params, value)) return FALSE;
+        } else
+        {
+            fprintf(stderr, "Unknown engine option: %s\n", option);
+            return FALSE;
+        }
+
+        option = next;
+    }
+
+    if (!config->name[0]) SDL_strlcpy(config->name, "chess", sizeof(config->name));
+
+    return TRUE;
+}
+
+char engine_game_play(pgn_game_t* game, const position_t* start, search_t* searches[MAX_PLAYERS], const search_limits_t* limits[MAX_PLAYERS], const engine_game_options_t* options)
+{
+    position_t position = *start;
+    pgn_game_new(game, &position);
+
+    // a new game for both engines, the same search may play both sides
+    search_clear(searches[0]);
+    if (searches[1] != searches[0]) search_clear(searches[1]);
+
+    unsigned long long hashes[MAX_GAME_PLIES + 1];
+    int hashes_count = 0;
+    hashes[hashes_count++] = position.hash;
+
+    unsigned long long random_state = options->seed | 1ull;
+    char is_in_book = options->book != NULL;
+
+    for (ever)
+    {
+        if (options->stop && SDL_AtomicGet(options->stop)) return FALSE;
+
+        const char* reason = NULL;
+        game->outcome = position_get_outcome(&position, hashes, hashes_count, &reason);
+
+        if (game->outcome != outcome_none)
+        {
+            SDL_strlcpy(game->termination, reason, sizeof(game->termination));
+            return TRUE;
+        }
+
+        int wdl = 0, dtm = 0;
+        if (options->tablebases && tablebases_probe(options->tablebases, &position, &wdl, &dtm))
+        {
+            if (!wdl) game->outcome = outcome_draw;
+            else game->outcome = ((wdl > 0) == position.is_white_to_move) ? outcome_white_wins : outcome_black_wins;
+
+            SDL_strlcpy(game->termination, "tablebase", sizeof(game->termination));
+            return TRUE;
+        }
+
+        if (game->moves_count >= options->max_plies || game->moves_count >= MAX_GAME_PLIES)
+        {
+            game->outcome = outcome_draw;
+            SDL_strlcpy(game->termination, "adjudication", sizeof(game->termination));
+            return TRUE;
+        }
+
+        move_t move;
+        if (game->moves_count < options->random_plies)
+        {
+            move_t moves[MAX_MOVES];
+            const int count = position_generate_moves(&position, moves, FALSE);
+            move = moves[next_random(&random_state) % count];
+        } else if (is_in_book && book_pick_move(options->book, &position, options->book_selection, next_random(&random_state), &move))
+        {
+            // answered instantly, the search isn't even told about the position
+        } else
+        {
+            is_in_book = FALSE;
+
+            const int side = position.is_white_to_move ? 1 : 0;
+
+            search_result_t result;
+            searches[side]->stop = options->stop;
+            search_set_position(searches[side], &position, hashes, hashes_count);
+            search_run(searches[side], limits[side], &result);
+            move = result.best_move;
+        }
+
+        undo_t undo;
+        position_make_move(&position, move, &undo);
+        game->moves[game->moves_count++] = move;
+        hashes[hashes_count++] = position.hash;
+    }
+}
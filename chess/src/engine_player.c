@@ -0,0 +1,218 @@
+#include <engine_player.h>
+
+#include <stdlib.h>
+
+// while pondering no clock runs for this search, the time manager only decides once it's a real one
+static char on_iteration(const search_result_t* results, int lines, void* data)
+{
+    engine_player_t* engine = (engine_player_t*)data;
+
+    if (!engine->is_timed || SDL_AtomicGet(&engine->ponder)) return TRUE;
+    return time_manager_should_continue(&engine->time_manager, &results[0]);
+}
+
+static int engine_worker(void* data)
+{
+    engine_player_t* engine = (engine_player_t*)data;
+
+    engine_job_t* job = (engine_job_t*)malloc(sizeof(engine_job_t));
+    CHECK(job, 0, "Couldn't allocate memory for engine job");
+
+    for (ever)
+    {
+        SDL_LockMutex(engine->lock);
+        while (!engine->has_pending && !engine->is_quitting) SDL_CondWait(engine->changed, engine->lock);
+
+        if (engine->is_quitting)
+        {
+            SDL_UnlockMutex(engine->lock);
+            break;
+        }
+
+        *job = engine->pending;
+        const char is_new_game = engine->is_new_game;
+        engine->is_new_game = FALSE;
+        engine->has_pending = FALSE;
+        engine->is_busy = TRUE;
+        engine->current_hash = job->position.hash;
+        engine->is_current_ponder = job->is_ponder;
+        SDL_AtomicSet(&engine->stop, FALSE);
+        SDL_AtomicSet(&engine->ponder, job->is_ponder);
+        SDL_UnlockMutex(engine->lock);
+
+        search_result_t result;
+        SDL_memset(&result, 0, sizeof(search_result_t));
+        // the clock only sets the hard limit, the time manager usually stops the search well before it
+        search_limits_t limits = engine->limits;
+        engine->is_timed = job->has_clock;
+        if (job->has_clock)
+        {
+            time_manager_start(&engine->time_manager, &job->clock, &job->position);
+            limits.time_ms = (unsigned)SDL_max(engine->time_manager.maximum_ms, 1.0);
+        }
+
+        // the transposition table outlives the jobs: a ponder miss or the next move starts from what the
+        // aborted search already stored, only a new game forgets it
+        if (is_new_game) search_clear(engine->search);
+        search_set_position(engine->search, &job->position, job->hashes, job->hashes_count);
+        search_run(engine->search, &limits, &result);
+
+        // a search stopped from outside was a ponder miss or a position nobody waits for anymore
+        SDL_LockMutex(engine->lock);
+        engine->is_busy = FALSE;
+        if (!SDL_AtomicGet(&engine->stop))
+        {
+            engine->result = result;
+            engine->result_hash = engine->current_hash;
+            engine->is_result_ponder = engine->is_current_ponder;
+            engine->has_result = TRUE;
+        }
+        SDL_UnlockMutex(engine->lock);
+    }
+
+    free(job);
+    return 0;
+}
+
+char engine_player_new(engine_player_t* engine, const eval_params_t* params, const search_limits_t* limits)
+{
+    SDL_memset(engine, 0, sizeof(engine_player_t));
+
+    engine->search = (search_t*)malloc(sizeof(search_t));
+    CHECK(engine->search, FALSE, "Couldn't allocate memory for engine search");
+
+    search_new(engine->search, params);
+    engine->search->stop = &engine->stop;
+    engine->search->ponder = &engine->ponder;
+    engine->search->on_iteration = on_iteration;
+    engine->search->callback_data = engine;
+    engine->limits = *limits;
+
+    engine->lock = SDL_CreateMutex();
+    engine->changed = SDL_CreateCond();
+    engine->thread = SDL_CreateThread(engine_worker, "engine", engine);
+
+    if (!engine->lock || !engine->changed || !engine->thread)
+    {
+        SDL_Log("Couldn't start engine thread: [%s]", SDL_GetError());
+        engine_player_destroy(engine);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// the lock must be held, the search running is aborted in favor of the new job
+static void post_job(engine_player_t* engine, const position_t* position, const unsigned long long* hashes, int hashes_count, const time_control_t* clock, char is_ponder)
+{
+    engine_job_t* job = &engine->pending;
+    job->position = *position;
+    job->hashes_count = SDL_min(hashes_count, MAX_GAME_PLIES);
+    SDL_memcpy(job->hashes, hashes + hashes_count - job->hashes_count, sizeof(unsigned long long) * job->hashes_count);
+    job->is_ponder = is_ponder;
+    job->has_clock = clock != NULL;
+    if (clock) job->clock = *clock;
+
+    engine->has_pending = TRUE;
+    if (engine->is_busy) SDL_AtomicSet(&engine->stop, TRUE);
+    SDL_CondSignal(engine->changed);
+}
+
+char engine_player_think(engine_player_t* engine, const position_t* position, const unsigned long long* hashes, int hashes_count, const time_control_t* clock, move_t* move)
+{
+    if (!engine->thread) return FALSE;
+
+    SDL_LockMutex(engine->lock);
+
+    // a ponder search that ended on its own before the hit is as good as a normal one
+    const char is_found = engine->has_result && engine->result_hash == position->hash;
+    if (is_found)
+    {
+        *move = engine->result.best_move;
+        engine->has_result = FALSE;
+        engine->predicted_move = (engine->result.pv_length > 1) ? engine->result.pv[1] : (move_t){0};
+    } else if (engine->is_busy && engine->current_hash == position->hash)
+    {
+        // ponder hit: the same search goes on, now with limits
+        if (engine->is_current_ponder) SDL_AtomicSet(&engine->ponder, FALSE);
+        engine->is_current_ponder = FALSE;
+    } else if (!engine->has_pending || engine->pending.position.hash != position->hash || engine->pending.is_ponder)
+    {
+        post_job(engine, position, hashes, hashes_count, clock, FALSE);
+    }
+
+    SDL_UnlockMutex(engine->lock);
+
+    if (is_found)
+    {
+        // the next ponder starts from the position this move leads to
+        position_t next = *position;
+        undo_t undo;
+        position_make_move(&next, *move, &undo);
+        engine->predicted_hash = next.hash;
+    }
+
+    return is_found;
+}
+
+void engine_player_ponder(engine_player_t* engine, const position_t* position, const unsigned long long* hashes, int hashes_count, const time_control_t* clock)
+{
+    if (!engine->thread) return;
+
+    const char has_prediction = engine->predicted_hash == position->hash && engine->predicted_move.from != engine->predicted_move.to;
+    position_t next = *position;
+    if (has_prediction)
+    {
+        undo_t undo;
+        position_make_move(&next, engine->predicted_move, &undo);
+    }
+
+    SDL_LockMutex(engine->lock);
+
+    if (!has_prediction)
+    {
+        // nothing worth searching, don't keep a core busy for a position that's gone
+        engine->has_pending = FALSE;
+        if (engine->is_busy) SDL_AtomicSet(&engine->stop, TRUE);
+    } else if (!(engine->is_busy && engine->current_hash == next.hash) && !(engine->has_pending && engine->pending.position.hash == next.hash) &&
+               !(engine->has_result && engine->result_hash == next.hash))
+    {
+        post_job(engine, &next, hashes, hashes_count, clock, TRUE);
+    }
+
+    SDL_UnlockMutex(engine->lock);
+}
+
+void engine_player_new_game(engine_player_t* engine)
+{
+    if (!engine->thread) return;
+
+    SDL_LockMutex(engine->lock);
+    engine->is_new_game = TRUE;
+    engine->has_pending = FALSE;
+    engine->has_result = FALSE;
+    if (engine->is_busy) SDL_AtomicSet(&engine->stop, TRUE);
+    SDL_UnlockMutex(engine->lock);
+
+    engine->predicted_move = (move_t){0};
+    engine->predicted_hash = 0;
+}
+
+void engine_player_destroy(engine_player_t* engine)
+{
+    if (engine->thread)
+    {
+        SDL_LockMutex(engine->lock);
+        engine->is_quitting = TRUE;
+        SDL_AtomicSet(&engine->stop, TRUE);
+        SDL_CondSignal(engine->changed);
+        SDL_UnlockMutex(engine->lock);
+
+        SDL_WaitThread(engine->thread, NULL);
+    }
+
+    if (engine->changed) SDL_DestroyCond(engine->changed);
+    if (engine->lock) SDL_DestroyMutex(engine->lock);
+    free(engine->search);
+    SDL_memset(engine, 0, sizeof(engine_player_t));
+}
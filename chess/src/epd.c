@@ -0,0 +1,360 @@
+#include <epd.h>
+
+#include <SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// solve rate is reported at each of these times, up to the time limit
+static const unsigned solve_times_ms[] = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000};
+
+typedef struct epd_suite {
+    epd_options_t options;
+    eval_params_t params;
+    epd_position_t* positions;
+    epd_result_t* results;
+    int count;
+    SDL_atomic_t next_position;
+    SDL_atomic_t done_count;
+} epd_suite_t;
+
+typedef struct epd_job {
+    const epd_position_t* epd;
+    epd_result_t* result;
+} epd_job_t;
+
+#pragma region Parsing
+// copies one operand, a quoted one can hold spaces and semicolons
+static const char* read_token(const char* text, char* token, int size)
+{
+    int length = 0;
+    while (*text == ' ' || *text == '\t') text++;
+
+    if (*text == '"')
+    {
+        for (++text; *text && *text != '"'; ++text) if (length != size - 1) token[length++] = *text;
+        if (*text == '"') text++;
+    } else
+    {
+        for (; *text && *text != ' ' && *text != '\t' && *text != ';' && *text != '\r' && *text != '\n'; ++text) if (length != size - 1) token[length++] = *text;
+    }
+
+    token[length] = '\0';
+    return text;
+}
+
+static void read_moves(const position_t* position, const char* operands, move_t* moves, int* count)
+{
+    char token[MAX_BUFFER_SIZE];
+
+    for (const char* c = read_token(operands, token, sizeof(token)); *token; c = read_token(c, token, sizeof(token)))
+    {
+        move_t move;
+        if (*count == EPD_MAX_MOVES) break;
+        if (position_parse_san(position, token, &move)) moves[(*count)++] = move;
+        else SDL_Log("Skipping invalid epd move: %s", token);
+    }
+}
+
+char epd_parse(const char* line, epd_position_t* epd)
+{
+    SDL_memset(epd, 0, sizeof(epd_position_t));
+
+    // the four fen fields, the clocks are replaced by operations
+    char fen[MAX_FEN_SIZE];
+    int length = 0;
+    int fields = 0;
+    const char* c = line;
+
+    while (*c == ' ' || *c == '\t') c++;
+    for (; *c && *c != '\r' && *c != '\n' && fields != 4; ++c)
+    {
+        if (*c == ' ' || *c == '\t')
+        {
+            fields++;
+            while (c[1] == ' ' || c[1] == '\t') c++;
+        }
+        if (fields != 4 && length != MAX_FEN_SIZE - 1) fen[length++] = (*c == '\t') ? ' ' : *c;
+    }
+    fen[length] = '\0';
+
+    if (fields < 3 || !position_from_fen(&epd->position, fen)) return FALSE;
+
+    // opcode operands; opcode operands; ...
+    while (*c && *c != '\r' && *c != '\n')
+    {
+        char opcode[MAX_BUFFER_SIZE];
+        c = read_token(c, opcode, sizeof(opcode));
+        if (!*opcode) break;
+
+        char operands[MAX_FEN_SIZE];
+        int operands_length = 0;
+        char is_quoted = FALSE;
+
+        for (; *c && *c != '\r' && *c != '\n' && (*c != ';' || is_quoted); ++c)
+        {
+            if (*c == '"') is_quoted = !is_quoted;
+            if (operands_length != MAX_FEN_SIZE - 1) operands[operands_length++] = *c;
+        }
+        operands[operands_length] = '\0';
+        if (*c == ';') c++;
+
+        if (!SDL_strcmp(opcode, "bm")) read_moves(&epd->position, operands, epd->best_moves, &epd->best_moves_count);
+        else if (!SDL_strcmp(opcode, "am")) read_moves(&epd->position, operands, epd->avoid_moves, &epd->avoid_moves_count);
+        else if (!SDL_strcmp(opcode, "id")) read_token(operands, epd->id, sizeof(epd->id));
+    }
+
+    return epd->best_moves_count || epd->avoid_moves_count;
+}
+
+char epd_is_solution(const epd_position_t* epd, move_t move)
+{
+    for (int i = 0; i != epd->avoid_moves_count; ++i) if (move_equals(move, epd->avoid_moves[i])) return FALSE;
+    if (!epd->best_moves_count) return TRUE;
+
+    for (int i = 0; i != epd->best_moves_count; ++i) if (move_equals(move, epd->best_moves[i])) return TRUE;
+    return FALSE;
+}
+
+static char load_suite(epd_suite_t* suite, const char* path)
+{
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(path, &size);
+    CHECK(text, FALSE, "Couldn't read epd file");
+
+    int lines = 1;
+    for (size_t i = 0; i != size; ++i) lines += (text[i] == '\n');
+
+    suite->positions = (epd_position_t*)calloc(lines, sizeof(epd_position_t));
+    suite->results = (epd_result_t*)calloc(lines, sizeof(epd_result_t));
+    if (!suite->positions || !suite->results)
+    {
+        SDL_free(text);
+        return FALSE;
+    }
+
+    int line_number = 0;
+    for (char* line = text; line && *line;)
+    {
+        char* next = SDL_strchr(line, '\n');
+        if (next) *next++ = '\0';
+        line_number++;
+
+        while (*line == ' ' || *line == '\t') line++;
+
+        if (*line && *line != '#' && *line != '\r')
+        {
+            epd_position_t* epd = &suite->positions[suite->count];
+            if (epd_parse(line, epd))
+            {
+                if (!*epd->id) SDL_snprintf(epd->id, sizeof(epd->id), "line %i", line_number);
+                suite->count++;
+            } else
+            {
+                SDL_Log("Skipping invalid epd line %i: %s", line_number, line);
+            }
+        }
+
+        line = next;
+    }
+
+    SDL_free(text);
+    CHECK(suite->count, FALSE, "Epd file has no position with bm or am");
+
+    return TRUE;
+}
+#pragma endregion
+
+#pragma region Running
+// a solution counts from the iteration that found the move the search ends with
+static char on_iteration(const search_result_t* results, int lines, void* data)
+{
+    epd_job_t* job = (epd_job_t*)data;
+    const search_result_t* result = &results[0];
+
+    if (!epd_is_solution(job->epd, result->best_move))
+    {
+        job->result->is_solved = FALSE;
+        return TRUE;
+    }
+
+    if (job->result->is_solved) return TRUE;
+
+    job->result->is_solved = TRUE;
+    job->result->solution_time_ms = result->time_ms;
+    job->result->solution_nodes = result->nodes;
+    job->result->solution_depth = result->depth;
+    return TRUE;
+}
+
+static int epd_worker(void* data)
+{
+    epd_suite_t* suite = (epd_suite_t*)data;
+
+    search_t* search = (search_t*)malloc(sizeof(search_t));
+    CHECK(search, 0, "Couldn't allocate memory for epd worker");
+
+    search_new(search, &suite->params);
+    search->on_iteration = on_iteration;
+
+    for (ever)
+    {
+        const int index = SDL_AtomicAdd(&suite->next_position, 1);
+        if (index >= suite->count) break;
+
+        epd_job_t job = {&suite->positions[index], &suite->results[index]};
+        search->callback_data = &job;
+
+        // what the previous position left in the table would make results depend on the order workers take them
+        search_clear(search);
+        search_set_position(search, &job.epd->position, NULL, 0);
+        search_run(search, &suite->options.limits, &job.result->search);
+
+        // an aborted last iteration can still change the move the engine would play
+        job.result->is_solved = epd_is_solution(job.epd, job.result->search.best_move) && job.result->is_solved;
+
+        const int done = SDL_AtomicAdd(&suite->done_count, 1) + 1;
+        if (done % 10 == 0) fprintf(stderr, "epd: %i/%i positions\n", done, suite->count);
+    }
+
+    free(search);
+    return 0;
+}
+#pragma endregion
+
+#pragma region Report
+static void expected_to_string(const epd_position_t* epd, char* buffer, int size)
+{
+    const move_t* moves = epd->best_moves_count ? epd->best_moves : epd->avoid_moves;
+    const int count = epd->best_moves_count ? epd->best_moves_count : epd->avoid_moves_count;
+    int length = SDL_snprintf(buffer, size, "%s", epd->best_moves_count ? "" : "!");
+
+    for (int i = 0; i != count && length < size; ++i)
+    {
+        char san[MAX_BUFFER_SIZE];
+        position_move_to_san(&epd->position, moves[i], san);
+        length += SDL_snprintf(buffer + length, size - length, "%s%s", i ? "," : "", san);
+    }
+}
+
+static void print_report(const epd_suite_t* suite, double seconds)
+{
+    int solved = 0;
+    unsigned long long nodes = 0;
+    unsigned max_time_ms = 0;
+
+    FILE* csv = suite->options.csv_path ? fopen(suite->options.csv_path, "w") : NULL;
+    if (suite->options.csv_path && !csv) SDL_Log("Couldn't open epd csv file %s", suite->options.csv_path);
+    if (csv) fprintf(csv, "id,solved,move,expected,time_ms,nodes,depth\n");
+
+    for (int i = 0; i != suite->count; ++i)
+    {
+        const epd_position_t* epd = &suite->positions[i];
+        const epd_result_t* result = &suite->results[i];
+
+        char move[MAX_BUFFER_SIZE] = "-";
+        if (result->search.pv_length) position_move_to_san(&epd->position, result->search.best_move, move);
+
+        char expected[MAX_FEN_SIZE];
+        expected_to_string(epd, expected, sizeof(expected));
+
+        solved += result->is_solved;
+        nodes += result->search.nodes;
+        max_time_ms = SDL_max(max_time_ms, result->search.time_ms);
+
+        if (result->is_solved)
+        {
+            printf("%-20s solved %-8s %-16s %6ums %12llu nodes depth %i\n", epd->id, move, expected, result->solution_time_ms, result->solution_nodes, result->solution_depth);
+        } else
+        {
+            printf("%-20s failed %-8s %-16s\n", epd->id, move, expected);
+        }
+
+        if (csv) fprintf(csv, "\"%s\",%i,%s,%s,%u,%llu,%i\n", epd->id, result->is_solved ? 1 : 0, move, expected,
+            result->is_solved ? result->solution_time_ms : result->search.time_ms, result->is_solved ? result->solution_nodes : result->search.nodes,
+            result->is_solved ? result->solution_depth : result->search.depth);
+    }
+
+    if (csv) fclose(csv);
+
+    printf("\nsolved %i/%i (%.1f%%) in %.2fs, %llu nodes, %.0f nodes/s\n", solved, suite->count, 100.0 * solved / suite->count, seconds, nodes, nodes / SDL_max(seconds, 1e-9));
+
+    // how many a shorter time limit would have solved, to compare engine versions at a glance
+    printf("\n%10s %8s\n", "time", "solved");
+    for (int t = 0; t != (int)SDL_arraysize(solve_times_ms); ++t)
+    {
+        const unsigned time_ms = solve_times_ms[t];
+        if (t && solve_times_ms[t - 1] >= max_time_ms) break;
+
+        int count = 0;
+        for (int i = 0; i != suite->count; ++i) count += suite->results[i].is_solved && suite->results[i].solution_time_ms <= time_ms;
+
+        printf("%8ums %5i %5.1f%%\n", time_ms, count, 100.0 * count / suite->count);
+    }
+}
+#pragma endregion
+
+int epd_main(int argc, char** argv)
+{
+    epd_suite_t suite;
+    SDL_memset(&suite, 0, sizeof(epd_suite_t));
+    suite.options.threads = SDL_GetCPUCount();
+    suite.params = default_eval_params;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--epd") && value) suite.options.path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--time") && value) suite.options.limits.time_ms = (unsigned)SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--nodes") && value) suite.options.limits.nodes = SDL_strtoull(argv[++i], NULL, 10);
+        else if (!SDL_strcmp(argv[i], "--depth") && value) suite.options.limits.depth = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--threads") && value) suite.options.threads = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--eval") && value) suite.options.eval_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--csv") && value) suite.options.csv_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Unknown epd option: %s\n", argv[i]);
+            suite.options.path = NULL;
+            break;
+        }
+    }
+
+    if (!suite.options.path)
+    {
+        fprintf(stderr, "usage: chess --epd <suite.epd> [--time ms | --nodes n | --depth n] [--threads n] [--eval file] [--csv file]\n");
+        return 1;
+    }
+
+    search_limits_t* limits = &suite.options.limits;
+    if (!limits->time_ms && !limits->nodes && !limits->depth) limits->time_ms = EPD_DEFAULT_TIME_MS;
+
+    position_init();
+
+    if (suite.options.eval_path && !eval_params_load(&suite.params, suite.options.eval_path)) return 1;
+
+    if (!load_suite(&suite, suite.options.path))
+    {
+        free(suite.positions);
+        free(suite.results);
+        return 1;
+    }
+
+    // positions are independent, each worker takes the next one with its own search
+    const int threads_count = SDL_max(1, SDL_min(suite.options.threads, suite.count));
+    SDL_Thread** workers = (SDL_Thread**)calloc(threads_count, sizeof(SDL_Thread*));
+    CHECK(workers, 1, "Couldn't allocate epd workers");
+
+    const Uint64 start_counter = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i != threads_count; ++i) workers[i] = SDL_CreateThread(epd_worker, "epd", &suite);
+    for (int i = 0; i != threads_count; ++i) SDL_WaitThread(workers[i], NULL);
+
+    print_report(&suite, (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency());
+
+    free(workers);
+    free(suite.positions);
+    free(suite.results);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <eval.h>
+
+#include <SDL.h>
+
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct eval_param_entry {
+    const char* name;
+    size_t offset;
+    int count;
+} eval_param_entry_t;
+
+static const eval_param_entry_t param_entries[] = {
+    {"material", offsetof(eval_params_t, material), PAWN + 1},
+    {"rook", offsetof(eval_params_t, piece_square[rook]), BOARD_SZ},
+    {"knight", offsetof(eval_params_t, piece_square[knight]), BOARD_SZ},
+    {"bishop", offsetof(eval_params_t, piece_square[bishop]), BOARD_SZ},
+    {"queen", offsetof(eval_params_t, piece_square[queen]), BOARD_SZ},
+    {"king", offsetof(eval_params_t, piece_square[king]), BOARD_SZ},
+    {"pawn", offsetof(eval_params_t, piece_square[pawn]), BOARD_SZ},
+    {"bishop_pair", offsetof(eval_params_t, bishop_pair), 1},
+    {"tempo", offsetof(eval_params_t, tempo), 1},
+};
+
+// material and tables from the "simplified evaluation function", indexed like piece_type_t
+const eval_params_t default_eval_params = {
+    .material = {0, 500, 320, 330, 900, 0, 100},
+    .piece_square =
+        {
+            {0},
+            // rook
+            {
+                0, 0, 0, 0, 0, 0, 0, 0,         //
+                5, 10, 10, 10, 10, 10, 10, 5,   //
+                -5, 0, 0, 0, 0, 0, 0, -5,       //
+                -5, 0, 0, 0, 0, 0, 0, -5,       //
+                -5, 0, 0, 0, 0, 0, 0, -5,       //
+                -5, 0, 0, 0, 0, 0, 0, -5,       //
+                -5, 0, 0, 0, 0, 0, 0, -5,       //
+                0, 0, 0, 5, 5, 0, 0, 0,         //
+            },
+            // knight
+            {
+                -50, -40, -30, -30, -30, -30, -40, -50, //
+                -40, -20, 0, 0, 0, 0, -20, -40,         //
+                -30, 0, 10, 15, 15, 10, 0, -30,         //
+                -30, 5, 15, 20, 20, 15, 5, -30,         //
+                -30, 0, 15, 20, 20, 15, 0, -30,         //
+                -30, 5, 10, 15, 15, 10, 5, -30,         //
+                -40, -20, 0, 5, 5, 0, -20, -40,         //
+                -50, -40, -30, -30, -30, -30, -40, -50, //
+            },
+            // bishop
+            {
+                -20, -10, -10, -10, -10, -10, -10, -20, //
+                -10, 0, 0, 0, 0, 0, 0, -10,             //
+                -10, 0, 5, 10, 10, 5, 0, -10,           //
+                -10, 5, 5, 10, 10, 5, 5, -10,           //
+                -10, 0, 10, 10, 10, 10, 0, -10,         //
+                -10, 10, 10, 10, 10, 10, 10, -10,       //
+                -10, 5, 0, 0, 0, 0, 5, -10,             //
+                -20, -10, -10, -10, -10, -10, -10, -20, //
+            },
+            // queen
+            {
+                -20, -10, -10, -5, -5, -10, -10, -20, //
+                -10, 0, 0, 0, 0, 0, 0, -10,           //
+                -10, 0, 5, 5, 5, 5, 0, -10,           //
+                -5, 0, 5, 5, 5, 5, 0, -5,             //
+                0, 0, 5, 5, 5, 5, 0, -5,              //
+                -10, 5, 5, 5, 5, 5, 0, -10,           //
+                -10, 0, 5, 0, 0, 0, 0, -10,           //
+                -20, -10, -10, -5, -5, -10, -10, -20, //
+            },
+            // king
+            {
+                -30, -40, -40, -50, -50, -40, -40, -30, //
+                -30, -40, -40, -50, -50, -40, -40, -30, //
+                -30, -40, -40, -50, -50, -40, -40, -30, //
+                -30, -40, -40, -50, -50, -40, -40, -30, //
+                -20, -30, -30, -40, -40, -30, -30, -20, //
+                -10, -20, -20, -20, -20, -20, -20, -10, //
+                20, 20, 0, 0, 0, 0, 20, 20,             //
+                20, 30, 10, 0, 0, 10, 30, 20,           //
+            },
+            // pawn
+            {
+                0, 0, 0, 0, 0, 0, 0, 0,         //
+                50, 50, 50, 50, 50, 50, 50, 50, //
+                10, 10, 20, 30, 30, 20, 10, 10, //
+                5, 5, 10, 25, 25, 10, 5, 5,     //
+                0, 0, 0, 20, 20, 0, 0, 0,       //
+                5, -5, -10, 0, 0, -10, -5, 5,   //
+                5, 10, 10, -20, -20, 10, 10, 5, //
+                0, 0, 0, 0, 0, 0, 0, 0,         //
+            },
+        },
+    .bishop_pair = 30,
+    .tempo = 10,
+};
+
+int evaluate(const position_t* position, const eval_params_t* params)
+{
+    int score = 0;
+    int bishops[MAX_PLAYERS] = {0};
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        char is_white = FALSE;
+        const piece_type_t type = position_get_piece(position, i, &is_white);
+        if (type == none) continue;
+
+        // black reads the table upside down
+        const int value = params->material[type] + params->piece_square[type][is_white ? i : i ^ (BOARD_SZ - CELLS_PER_ROW)];
+        score += is_white ? value : -value;
+
+        if (type == bishop) bishops[is_white ? 1 : 0]++;
+    }
+
+    if (bishops[1] >= 2) score += params->bishop_pair;
+    if (bishops[0] >= 2) score -= params->bishop_pair;
+
+    return (position->is_white_to_move ? score : -score) + params->tempo;
+}
+
+char eval_params_load(eval_params_t* params, const char* path)
+{
+    *params = default_eval_params;
+
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(path, &size);
+    CHECK(text, FALSE, "Couldn't read eval params file");
+
+    // a name selects the parameter, the numbers after it fill its values in order, even across lines
+    const eval_param_entry_t* entry = NULL;
+    int value_index = 0;
+
+    for (char* c = text; *c;)
+    {
+        if (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n')
+        {
+            c++;
+            continue;
+        }
+
+        char* end = NULL;
+        const long value = SDL_strtol(c, &end, 10);
+
+        if (end != c)
+        {
+            if (entry && value_index < entry->count) ((int*)((char*)params + entry->offset))[value_index++] = (int)value;
+            c = end;
+            continue;
+        }
+
+        const char* name = c;
+        while (*c && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') c++;
+
+        entry = NULL;
+        value_index = 0;
+        for (unsigned long i = 0ul; i != SDL_arraysize(param_entries); ++i)
+        {
+            if (SDL_strlen(param_entries[i].name) == (size_t)(c - name) && !SDL_strncmp(param_entries[i].name, name, c - name)) entry = &param_entries[i];
+        }
+
+        if (!entry) SDL_Log("Unknown eval param: %.*s", (int)(c - name), name);
+    }
+
+    SDL_free(text);
+    return TRUE;
+}
+
+char eval_params_save(const eval_params_t* params, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    CHECK(file, FALSE, "Couldn't write eval params file");
+
+    for (unsigned long i = 0ul; i != SDL_arraysize(param_entries); ++i)
+    {
+        const int* values = (const int*)((const char*)params + param_entries[i].offset);
+
+        fprintf(file, "%s", param_entries[i].name);
+        for (int j = 0; j != param_entries[i].count; ++j) fprintf(file, (param_entries[i].count == BOARD_SZ && j % CELLS_PER_ROW == 0) ? "\n %i" : " %i", values[j]);
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    return TRUE;
+}
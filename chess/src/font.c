@@ -0,0 +1,184 @@
+#include <bundle.h>
+#include <context.h>
+#include <font.h>
+#include <perf_hud.h>
+#include <private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern renderer_t *renderer;
+
+// font files are read only once (or taken from the asset bundle), every size is then opened from memory
+typedef struct font_file {
+    char *path;
+    const void *data;
+    size_t size;
+    char is_mapped;
+} font_file_t;
+
+static font_file_t font_files[MAX_FONT_FILES];
+static font_t fonts[MAX_FONTS];
+
+static font_file_t *get_font_file(const char *path)
+{
+    for (unsigned long i = 0ul; i != MAX_FONT_FILES; ++i)
+    {
+        font_file_t *file = &font_files[i];
+
+        if (!file->path)
+        {
+            const bundle_entry_t *entry = bundle_find(path, bundle_font);
+
+            file->is_mapped = entry != NULL;
+            file->data = entry ? bundle_data(entry) : SDL_LoadFile(path, &file->size);
+            if (entry) file->size = entry->size;
+
+            CHECK(file->data, NULL, "Couldn't load font file");
+            file->path = SDL_strdup(path);
+            return file;
+        }
+
+        if (!SDL_strcmp(file->path, path)) return file;
+    }
+
+    SDL_Log("Too many font files, raise MAX_FONT_FILES");
+    return NULL;
+}
+
+static SDL_Texture *rasterize_atlas(TTF_Font *ttf_font, font_t *font)
+{
+    // glyphs are rendered in white, text colors are applied later through vertex colors
+    const SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+
+    SDL_Surface *glyph_surfaces[FONT_GLYPH_COUNT];
+    SDL_memset(glyph_surfaces, 0, sizeof(glyph_surfaces));
+
+    // first pass: render every glyph and pack it in rows to know the atlas height
+    int pen_x = 0, pen_y = 0;
+    for (unsigned long i = 0ul; i != FONT_GLYPH_COUNT; ++i)
+    {
+        const Uint16 ch = (Uint16)(FONT_FIRST_GLYPH + i);
+        glyph_t *glyph = &font->glyphs[i];
+
+        TTF_GlyphMetrics(ttf_font, ch, NULL, NULL, NULL, NULL, &glyph->advance);
+
+        glyph_surfaces[i] = TTF_RenderGlyph_Blended(ttf_font, ch, white);
+        if (!glyph_surfaces[i]) continue;
+
+        const int w = glyph_surfaces[i]->w, h = glyph_surfaces[i]->h;
+        if (pen_x + w > FONT_ATLAS_W)
+        {
+            pen_x = 0;
+            pen_y += font->line_height + 1;
+        }
+
+        glyph->atlas_rect = (SDL_Rect){pen_x, pen_y, w, h};
+        pen_x += w + 1;
+    }
+
+    // second pass: copy the glyphs in the atlas surface and upload it once
+    SDL_Surface *atlas_surface = SDL_CreateRGBSurfaceWithFormat(0, FONT_ATLAS_W, pen_y + font->line_height + 1, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Texture *atlas = NULL;
+
+    if (atlas_surface)
+    {
+        for (unsigned long i = 0ul; i != FONT_GLYPH_COUNT; ++i)
+        {
+            if (!glyph_surfaces[i]) continue;
+
+            SDL_SetSurfaceBlendMode(glyph_surfaces[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyph_surfaces[i], NULL, atlas_surface, &font->glyphs[i].atlas_rect);
+        }
+
+        atlas = SDL_CreateTextureFromSurface((SDL_Renderer *)renderer->sdl_renderer, atlas_surface);
+        perf_count(perf_glyph_rasterizations);
+        perf_count(perf_texture_uploads);
+        SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+        SDL_FreeSurface(atlas_surface);
+    }
+
+    for (unsigned long i = 0ul; i != FONT_GLYPH_COUNT; ++i)
+    {
+        SDL_FreeSurface(glyph_surfaces[i]);
+    }
+
+    return atlas;
+}
+
+font_t *font_get(const char *path, uint16_t size)
+{
+    font_t *slot = NULL;
+
+    for (unsigned long i = 0ul; i != MAX_FONTS; ++i)
+    {
+        if (!fonts[i].path)
+        {
+            slot = &fonts[i];
+            break;
+        }
+
+        if (fonts[i].size == size && !SDL_strcmp(fonts[i].path, path)) return &fonts[i];
+    }
+
+    CHECK(slot, NULL, "Too many fonts, raise MAX_FONTS");
+
+    font_file_t *file = get_font_file(path);
+    if (!file) return NULL;
+
+    TTF_Font *ttf_font = TTF_OpenFontRW(SDL_RWFromConstMem(file->data, (int)file->size), TRUE, size);
+    if (!ttf_font)
+    {
+        SDL_Log("Couldn't open font %s: [%s]", path, SDL_GetError());
+        return NULL;
+    }
+
+    slot->size = size;
+    slot->line_height = TTF_FontHeight(ttf_font);
+    slot->atlas = rasterize_atlas(ttf_font, slot);
+
+    // the atlas holds everything we need, the ttf font is not touched anymore
+    TTF_CloseFont(ttf_font);
+
+    if (!slot->atlas)
+    {
+        SDL_Log("Couldn't create glyph atlas for %s: [%s]", path, SDL_GetError());
+        return NULL;
+    }
+
+    slot->path = SDL_strdup(path);
+
+    return slot;
+}
+
+int font_measure(font_t *font, const char *text)
+{
+    int width = 0;
+
+    for (const char *c = text; *c; ++c)
+    {
+        if (*c < FONT_FIRST_GLYPH || *c > FONT_LAST_GLYPH) continue;
+        width += font->glyphs[*c - FONT_FIRST_GLYPH].advance;
+    }
+
+    return width;
+}
+
+void font_cache_destroy()
+{
+    for (unsigned long i = 0ul; i != MAX_FONTS; ++i)
+    {
+        if (fonts[i].atlas) SDL_DestroyTexture(fonts[i].atlas);
+        SDL_free(fonts[i].path);
+    }
+
+    for (unsigned long i = 0ul; i != MAX_FONT_FILES; ++i)
+    {
+        if (!font_files[i].is_mapped) SDL_free((void *)font_files[i].data);
+        SDL_free(font_files[i].path);
+    }
+
+    SDL_memset(fonts, 0, sizeof(fonts));
+    SDL_memset(font_files, 0, sizeof(font_files));
+}
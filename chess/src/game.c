@@ -1,13 +1,18 @@
+#include <bundle.h>
 #include <game.h>
+#include <input.h>
+#include <perf_hud.h>
 #include <scoreboard.h>
 #include <cell.h>
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <SDL_mixer.h>
 
 #include <sglib.h>
+#include <startup_profiler.h>
 
 // GLOBALS poimters
 window_t *window = NULL;
@@ -24,9 +29,6 @@ static Mix_Chunk *rankup_fx = NULL;
 static Mix_Chunk *gameover_fx = NULL;
 static Mix_Chunk *error_fx = NULL;
 
-// texture pool allocated on the stack
-texture_pool_t texture_pool;
-
 int old_pos_x = 0;
 int old_pos_y = 0;
 int old_piece_cell_index = 0;
@@ -40,38 +42,620 @@ char has_played_sound = FALSE;
         text_update(gameover_text, buffer); \
     }
 
-static void recycle_textures(chess_piece_t *piece)
+static Mix_Chunk *load_sound(const char *path)
 {
-    for (unsigned long i = 0ul; i != piece->moves_number; ++i)
+    int frequency = 0, channels = 0;
+    Uint16 format = 0;
+    Mix_QuerySpec(&frequency, &format, &channels);
+
+    // cooked pcm can be played in place only if the device opened with the format it was converted to
+    const bundle_entry_t *entry = bundle_find(path, bundle_sound);
+    if (entry && entry->width == (uint32_t)frequency && entry->height == (uint32_t)channels && entry->format == format)
     {
-        // if (!piece->moves || !piece->moves[i]) continue;
+        return Mix_QuickLoad_RAW((Uint8 *)bundle_data(entry), entry->size);
+    }
+
+    return Mix_LoadWAV(path);
+}
 
-        SGLIB_QUEUE_ADD(texture_t, texture_pool.textures, texture_pool.textures[texture_pool.i], texture_pool.i, texture_pool.j, TEXTURE_POOL_SIZE);
+static void show_legal_move_markers(game_t *game)
+{
+    marker_pool_t *markers = &game->legal_move_markers;
+    markers->count = 0;
+
+    // markers are just positions in a preallocated array, nothing is allocated or copied around
+    for (unsigned long i = 0ul; i != game->current_piece->moves_number; ++i)
+    {
+        const cell_t *cell = game->current_piece->moves[i].possible_cells;
+        markers->positions[markers->count++] = (SDL_Point){cell->pos_x, cell->pos_y};
     }
 }
 
-static void game_handle_pawn_promotion(game_t *game)
+static void hide_legal_move_markers(game_t *game) { game->legal_move_markers.count = 0; }
+
+#pragma region SNAPSHOTS
+static player_t *get_player(game_t *game, char is_white)
 {
-    if (!game->current_piece || game->current_piece->piece_type != pawn) return;
+    // the player waiting for its turn is the only one left in the queue
+    return game->current_player->is_white == is_white ? game->current_player : queue_peek(game->players_queue);
+}
 
-    piece_type_t types[] = {queen, knight, rook, bishop};
+static char has_not_moved(game_t *game, int index, piece_type_t type, char is_white)
+{
+    const chess_piece_t *piece = game->board.cells[index]->entity;
+    return piece && piece->piece_type == type && piece->piece_data.is_white == is_white && piece->piece_data.is_first_move;
+}
 
-    if (game->current_piece->pos_y == 0 || game->current_piece->pos_y == (SCREEN_H - CELL_SZ))
+static void game_take_snapshot(game_t *game, snapshot_t *snapshot)
+{
+    snapshot_clear(snapshot);
+
+    for (int i = 0; i != BOARD_SZ; ++i)
     {
-        for (unsigned long i = 0ul; i != PROMOTION_PIECES_COUNT; ++i)
+        const chess_piece_t *piece = game->board.cells[i]->entity;
+        if (!piece) continue;
+
+        snapshot_set_square(snapshot, i, piece->piece_type, piece->piece_data.is_white);
+    }
+
+    // only the pawn that has just moved two cells can be taken en passant
+    const chess_piece_t *moved_piece = game->current_piece;
+    if (moved_piece && moved_piece->piece_type == pawn && moved_piece->piece_data.is_enpassant)
+    {
+        snapshot->enpassant_index = (signed char)((moved_piece->pos_y / CELL_SZ) * CELLS_PER_ROW + moved_piece->pos_x / CELL_SZ);
+    }
+
+    // castling rights are what the king and rooks' first move flags say
+    const char white_king = has_not_moved(game, LOWER_LEFT_ROOK_INDEX + 4, king, TRUE);
+    const char black_king = has_not_moved(game, UPPER_LEFT_ROOK_INDEX + 4, king, FALSE);
+    if (white_king && has_not_moved(game, LOWER_RIGHT_ROOK_INDEX, rook, TRUE)) snapshot->flags |= CASTLE_WHITE_SHORT;
+    if (white_king && has_not_moved(game, LOWER_LEFT_ROOK_INDEX, rook, TRUE)) snapshot->flags |= CASTLE_WHITE_LONG;
+    if (black_king && has_not_moved(game, UPPER_RIGHT_ROOK_INDEX, rook, FALSE)) snapshot->flags |= CASTLE_BLACK_SHORT;
+    if (black_king && has_not_moved(game, UPPER_LEFT_ROOK_INDEX, rook, FALSE)) snapshot->flags |= CASTLE_BLACK_LONG;
+    if (game->current_player->is_white) snapshot->flags |= SNAPSHOT_WHITE_TO_MOVE;
+
+    snapshot->halfmove_clock = (unsigned char)SDL_min(game->halfmove_clock, UCHAR_MAX);
+    snapshot->fullmove_number = (unsigned short)game->fullmove_number;
+    snapshot->white_score = (unsigned char)get_player(game, TRUE)->score;
+    snapshot->black_score = (unsigned char)get_player(game, FALSE)->score;
+}
+
+static void game_load_snapshot(game_t *game, const snapshot_t *snapshot)
+{
+    board_clear(&game->board);
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        char is_white = FALSE;
+        const piece_type_t type = snapshot_get_square(snapshot, i, &is_white);
+        if (type == none) continue;
+
+        chess_piece_t *piece = board_place_piece(&game->board, i, type, is_white);
+        if (!piece) continue;
+
+        // rebuild the first move flags the move generator relies on
+        const int row = i / CELLS_PER_ROW;
+        switch (type)
+        {
+        case pawn: piece->piece_data.is_first_move = (row == (is_white ? CELLS_PER_ROW - 2 : 1)); break;
+        case king: piece->piece_data.is_first_move = (snapshot->flags & (is_white ? CASTLE_WHITE_SHORT | CASTLE_WHITE_LONG : CASTLE_BLACK_SHORT | CASTLE_BLACK_LONG)) != 0; break;
+        case rook:
+            piece->piece_data.is_first_move = (i == LOWER_RIGHT_ROOK_INDEX && (snapshot->flags & CASTLE_WHITE_SHORT)) || (i == LOWER_LEFT_ROOK_INDEX && (snapshot->flags & CASTLE_WHITE_LONG)) ||
+                                              (i == UPPER_RIGHT_ROOK_INDEX && (snapshot->flags & CASTLE_BLACK_SHORT)) || (i == UPPER_LEFT_ROOK_INDEX && (snapshot->flags & CASTLE_BLACK_LONG));
+            break;
+        default: piece->piece_data.is_first_move = FALSE; break;
+        }
+
+        piece->piece_data.is_enpassant = (i == snapshot->enpassant_index);
+    }
+
+    // hand the turn to the right player
+    if (game->current_player->is_white != snapshot_is_white_to_move(snapshot))
+    {
+        queue_enqueue(game->players_queue, game->current_player);
+        game->current_player = queue_peek(game->players_queue);
+        queue_dequeue(game->players_queue);
+    }
+    text_update(game->player_turn_text, game->current_player->is_white ? "> WHITE'S TURN <" : "> BLACK'S TURN <");
+
+    player_t *white_player = get_player(game, TRUE);
+    player_t *black_player = get_player(game, FALSE);
+    white_player->score = snapshot->white_score;
+    black_player->score = snapshot->black_score;
+    scoreboard_update(&game->scoreboard, white_player);
+    scoreboard_update(&game->scoreboard, black_player);
+
+    game->halfmove_clock = snapshot->halfmove_clock;
+    game->fullmove_number = snapshot->fullmove_number;
+}
+
+static void handle_history_keys(game_t *game)
+{
+    static char was_key_pressed = FALSE;
+
+    // left/right step one ply, home/end jump to the first and last stored ply
+    const unsigned char *keys = window->keys;
+    const char is_key_pressed = keys[SDL_SCANCODE_LEFT] || keys[SDL_SCANCODE_RIGHT] || keys[SDL_SCANCODE_HOME] || keys[SDL_SCANCODE_END];
+
+    if (is_key_pressed && !was_key_pressed && !game->current_piece)
+    {
+        const snapshot_t *snapshot = NULL;
+
+        if (keys[SDL_SCANCODE_LEFT]) snapshot = history_undo(&game->history);
+        else if (keys[SDL_SCANCODE_RIGHT]) snapshot = history_redo(&game->history);
+        else if (keys[SDL_SCANCODE_HOME]) snapshot = history_seek(&game->history, game->history.first_ply);
+        else if (keys[SDL_SCANCODE_END]) snapshot = history_seek(&game->history, game->history.last_ply);
+
+        if (snapshot)
+        {
+            hide_legal_move_markers(game);
+            game_load_snapshot(game, snapshot);
+            Mix_PlayChannel(-1, move_piece_fx, FALSE);
+        }
+    }
+
+    was_key_pressed = is_key_pressed;
+}
+#pragma endregion
+
+int game_get_movetext(const game_t *game, char *buffer, int size)
+{
+    const history_t *history = &game->history;
+    int length = 0;
+    buffer[0] = '\0';
+
+    for (int ply = history->first_ply + 1; ply <= history->current_ply && length < size; ++ply)
+    {
+        // the ply before says whose move it was and resolves the san
+        position_t position;
+        position_from_snapshot(&position, &history->plies[(ply - 1) % HISTORY_SIZE]);
+
+        const move_t move = game->moves[ply % HISTORY_SIZE];
+        char san[MAX_SAN_SIZE] = "--";
+        if (move.from != move.to) position_move_to_san(&position, move, san);
+
+        if (position.is_white_to_move) length += SDL_snprintf(buffer + length, size - length, "%s%i. %s", length ? " " : "", position.fullmove_number, san);
+        else if (ply == history->first_ply + 1) length += SDL_snprintf(buffer + length, size - length, "%i... %s", position.fullmove_number, san);
+        else length += SDL_snprintf(buffer + length, size - length, " %s", san);
+    }
+
+    return SDL_min(length, size - 1);
+}
+
+// hashes of the plies since the last capture or pawn move, the only ones that can repeat
+static int get_game_hashes(const game_t *game, int halfmove_clock, unsigned long long *hashes)
+{
+    const history_t *history = &game->history;
+    int count = 0;
+
+    for (int ply = SDL_max(history->first_ply, history->current_ply - halfmove_clock); ply <= history->current_ply; ++ply)
+    {
+        hashes[count++] = game->hashes[ply % HISTORY_SIZE];
+    }
+
+    return count;
+}
+
+static char is_draw_by_rule(game_t *game, const position_t *position)
+{
+    if (position->halfmove_clock >= 100)
+    {
+        text_update(gameover_text, "FIFTY MOVE RULE DRAW !");
+        return TRUE;
+    }
+
+    unsigned long long hashes[HISTORY_SIZE];
+    const int hashes_count = get_game_hashes(game, position->halfmove_clock, hashes);
+
+    if (position_is_repetition(hashes, hashes_count, position->halfmove_clock, 3))
+    {
+        text_update(gameover_text, "THREEFOLD REPETITION DRAW !");
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+#pragma region CLOCKS
+static void get_time_control(const game_t *game, int is_white, const position_t *position, time_control_t *control)
+{
+    control->remaining_ms = (unsigned)SDL_max(game->clock_remaining_ms[is_white], 0.0);
+    control->increment_ms = game->clock_increment_ms;
+
+    // the side's next move has the current fullmove number, whichever side it is
+    control->moves_to_go = game->clock_moves ? game->clock_moves - (position->fullmove_number - 1) % game->clock_moves : 0;
+}
+
+static void reset_clocks(game_t *game)
+{
+    game->clock_remaining_ms[TRUE] = game->clock_remaining_ms[FALSE] = game->clock_ms;
+    game->clock_last_tick = SDL_GetPerformanceCounter();
+}
+
+// the side to move is charged every frame, undoing a move hands the clock back to the other side with no increment
+static void update_clocks(game_t *game)
+{
+    if (!game->clock_ms) return;
+
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const double elapsed_ms = (double)(now - game->clock_last_tick) * 1000.0 / SDL_GetPerformanceFrequency();
+    game->clock_last_tick = now;
+
+    const int is_white = game->current_player->is_white;
+    game->clock_remaining_ms[is_white] -= elapsed_ms;
+
+    if (game->clock_remaining_ms[is_white] <= 0.0 && !game->is_gameover)
+    {
+        game->clock_remaining_ms[is_white] = 0.0;
+        SET_GAMEOVER_MSG("TIME OUT!", !is_white);
+        game->is_gameover = TRUE;
+        Mix_PlayChannel(-1, gameover_fx, FALSE);
+    }
+}
+
+// the texts only change when the shown time does: once a second, ten times a second in the last ten seconds
+static void refresh_clock_texts(game_t *game)
+{
+    for (unsigned long i = 0ul; i != MAX_PLAYERS; ++i)
+    {
+        const double remaining_ms = SDL_max(game->clock_remaining_ms[i], 0.0);
+        char buffer[MAX_BUFFER_SIZE];
+
+        if (remaining_ms < 10000.0) SDL_snprintf(buffer, MAX_BUFFER_SIZE, "%.1f", (int)(remaining_ms / 100.0) / 10.0);
+        else SDL_snprintf(buffer, MAX_BUFFER_SIZE, "%i:%02i", (int)(remaining_ms / 60000.0), (int)(remaining_ms / 1000.0) % 60);
+
+        if (SDL_strcmp(buffer, game->clock_texts[i]->text)) text_update(game->clock_texts[i], buffer);
+    }
+}
+#pragma endregion
+
+// everything a new ply needs once the board shows it: history, move list and the rules that can end the game
+static void record_ply(game_t *game, const snapshot_t *snapshot)
+{
+    perf_count(perf_moves);
+
+    // the board only knows where pieces are, the move is found back by comparing both sides of the ply
+    position_t previous, position;
+    position_from_snapshot(&previous, history_current(&game->history));
+    position_from_snapshot(&position, snapshot);
+
+    move_t move;
+    if (position_find_move(&previous, &position, &move))
+    {
+        char san[MAX_SAN_SIZE];
+        position_move_to_san(&previous, move, san);
+        SDL_Log("%i%s %s", previous.fullmove_number, previous.is_white_to_move ? "." : "...", san);
+    } else
+    {
+        SDL_memset(&move, 0, sizeof(move_t));
+        SDL_Log("Couldn't find the move that was just played");
+    }
+
+    // the mover gets its increment, and the next period's time with the last move of a period
+    if (game->clock_ms)
+    {
+        const int is_white = previous.is_white_to_move;
+        game->clock_remaining_ms[is_white] += game->clock_increment_ms;
+        if (game->clock_moves && previous.fullmove_number % game->clock_moves == 0) game->clock_remaining_ms[is_white] += game->clock_ms;
+    }
+
+    history_push(&game->history, snapshot);
+    game->moves[game->history.current_ply % HISTORY_SIZE] = move;
+    game->hashes[game->history.current_ply % HISTORY_SIZE] = position.hash;
+
+    // nothing is left to play once the tables know the result
+    int wdl = 0, dtm = 0;
+    move_t replies[MAX_MOVES];
+
+    if (tablebases_probe(&game->tablebases, &position, &wdl, &dtm))
+    {
+        if (!wdl) text_update(gameover_text, "TABLEBASE DRAW !");
+        else SET_GAMEOVER_MSG("TABLEBASE:", (wdl > 0) == game->current_player->is_white);
+
+        game->is_gameover = TRUE;
+    } else if (!position_generate_moves(&position, replies, FALSE))
+    {
+        // the engine never clicks on its king, mates are found by the rules after every ply
+        if (position_in_check(&position))
+        {
+            SET_GAMEOVER_MSG("KING CHECKMATE!", !position.is_white_to_move);
+        } else
+        {
+            text_update(gameover_text, "STALEMATE DRAW !");
+        }
+
+        game->is_gameover = TRUE;
+    } else
+    {
+        game->is_gameover = is_draw_by_rule(game, &position);
+    }
+
+    if (game->is_gameover) Mix_PlayChannel(-1, gameover_fx, FALSE);
+}
+
+static void end_turn(game_t *game)
+{
+    if (!game->current_player->is_white) game->fullmove_number++;
+
+    // swap player's turn and enqueue the old player to be ready for the next turn
+    queue_enqueue(game->players_queue, game->current_player);
+    game->current_player = queue_peek(game->players_queue);
+
+    // update turn text
+    text_update(game->player_turn_text, game->current_player->is_white ? "> WHITE'S TURN <" : "> BLACK'S TURN <");
+
+    // dequeue old player
+    queue_dequeue(game->players_queue);
+
+    snapshot_t snapshot;
+    game_take_snapshot(game, &snapshot);
+    record_ply(game, &snapshot);
+}
+
+#pragma region ENGINE
+static void play_engine_move(game_t *game, const position_t *before, move_t move)
+{
+    // the captured piece is still on the board to tell what it's worth
+    const int captured_index = (move.flags & MOVE_ENPASSANT) ? (move.from / CELLS_PER_ROW) * CELLS_PER_ROW + move.to % CELLS_PER_ROW : move.to;
+    const chess_piece_t *captured = game->board.cells[captured_index]->entity;
+    if (captured) game->current_player->score += captured->score_value;
+
+    position_t position = *before;
+    undo_t undo;
+    position_make_move(&position, move, &undo);
+
+    snapshot_t snapshot;
+    position_to_snapshot(&position, &snapshot);
+    snapshot.white_score = (unsigned char)get_player(game, TRUE)->score;
+    snapshot.black_score = (unsigned char)get_player(game, FALSE)->score;
+
+    // the board is rebuilt from the snapshot like an undo would, turn and scores included
+    hide_legal_move_markers(game);
+    game_load_snapshot(game, &snapshot);
+
+    Mix_Chunk *fx = (move.flags & MOVE_CASTLING) ? castling_fx : (move.flags & MOVE_ENPASSANT) ? enpassant_fx : captured ? eat_fx : move_piece_fx;
+    Mix_PlayChannel(-1, fx, FALSE);
+
+    record_ply(game, &snapshot);
+}
+
+// the plies since the last capture or pawn move are sent as moves, the engine sees the repetitions too
+static void send_uci_position(game_t *game, const position_t *position)
+{
+    const history_t *history = &game->history;
+    const int first_ply = SDL_max(history->first_ply, history->current_ply - position->halfmove_clock);
+
+    position_t start;
+    position_from_snapshot(&start, &history->plies[first_ply % HISTORY_SIZE]);
+
+    char command[UCI_MAX_LINE];
+    int length = SDL_snprintf(command, UCI_MAX_LINE, "position fen ");
+    position_to_fen(&start, command + length, UCI_MAX_LINE - length);
+    length += (int)SDL_strlen(command + length);
+
+    if (first_ply != history->current_ply) length += SDL_snprintf(command + length, UCI_MAX_LINE - length, " moves");
+
+    for (int ply = first_ply + 1; ply <= history->current_ply; ++ply)
+    {
+        char uci[8];
+        move_to_uci(game->moves[ply % HISTORY_SIZE], uci);
+        length += SDL_snprintf(command + length, UCI_MAX_LINE - length, " %s", uci);
+    }
+
+    uci_engine_send(&game->uci_engine, "%s", command);
+}
+
+// messages from the external engine are handled here in the play state, the pipes are the i/o thread's business
+static char update_uci_engine(game_t *game)
+{
+    position_t position;
+    position_from_snapshot(&position, history_current(&game->history));
+    const char is_engine_turn = position.is_white_to_move == game->is_engine_white;
+
+    uci_message_t message;
+    while (uci_engine_poll(&game->uci_engine, &message))
+    {
+        switch (message.type)
         {
-            // allocate pieces only once per team
-            if (!game->current_player->has_promotion_pieces)
+        case uci_message_uciok:
+            uci_engine_send(&game->uci_engine, "ucinewgame");
+            uci_engine_send(&game->uci_engine, "isready");
+            break;
+        case uci_message_readyok: game->is_uci_ready = TRUE; break;
+        case uci_message_info: game->uci_info = message; break;
+        case uci_message_exited:
+            SDL_Log("The uci engine exited, both sides are played by hand now");
+            game->has_engine = FALSE;
+            return FALSE;
+        case uci_message_bestmove:
+        {
+            // answers to searches the game moved away from are dropped
+            game->uci_searches = SDL_max(game->uci_searches - 1, 0);
+            if (game->uci_searches || game->uci_hash != position.hash || !is_engine_turn) break;
+
+            move_t move;
+            if (!position_parse_uci(&position, message.move, &move))
             {
-                chess_piece_t *promotion_piece = chess_piece_new(types[i], game->current_piece->piece_data.is_white, FALSE);
-                game->promotion_pieces[i] = promotion_piece;
+                SDL_Log("The uci engine sent an illegal move: %s", message.move);
+                game->uci_hash = 0;
+                break;
             }
 
+            const uci_message_t *info = &game->uci_info;
+            SDL_Log("engine: %s depth %i score %s%i nodes %llu nps %llu", message.move, info->depth, info->is_mate ? "mate " : "", info->score, info->nodes, info->nps);
+            SDL_memset(&game->uci_info, 0, sizeof(uci_message_t));
+
+            play_engine_move(game, &position, move);
+            return TRUE;
+        }
+        }
+    }
+
+    if (!is_engine_turn || !game->is_uci_ready)
+    {
+        // undoing to the human's turn stops a search nobody waits for
+        if (game->uci_searches && game->uci_hash)
+        {
+            uci_engine_send(&game->uci_engine, "stop");
+            game->uci_hash = 0;
+        }
+
+        return FALSE;
+    }
+
+    if (game->uci_searches && game->uci_hash == position.hash) return TRUE;
+    if (game->uci_searches && game->uci_hash) uci_engine_send(&game->uci_engine, "stop");
+
+    send_uci_position(game, &position);
+    if (game->clock_ms)
+    {
+        time_control_t control;
+        get_time_control(game, position.is_white_to_move, &position, &control);
+
+        char moves_to_go[MAX_BUFFER_SIZE] = "";
+        if (control.moves_to_go) SDL_snprintf(moves_to_go, MAX_BUFFER_SIZE, " movestogo %i", control.moves_to_go);
+
+        uci_engine_send(&game->uci_engine, "go wtime %u btime %u winc %u binc %u%s", (unsigned)SDL_max(game->clock_remaining_ms[TRUE], 0.0),
+                        (unsigned)SDL_max(game->clock_remaining_ms[FALSE], 0.0), game->clock_increment_ms, game->clock_increment_ms, moves_to_go);
+    } else
+    {
+        uci_engine_send(&game->uci_engine, "go movetime %u", game->engine_time_ms ? game->engine_time_ms : ENGINE_PLAYER_DEFAULT_TIME_MS);
+    }
+    game->uci_searches++;
+    game->uci_hash = position.hash;
+
+    return TRUE;
+}
+
+// the engine is only polled here, it searches on its own thread and ponders while the human drags pieces.
+// Returns TRUE on the engine's turn, the human can't touch the pieces then.
+static char update_engine(game_t *game)
+{
+    if (!game->has_engine) return FALSE;
+    if (game->has_uci_engine) return update_uci_engine(game);
+
+    position_t position;
+    position_from_snapshot(&position, history_current(&game->history));
+
+    unsigned long long hashes[HISTORY_SIZE];
+    const int hashes_count = get_game_hashes(game, position.halfmove_clock, hashes);
+
+    // with clocks the engine splits its own time, the search reads it once when it starts
+    time_control_t control;
+    if (game->clock_ms) get_time_control(game, game->is_engine_white, &position, &control);
+    const time_control_t *clock = game->clock_ms ? &control : NULL;
+
+    if (position.is_white_to_move != game->is_engine_white)
+    {
+        engine_player_ponder(&game->engine, &position, hashes, hashes_count, clock);
+        return FALSE;
+    }
+
+    move_t move;
+    if (engine_player_think(&game->engine, &position, hashes, hashes_count, clock, &move)) play_engine_move(game, &position, move);
+
+    return TRUE;
+}
+#pragma endregion
+
+#pragma region ANALYSIS
+#define ANALYSIS_BAR_H 6
+#define ANALYSIS_LINE_H 18
+
+static void clear_analysis_panel(game_t *game, unsigned long long hash)
+{
+    game->analysis_hash = hash;
+    game->analysis_white_score = 0;
+
+    for (unsigned long i = 0ul; i != ANALYSIS_MAX_LINES; ++i) text_update(game->analysis_texts[i], i ? "" : "...");
+    text_update(game->analysis_nps_text, "");
+}
+
+// the search streams its lines from its own thread, the panel takes the newest ones once per display refresh:
+// faster frames would only upload the same texts again
+static void update_analysis(game_t *game)
+{
+    if (!game->has_analysis) return;
+
+    const char is_toggle_pressed = window->keys[SDL_SCANCODE_F2];
+    if (is_toggle_pressed && !game->was_analysis_toggle_pressed)
+    {
+        game->is_analysis_visible = !game->is_analysis_visible;
+        game->analysis_hash = 0;
+        if (!game->is_analysis_visible) analysis_pause(&game->analysis);
+    }
+    game->was_analysis_toggle_pressed = is_toggle_pressed;
+
+    // the history only holds a game once the setup state filled it
+    if (!game->is_analysis_visible || game->current_state == game->game_states[0]) return;
+
+    position_t position;
+    position_from_snapshot(&position, history_current(&game->history));
+
+    if (position.hash != game->analysis_hash)
+    {
+        unsigned long long hashes[HISTORY_SIZE];
+        const int hashes_count = get_game_hashes(game, position.halfmove_clock, hashes);
+        analysis_set_position(&game->analysis, &position, hashes, hashes_count);
+        clear_analysis_panel(game, position.hash);
+    }
+
+    game->since_analysis_refresh_ms += window->delta_time;
+    if (game->since_analysis_refresh_ms < game->analysis_refresh_ms) return;
+    game->since_analysis_refresh_ms = 0.0f;
+
+    // lines still coming from the previous position are dropped
+    const analysis_update_t *update = analysis_poll(&game->analysis);
+    if (!update || update->hash != game->analysis_hash) return;
+
+    game->analysis_white_score = update->lines[0].score;
+    for (unsigned long i = 0ul; i != ANALYSIS_MAX_LINES; ++i) text_update(game->analysis_texts[i], (int)i < update->lines_count ? update->lines[i].text : "");
+
+    char buffer[MAX_BUFFER_SIZE];
+    SDL_snprintf(buffer, MAX_BUFFER_SIZE, "%llu kN/s", update->nps / 1000ull);
+    text_update(game->analysis_nps_text, buffer);
+}
+
+static void draw_analysis(game_t *game)
+{
+    SDL_Renderer *native_renderer = (SDL_Renderer *)renderer->sdl_renderer;
+
+    // white's share of the bar is its expected score, a mate fills it
+    const int score = game->analysis_white_score;
+    const double white_share = IS_MATE_SCORE(score) ? (score > 0 ? 1.0 : 0.0) : 1.0 / (1.0 + SDL_pow(10.0, -score / 400.0));
+    const int white_w = (int)(SCREEN_W * white_share);
+
+    const SDL_Rect white_bar = {0, SCREEN_H, white_w, ANALYSIS_BAR_H};
+    SDL_SetRenderDrawColor(native_renderer, 0xF0, 0xF0, 0xF0, 0xFF);
+    SDL_RenderFillRect(native_renderer, &white_bar);
+    perf_count(perf_draw_calls);
+
+    const SDL_Rect black_bar = {white_w, SCREEN_H, SCREEN_W - white_w, ANALYSIS_BAR_H};
+    SDL_SetRenderDrawColor(native_renderer, 0x20, 0x20, 0x20, 0xFF);
+    SDL_RenderFillRect(native_renderer, &black_bar);
+    perf_count(perf_draw_calls);
+
+    const int pen_y = SCREEN_H + ANALYSIS_BAR_H + 2;
+    for (unsigned long i = 0ul; i != ANALYSIS_MAX_LINES; ++i) text_draw(game->analysis_texts[i], 15, pen_y + (int)i * ANALYSIS_LINE_H);
+    text_draw(game->analysis_nps_text, SCREEN_W - game->analysis_nps_text->width - 15, pen_y + (ANALYSIS_MAX_LINES - 1) * ANALYSIS_LINE_H);
+}
+#pragma endregion
+
+static void game_handle_pawn_promotion(game_t *game)
+{
+    if (!game->current_piece || game->current_piece->piece_type != pawn) return;
+
+    if (game->current_piece->pos_y == 0 || game->current_piece->pos_y == (SCREEN_H - CELL_SZ))
+    {
+        // the menu pieces were created at startup, here we only move them next to the pawn
+        chess_piece_t **promotion_pieces = game->promotion_pieces[game->current_piece->piece_data.is_white ? 1 : 0];
+
+        for (unsigned long i = 0ul; i != PROMOTION_PIECES_COUNT; ++i)
+        {
             int pos_y = game->current_piece->piece_data.is_white ? ((game->current_piece->pos_y + CELL_SZ) + (CELL_SZ * i)) : ((game->current_piece->pos_y - CELL_SZ) - (CELL_SZ * i));
-            game->promotion_pieces[i]->set_position(game->promotion_pieces[i], (int)game->current_piece->pos_x, (int)pos_y);
+            promotion_pieces[i]->set_position(promotion_pieces[i], (int)game->current_piece->pos_x, (int)pos_y);
         }
 
-        game->current_player->has_promotion_pieces = TRUE;
         game->is_promoting_pawn = TRUE;
     }
 }
@@ -97,7 +681,7 @@ static cell_t *find_matching_cell(game_t *game, size_t cell_index)
 static void handle_chess_piece_selection(game_t *game)
 {
     int mouse_x, mouse_y;
-    Uint32 mouse_state = SDL_GetMouseState(&mouse_x, &mouse_y);
+    Uint32 mouse_state = input_get_mouse_state(&mouse_x, &mouse_y);
 
     if (mouse_y >= SCREEN_H) return;
 
@@ -106,7 +690,7 @@ static void handle_chess_piece_selection(game_t *game)
     if (!game->is_promoting_pawn)
     {
         // give a feedback to player of the current hovered cell
-        cell_highlight(game->board.cells[current_cell_index], (float)mouse_x, (float)mouse_y, SELECTION_BLACK);
+        board_highlight_cell(&game->board, current_cell_index);
     }
 
     if (mouse_state & SDL_BUTTON(LMB_INDEX))
@@ -129,7 +713,11 @@ static void handle_chess_piece_selection(game_t *game)
                     old_pos_x = game->current_piece->pos_x;
                     old_pos_y = game->current_piece->pos_y;
 
+                    perf_movegen_begin();
                     game->current_piece->generate_legal_moves(game->current_piece, &game->board, FALSE);
+                    perf_movegen_end();
+
+                    show_legal_move_markers(game);
 
                     // check whether the king is in checkmate
                     if (game->current_piece->piece_type == king)
@@ -187,6 +775,9 @@ static void handle_chess_piece_selection(game_t *game)
 
                     game->current_player->score += found_cell->entity->score_value;
                     scoreboard_update(&game->scoreboard, game->current_player);
+
+                    // the captured piece leaves the board for good, its slot is free for a promotion
+                    chess_piece_pool_release(&game->piece_pool, found_cell->entity);
                 } else
                 {
                     // Play sound if cell is found but was not occupied
@@ -262,23 +853,20 @@ static void handle_chess_piece_selection(game_t *game)
                         // update scoreboard
                         game->current_player->score += enpassant_piece->score_value;
                         scoreboard_update(&game->scoreboard, game->current_player);
+
+                        chess_piece_pool_release(&game->piece_pool, enpassant_piece);
                     }
                 }
 #pragma endregion
 
                 game->current_piece->piece_data.is_first_move = FALSE;
 
+                // pawn moves and captures reset the fifty move counter
+                game->halfmove_clock = (game->current_piece->piece_type == pawn || game->current_piece->piece_data.has_eat_piece) ? 0 : game->halfmove_clock + 1;
+
                 if (!game->is_promoting_pawn)
                 {
-                    // swap player's turn and enqueue the old player to be ready for the next turn
-                    queue_enqueue(game->players_queue, game->current_player);
-                    game->current_player = queue_peek(game->players_queue);
-
-                    // update turn text
-                    text_update(game->player_turn_text, game->current_player->is_white ? "> WHITE'S TURN <" : "> BLACK'S TURN <");
-
-                    // dequeue old player
-                    queue_dequeue(game->players_queue);
+                    end_turn(game);
                 } else
                 {
                     old_piece_cell_index = current_cell_index;
@@ -288,7 +876,7 @@ static void handle_chess_piece_selection(game_t *game)
                 game->current_piece->set_position(game->current_piece, old_pos_x, old_pos_y);
             }
 
-            recycle_textures(game->current_piece);
+            hide_legal_move_markers(game);
 
             game->current_piece->piece_data.has_eat_piece = FALSE;
             game->current_piece = NULL;
@@ -302,24 +890,16 @@ static void handle_chess_piece_selection(game_t *game)
 
             chess_piece_set_entity_cell(&game->board, game->promoted_piece, old_piece_cell_index);
 
-            // swap player's turn and enqueue the old player to be ready for the next turn
-            queue_enqueue(game->players_queue, game->current_player);
-            game->current_player = queue_peek(game->players_queue);
-
-            // update turn text
-            text_update(game->player_turn_text, game->current_player->is_white ? "> WHITE'S TURN <" : "> BLACK'S TURN <");
-
-            // dequeue old player
-            queue_dequeue(game->players_queue);
-
             game->promoted_piece = NULL;
+
+            end_turn(game);
         }
     }
 }
 
-game_state_t *game_state_new()
+game_state_t *game_state_new(arena_t *arena)
 {
-    game_state_t *game = (game_state_t *)calloc(1, sizeof(game_state_t));
+    game_state_t *game = (game_state_t *)arena_alloc(arena, sizeof(game_state_t));
     CHECK(game, NULL, "Couldn't allocate memory for game_state struct");
 
     return game;
@@ -339,16 +919,14 @@ game_t *game_new()
 
 static void draw_legal_moves(game_t *game)
 {
-    Uint32 mask = SDL_GetMouseState(NULL, NULL);
+    Uint32 mask = input_get_mouse_state(NULL, NULL);
 
     if (mask & SDL_BUTTON(LMB_INDEX))
     {
         if (game->current_piece)
         {
-            for (unsigned long i = 0ul; i != game->current_piece->moves_number; ++i)
-            {
-                game->current_piece->moves[i].markers->render(game->current_piece->moves[i].markers, SDL_ALPHA_OPAQUE / 2, NULL);
-            }
+            const marker_pool_t *markers = &game->legal_move_markers;
+            texture_render_instances(markers->dot, markers->positions, markers->count, SDL_ALPHA_OPAQUE / 2);
         }
     }
 }
@@ -357,25 +935,33 @@ static void draw_promotion_pieces(game_t *game)
 {
     // draw pawn promotion textures
     int mouse_x, mouse_y;
-    Uint32 mouse_state = SDL_GetMouseState(&mouse_x, &mouse_y);
+    Uint32 mouse_state = input_get_mouse_state(&mouse_x, &mouse_y);
+
+    chess_piece_t **promotion_pieces = game->promotion_pieces[game->current_player->is_white ? 1 : 0];
 
     for (unsigned long i = 0ul; i != PROMOTION_PIECES_COUNT; ++i)
     {
-        if (game->promotion_pieces[i])
+        if (promotion_pieces[i])
         {
             color_t color_mod = game->current_player->is_white ? WHITE : BLACK;
-            SDL_SetTextureColorMod(game->promotion_pieces[i]->chess_texture->texture, color_mod.r, color_mod.g, color_mod.b);
-            game->promotion_pieces[i]->draw(game->promotion_pieces[i]);
+            SDL_SetTextureColorMod(promotion_pieces[i]->chess_texture->texture, color_mod.r, color_mod.g, color_mod.b);
+            promotion_pieces[i]->draw(promotion_pieces[i]);
 
             // check if mouse is inside one of the available pieces to choose
-            if ((mouse_x > game->promotion_pieces[i]->pos_x && (mouse_x < game->promotion_pieces[i]->pos_x + CELL_SZ)) && (mouse_y > game->promotion_pieces[i]->pos_y && mouse_y < (game->promotion_pieces[i]->pos_y + CELL_SZ)))
+            if ((mouse_x > promotion_pieces[i]->pos_x && (mouse_x < promotion_pieces[i]->pos_x + CELL_SZ)) && (mouse_y > promotion_pieces[i]->pos_y && mouse_y < (promotion_pieces[i]->pos_y + CELL_SZ)))
             {
                 if (mouse_state & SDL_BUTTON(LMB_INDEX))
                 {
                     // promote pawn
                     Mix_PlayChannel(-1, rankup_fx, FALSE);
 
-                    game->promoted_piece = chess_piece_new(game->promotion_pieces[i]->piece_type, game->promotion_pieces[i]->piece_data.is_white, TRUE);
+                    // no allocation nor decoding here: the pawn gives its slot back first, so the pool always has one
+                    // to hand out, and the texture is already shared
+                    chess_piece_pool_release(&game->piece_pool, game->board.cells[old_piece_cell_index]->entity);
+                    chess_piece_set_entity_null(&game->board, old_piece_cell_index);
+
+                    game->promoted_piece = chess_piece_pool_acquire(&game->piece_pool, promotion_pieces[i]->piece_type, promotion_pieces[i]->piece_data.is_white, TRUE);
+                    game->promoted_piece->piece_data.is_first_move = FALSE;
                     game->is_promoting_pawn = FALSE;
                     break;
                 }
@@ -390,15 +976,12 @@ static void draw_promotion_pieces(game_t *game)
 
 void state_setup_enter(game_t *game)
 {
-    // create scoreboard
-    scoreboard_new(&game->scoreboard);
-
-    // create two players
-    player_t *white_player = player_new(TRUE);
-    player_t *black_player = player_new(FALSE);
+    // create two players, they live in the match arena and are recreated on every restart
+    player_t *white_player = player_new(&game->match_arena, TRUE);
+    player_t *black_player = player_new(&game->match_arena, FALSE);
 
     // enqueue the two players ans white starts
-    game->players_queue = queue_new(MAX_PLAYERS, sizeof(player_t) * MAX_PLAYERS);
+    game->players_queue = queue_new(&game->match_arena, MAX_PLAYERS, sizeof(player_t *) * MAX_PLAYERS);
     queue_enqueue(game->players_queue, white_player);
     queue_enqueue(game->players_queue, black_player);
 
@@ -406,7 +989,25 @@ void state_setup_enter(game_t *game)
     queue_dequeue(game->players_queue);
 }
 
-static game_state_t *state_setup_update(game_state_t *gs, game_t *game) { return *gs->next; }
+static game_state_t *state_setup_update(game_state_t *gs, game_t *game)
+{
+    // board and players are both ready only here, on startup and after a restart
+    game->halfmove_clock = 0;
+    game->fullmove_number = 1;
+
+    snapshot_t initial;
+    game_take_snapshot(game, &initial);
+    history_reset(&game->history, &initial);
+
+    position_t position;
+    position_from_snapshot(&position, &initial);
+    game->hashes[0] = position.hash;
+
+    reset_clocks(game);
+    if (game->has_engine && !game->has_uci_engine) engine_player_new_game(&game->engine);
+
+    return *gs->next;
+}
 
 void state_setup_exit(game_t *game) { }
 
@@ -417,6 +1018,8 @@ void state_play_enter(game_t *game) { }
 
 game_state_t *state_play_update(game_state_t *gs, game_t *game)
 {
+    update_clocks(game);
+
     // go to gameover state
     if (game->is_gameover)
     {
@@ -430,7 +1033,8 @@ game_state_t *state_play_update(game_state_t *gs, game_t *game)
         return gs->next[0];
     }
 
-    handle_chess_piece_selection(game);
+    handle_history_keys(game);
+    if (!update_engine(game)) handle_chess_piece_selection(game);
 
     return gs;
 }
@@ -444,6 +1048,7 @@ void state_promote_pawn_enter(game_t *game) { }
 
 game_state_t *state_promote_pawn_update(game_state_t *gs, game_t *game)
 {
+    update_clocks(game);
     draw_promotion_pieces(game);
 
     return game->is_promoting_pawn ? gs : gs->next[0];
@@ -454,14 +1059,15 @@ void state_promote_pawn_exit(game_t *game) { }
 
 // GAMEOVER STATE
 
-void state_gameover_enter(game_t *game) { }
+void state_gameover_enter(game_t *game)
+{
+    char movetext[MOVETEXT_SIZE];
+    game_get_movetext(game, movetext, sizeof(movetext));
+    printf("%s\n", movetext);
+}
 
 game_state_t *state_gameover_update(game_state_t *gs, game_t *game)
 {
-    // TODO: must implement a better way to manage game reset, right now we are alloc/dealloc memory frequently
-    // and that will cause memory fragmentation, this is not what we want, we should pool memory instead. Right now
-    // Whenever the game is ended, a new board is initialized by calling memalloc on all cells/pieces/textures.
-
     if (window->keys[SDL_SCANCODE_SPACE])
     {
         gs->on_state_exit(game);
@@ -470,8 +1076,8 @@ game_state_t *state_gameover_update(game_state_t *gs, game_t *game)
     }
 
     gameover_background->render(gameover_background, 0, NULL);
-    text_draw(gameover_text, (SCREEN_W / 2) - gameover_text->text_surface->w / 2, (SCREEN_H / 2) - CELL_SZ);
-    text_draw(restart_text, (SCREEN_W / 2) - restart_text->text_surface->w / 2, (SCREEN_H / 2));
+    text_draw(gameover_text, (SCREEN_W / 2) - gameover_text->width / 2, (SCREEN_H / 2) - CELL_SZ);
+    text_draw(restart_text, (SCREEN_W / 2) - restart_text->width / 2, (SCREEN_H / 2));
 
     return gs;
 }
@@ -488,32 +1094,47 @@ void state_gameover_exit(game_t *game)
 
 void game_init(game_t *game)
 {
+    startup_profiler_begin("game_init");
+
+    perf_new(input_is_replaying());
+
+    // map cooked assets before anything tries to load them
+    startup_profiler_begin("asset bundle");
+    bundle_open(ASSET_BUNDLE_PATH);
+    startup_profiler_end();
+
     // create window, renderer and events
+    startup_profiler_begin("window");
     window = window_new(SCREEN_W, SCREEN_H + CELL_SZ, "Chess-C");
+    startup_profiler_end();
+
+    startup_profiler_begin("renderer");
     renderer = renderer_new(window);
+    startup_profiler_end();
 
-    memset(&texture_pool, 0, sizeof(texture_pool_t));
+    arena_new(&game->arena, GAME_ARENA_SIZE);
+    arena_new(&game->match_arena, MATCH_ARENA_SIZE);
 
     // Setup FSM
-    game_state_t *state_setup = game_state_new();
+    game_state_t *state_setup = game_state_new(&game->arena);
     state_setup->on_state_enter = state_setup_enter;
     state_setup->on_state_update = state_setup_update;
     state_setup->on_state_exit = state_setup_exit;
     game->game_states[0] = state_setup;
 
-    game_state_t *state_play = game_state_new();
+    game_state_t *state_play = game_state_new(&game->arena);
     state_play->on_state_enter = state_play_enter;
     state_play->on_state_update = state_play_update;
     state_play->on_state_exit = state_play_exit;
     game->game_states[1] = state_play;
 
-    game_state_t *state_promote = game_state_new();
+    game_state_t *state_promote = game_state_new(&game->arena);
     state_promote->on_state_enter = state_promote_pawn_enter;
     state_promote->on_state_update = state_promote_pawn_update;
     state_promote->on_state_exit = state_promote_pawn_exit;
     game->game_states[2] = state_promote;
 
-    game_state_t *state_gameover = game_state_new();
+    game_state_t *state_gameover = game_state_new(&game->arena);
     state_gameover->on_state_enter = state_gameover_enter;
     state_gameover->on_state_update = state_gameover_update;
     state_gameover->on_state_exit = state_gameover_exit;
@@ -527,45 +1148,105 @@ void game_init(game_t *game)
     state_gameover->next[0] = state_setup;
 
     // Set current state
+    startup_profiler_begin("setup state");
+    scoreboard_new(&game->scoreboard);
     game->current_state = state_setup;
     game->current_state->on_state_enter(game);
+    startup_profiler_end();
 
-    // Create texture pool for later use
-    SGLIB_QUEUE_INIT(texture_t, texture_pool.textures, texture_pool.i, texture_pool.j);
-    for (unsigned long i = 0ul; i != TEXTURE_POOL_SIZE - 1; ++i)
+    // Load the only texture legal move markers need
+    startup_profiler_begin("legal move markers");
+    game->legal_move_markers.dot = texture_load_from_file("../assets/textures/dot.comp", TRUE);
+    startup_profiler_end();
+
+    // Creae board and pieces
+    startup_profiler_begin("board");
+    chess_piece_pool_new(&game->piece_pool, &game->arena);
+    board_new(&game->board, &game->arena, &game->piece_pool);
+    startup_profiler_end();
+
+    // Create promotion menu pieces for both teams so that promoting never decodes or allocates
+    startup_profiler_begin("promotion pieces");
+    const piece_type_t promotion_types[PROMOTION_PIECES_COUNT] = {queen, knight, rook, bishop};
+    for (unsigned long team = 0ul; team != MAX_PLAYERS; ++team)
     {
-        SGLIB_QUEUE_ADD(texture_t, texture_pool.textures, *texture_load_from_file("../assets/textures/dot.comp", TRUE), texture_pool.i, texture_pool.j, TEXTURE_POOL_SIZE);
+        for (unsigned long i = 0ul; i != PROMOTION_PIECES_COUNT; ++i)
+        {
+            game->promotion_pieces[team][i] = chess_piece_new(&game->arena, promotion_types[i], (char)team, FALSE);
+        }
     }
+    startup_profiler_end();
 
-    // Creae board and pieces
-    board_new(&game->board);
+    startup_profiler_begin("texts");
     game->player_turn_text = text_new("../assets/fonts/Lato-Black.ttf", 14, "> WHITE'S TURN <", TURN);
+    for (unsigned long i = 0ul; game->clock_ms && i != MAX_PLAYERS; ++i) game->clock_texts[i] = text_new("../assets/fonts/Lato-Black.ttf", 16, "", TURN);
 
     color_t gameover_background_color = color_create(0, 0, 0, 115);
     gameover_background = texture_create_raw(512, 512, gameover_background_color);
 
-    color_t gameover_text_color = color_create(255, 255, 255, 0);
+    color_t gameover_text_color = color_create(255, 255, 255, 255);
     gameover_text = text_new("../assets/fonts/Lato-Black.ttf", 28, "---", gameover_text_color);
     restart_text = text_new("../assets/fonts/Lato-Black.ttf", 28, "PRESS SPACE TO RESTART", gameover_text_color);
+    startup_profiler_end();
 
     // INIT AUDIO SOUNDS
-    move_piece_fx = Mix_LoadWAV("../assets/sounds/move_piece.wav");
-    enpassant_fx = Mix_LoadWAV("../assets/sounds/enpassant.wav");
-    castling_fx = Mix_LoadWAV("../assets/sounds/castling.wav");
-    eat_fx = Mix_LoadWAV("../assets/sounds/eat_pawn.wav");
-    rankup_fx = Mix_LoadWAV("../assets/sounds/rankup.wav");
-    gameover_fx = Mix_LoadWAV("../assets/sounds/gameover.wav");
-    error_fx = Mix_LoadWAV("../assets/sounds/error.wav");
+    startup_profiler_begin("sounds");
+    move_piece_fx = load_sound("../assets/sounds/move_piece.wav");
+    enpassant_fx = load_sound("../assets/sounds/enpassant.wav");
+    castling_fx = load_sound("../assets/sounds/castling.wav");
+    eat_fx = load_sound("../assets/sounds/eat_pawn.wav");
+    rankup_fx = load_sound("../assets/sounds/rankup.wav");
+    gameover_fx = load_sound("../assets/sounds/gameover.wav");
+    error_fx = load_sound("../assets/sounds/error.wav");
+    startup_profiler_end();
+
+    // the tables are optional, they only end the game early
+    startup_profiler_begin("tablebases");
+    position_init();
+    tablebases_open(&game->tablebases, TABLEBASES_PATH);
+    startup_profiler_end();
+
+    if (game->has_engine)
+    {
+        startup_profiler_begin("engine");
+        const search_limits_t limits = {0, 0, game->engine_time_ms ? game->engine_time_ms : ENGINE_PLAYER_DEFAULT_TIME_MS};
+        if (game->uci_command) game->has_engine = game->has_uci_engine = uci_engine_new(&game->uci_engine, game->uci_command);
+        else game->has_engine = engine_player_new(&game->engine, NULL, &limits);
+        startup_profiler_end();
+    }
+
+    // the analysis thread waits idle until the panel is shown
+    startup_profiler_begin("analysis");
+    game->has_analysis = analysis_new(&game->analysis, NULL, game->analysis_lines ? game->analysis_lines : ANALYSIS_DEFAULT_LINES);
+    for (unsigned long i = 0ul; i != ANALYSIS_MAX_LINES; ++i) game->analysis_texts[i] = text_new("../assets/fonts/Lato-Black.ttf", 12, "", TURN);
+    game->analysis_nps_text = text_new("../assets/fonts/Lato-Black.ttf", 12, "", TURN);
+
+    SDL_DisplayMode mode;
+    const char has_refresh_rate = !SDL_GetWindowDisplayMode((SDL_Window *)window->sdl_window, &mode) && mode.refresh_rate > 0;
+    game->analysis_refresh_ms = 1000.0f / (has_refresh_rate ? mode.refresh_rate : 60);
+    startup_profiler_end();
+
+    startup_profiler_end();
 }
 
 void game_reset_state(game_t *game)
 {
+    // everything that belonged to the previous match is dropped at once, the memory is reused as is
+    arena_reset(&game->match_arena);
+
+    game->current_piece = NULL;
+    game->promoted_piece = NULL;
+    game->is_promoting_pawn = FALSE;
+    hide_legal_move_markers(game);
+
     board_restore_state(&game->board);
     scoreboard_reset_state(&game->scoreboard);
 }
 
 void game_update(game_t *game)
 {
+    startup_profiler_begin("first frame");
+
     while (renderer->is_running)
     {
         renderer_update_events_and_delta_time(window, renderer);
@@ -573,22 +1254,49 @@ void game_update(game_t *game)
 #pragma region RENDER OBJECTS
         game->board.draw(&game->board);
 
-        scoreboard_render(&game->scoreboard);
+        // the analysis panel takes the whole strip while it's shown
+        if (game->has_analysis && game->is_analysis_visible)
+        {
+            draw_analysis(game);
+        } else
+        {
+            scoreboard_render(&game->scoreboard);
+            text_draw(game->player_turn_text, (SCREEN_W / 2) - game->player_turn_text->width / 2, SCREEN_H + 14);
 
-        text_draw(game->player_turn_text, (SCREEN_W / 2) - game->player_turn_text->width / 2, SCREEN_H + 14);
+            if (game->clock_ms)
+            {
+                refresh_clock_texts(game);
+                text_draw(game->clock_texts[TRUE], 0 + 15, SCREEN_H + 10);
+                text_draw(game->clock_texts[FALSE], SCREEN_W - game->clock_texts[FALSE]->width - 15, SCREEN_H + 10);
+            }
+        }
 
         draw_legal_moves(game);
 #pragma endregion
 
         // Update current state
         game->current_state = game->current_state->on_state_update(game->current_state, game);
+        update_analysis(game);
+
+        perf_hud_draw();
 
         renderer_present(renderer);
+        perf_frame_end(window->delta_time, window->keys);
+
+        // startup ends once the first frame is on screen
+        startup_profiler_finish();
     }
 
+    // a replay is a benchmark, its numbers are the point of running it
+    if (input_is_replaying()) perf_print_summary(stdout);
+
     // destroy all resources and deallocate memory
+    perf_destroy();
+    input_destroy();
+    font_cache_destroy();
     context_destroy(window, renderer);
     game_destroy(game);
+    bundle_close();
     SDL_Quit();
     TTF_Quit();
     free(window);
@@ -598,14 +1306,15 @@ void game_update(game_t *game)
 void game_destroy(game_t *game)
 {
     board_destroy(&game->board);
-    player_destroy(game->current_player);
     text_destroy(game->player_turn_text);
+    for (unsigned long i = 0ul; i != MAX_PLAYERS; ++i) text_destroy(game->clock_texts[i]);
     scoreboard_destroy(&game->scoreboard);
 
     // free some textures / texts
     text_destroy(gameover_text);
     text_destroy(restart_text);
     texture_destroy(gameover_background);
+    texture_destroy(game->legal_move_markers.dot);
 
     // free sound fx
     Mix_FreeChunk(move_piece_fx);
@@ -616,10 +1325,14 @@ void game_destroy(game_t *game)
     Mix_FreeChunk(castling_fx);
     Mix_FreeChunk(error_fx);
 
-    // free game states
-    for (unsigned long i = 0ul; i < MAX_GAME_STATES; ++i)
-    {
-        free(game->game_states[i]);
-        // game->game_states[i] = NULL; // don't need since we're quitting the game
-    }
+    if (game->has_uci_engine) uci_engine_destroy(&game->uci_engine);
+    else if (game->has_engine) engine_player_destroy(&game->engine);
+    if (game->has_analysis) analysis_destroy(&game->analysis);
+    for (unsigned long i = 0ul; i != ANALYSIS_MAX_LINES; ++i) text_destroy(game->analysis_texts[i]);
+    text_destroy(game->analysis_nps_text);
+    tablebases_close(&game->tablebases);
+
+    // free game states, cells, pieces and players
+    arena_destroy(&game->match_arena);
+    arena_destroy(&game->arena);
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include <input.h>
+#include <private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+
+typedef struct input {
+    int mouse_x, mouse_y;
+    Uint32 buttons;
+    unsigned char keys[SDL_NUM_SCANCODES];
+    Uint32 frame;
+    Uint32 start_ticks;
+
+    FILE *record;
+
+    input_event_t *events;
+    int events_count;
+    int next_event;
+    char is_replay_over;
+} input_t;
+
+static input_t input;
+
+static char load_replay(const char *path)
+{
+    size_t size = 0;
+    char *text = (char *)SDL_LoadFile(path, &size);
+    CHECK(text, FALSE, "Couldn't read input replay file");
+
+    int lines = 1;
+    for (size_t i = 0; i != size; ++i) lines += (text[i] == '\n');
+
+    input.events = (input_event_t *)calloc(lines, sizeof(input_event_t));
+    if (!input.events)
+    {
+        SDL_free(text);
+        return FALSE;
+    }
+
+    for (char *line = text; line && *line;)
+    {
+        char *next = SDL_strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        input_event_t *event = &input.events[input.events_count];
+        char type[MAX_BUFFER_SIZE];
+        int offset = 0;
+
+        if (*line != '#' && SDL_sscanf(line, "%u %u %31s %n", &event->frame, &event->time_ms, type, &offset) == 3)
+        {
+            const char *data = line + offset;
+
+            if (!SDL_strcmp(type, "mouse") && SDL_sscanf(data, "%d %d %u", &event->x, &event->y, &event->buttons) == 3) event->type = input_mouse;
+            else if (!SDL_strcmp(type, "key") && SDL_sscanf(data, "%d %d", &event->x, &event->y) == 2 && event->x >= 0 && event->x < SDL_NUM_SCANCODES) event->type = input_key;
+            else if (!SDL_strcmp(type, "end")) event->type = input_end;
+            else type[0] = '\0';
+
+            // events have to be sorted by frame for the replay to apply them in one pass
+            if (*type && (!input.events_count || event->frame >= input.events[input.events_count - 1].frame)) input.events_count++;
+            else SDL_Log("Skipping invalid input event: %s", line);
+        }
+
+        line = next;
+    }
+
+    SDL_free(text);
+
+    if (!input.events_count || input.events[input.events_count - 1].type != input_end)
+    {
+        SDL_Log("Input replay %s doesn't end with an end event, it will run until the window is closed", path);
+    }
+
+    return TRUE;
+}
+
+void input_new(const char *record_path, const char *replay_path)
+{
+    SDL_memset(&input, 0, sizeof(input_t));
+
+    if (replay_path && !load_replay(replay_path))
+    {
+        SDL_Log("Couldn't load input replay %s, using the real devices", replay_path);
+        free(input.events);
+        input.events = NULL;
+    }
+
+    if (record_path)
+    {
+        input.record = fopen(record_path, "w");
+        if (!input.record) SDL_Log("Couldn't open %s to record input", record_path);
+        else fprintf(input.record, "%s\n", INPUT_RECORD_HEADER);
+    }
+}
+
+static void apply_event(const input_event_t *event)
+{
+    switch (event->type)
+    {
+    case input_mouse:
+        input.mouse_x = event->x;
+        input.mouse_y = event->y;
+        input.buttons = event->buttons;
+        break;
+    case input_key: input.keys[event->x] = event->y ? 1 : 0; break;
+    case input_end: input.is_replay_over = TRUE; break;
+    }
+}
+
+static void record_devices()
+{
+    int mouse_x, mouse_y;
+    const Uint32 buttons = SDL_GetMouseState(&mouse_x, &mouse_y);
+    const Uint8 *keys = SDL_GetKeyboardState(NULL);
+    const Uint32 time_ms = SDL_GetTicks() - input.start_ticks;
+
+    // only the changes are written, most frames have none
+    if (input.record && (!input.frame || mouse_x != input.mouse_x || mouse_y != input.mouse_y || buttons != input.buttons))
+    {
+        fprintf(input.record, "%u %u mouse %d %d %u\n", input.frame, time_ms, mouse_x, mouse_y, buttons);
+    }
+
+    for (unsigned long i = 0ul; i != SDL_NUM_SCANCODES; ++i)
+    {
+        const unsigned char is_pressed = keys[i] ? 1 : 0;
+        if (input.record && is_pressed != input.keys[i]) fprintf(input.record, "%u %u key %lu %u\n", input.frame, time_ms, i, is_pressed);
+        input.keys[i] = is_pressed;
+    }
+
+    input.mouse_x = mouse_x;
+    input.mouse_y = mouse_y;
+    input.buttons = buttons;
+}
+
+char input_update()
+{
+    if (!input.frame) input.start_ticks = SDL_GetTicks();
+
+    if (input.events)
+    {
+        while (input.next_event != input.events_count && input.events[input.next_event].frame <= input.frame) apply_event(&input.events[input.next_event++]);
+    } else
+    {
+        record_devices();
+    }
+
+    input.frame++;
+
+    return !input.is_replay_over;
+}
+
+char input_is_replaying() { return input.events != NULL; }
+
+Uint32 input_get_mouse_state(int *x, int *y)
+{
+    if (x) *x = input.mouse_x;
+    if (y) *y = input.mouse_y;
+
+    return input.buttons;
+}
+
+const unsigned char *input_get_keys() { return input.keys; }
+
+void input_destroy()
+{
+    if (input.record)
+    {
+        // the last frame still ran after the quit event, the replay stops after it too
+        fprintf(input.record, "%u %u end\n", input.frame ? input.frame - 1 : 0, SDL_GetTicks() - input.start_ticks);
+        fclose(input.record);
+    }
+
+    free(input.events);
+    SDL_memset(&input, 0, sizeof(input_t));
+}
@@ -0,0 +1,345 @@
+#include <labeler.h>
+#include <mapped_file.h>
+
+#include <SDL.h>
+
+#include <stdlib.h>
+
+// a finished chunk waiting for the writer
+typedef struct labeler_slot {
+    char* output;
+    size_t length;
+    size_t capacity;
+    long long lines;
+    char is_ready;
+    char is_failed;
+} labeler_slot_t;
+
+typedef struct labeler {
+    const char* text;
+    size_t size;
+    int chunks_count;
+    SDL_atomic_t next_chunk;
+
+    // the workers fill the slots in any order, the writer empties them in chunk order
+    labeler_slot_t* slots;
+    int slots_count;
+    SDL_mutex* lock;
+    SDL_cond* changed;
+    int written_chunks;
+} labeler_t;
+
+typedef struct positions_job {
+    const position_t* positions;
+    position_label_t* labels;
+    int count;
+    SDL_atomic_t next_chunk;
+} positions_job_t;
+
+void labeler_label_position(const position_t* position, position_label_t* label)
+{
+    label->moves_count = position_generate_moves(position, label->moves, FALSE);
+    label->in_check = position_in_check(position);
+    label->outcome = position_get_outcome(position, NULL, 0, &label->reason);
+}
+
+static int positions_worker(void* data)
+{
+    positions_job_t* job = (positions_job_t*)data;
+
+    for (ever)
+    {
+        const int first = SDL_AtomicAdd(&job->next_chunk, 1) * LABELER_POSITIONS_PER_CHUNK;
+        if (first >= job->count) break;
+
+        const int last = SDL_min(first + LABELER_POSITIONS_PER_CHUNK, job->count);
+        for (int i = first; i != last; ++i) labeler_label_position(&job->positions[i], &job->labels[i]);
+    }
+
+    return 0;
+}
+
+void labeler_label_positions(const position_t* positions, position_label_t* labels, int count, int threads)
+{
+    positions_job_t job;
+    SDL_memset(&job, 0, sizeof(positions_job_t));
+    job.positions = positions;
+    job.labels = labels;
+    job.count = count;
+
+    const int threads_count = SDL_max(1, SDL_min(threads, (count + LABELER_POSITIONS_PER_CHUNK - 1) / LABELER_POSITIONS_PER_CHUNK));
+
+    // small batches aren't worth a thread
+    if (threads_count == 1)
+    {
+        positions_worker(&job);
+        return;
+    }
+
+    SDL_Thread** workers = (SDL_Thread**)calloc(threads_count, sizeof(SDL_Thread*));
+    if (!workers)
+    {
+        positions_worker(&job);
+        return;
+    }
+
+    for (int i = 0; i != threads_count; ++i) workers[i] = SDL_CreateThread(positions_worker, "labeler", &job);
+    for (int i = 0; i != threads_count; ++i) SDL_WaitThread(workers[i], NULL);
+
+    free(workers);
+}
+
+#pragma region Text
+static char append(labeler_slot_t* slot, const char* text, size_t length)
+{
+    if (slot->length + length > slot->capacity)
+    {
+        const size_t capacity = SDL_max(slot->capacity * 2, slot->length + length);
+        char* output = (char*)realloc(slot->output, capacity);
+        CHECK(output, FALSE, "Couldn't grow labeler output");
+
+        slot->output = output;
+        slot->capacity = capacity;
+    }
+
+    SDL_memcpy(slot->output + slot->length, text, length);
+    slot->length += length;
+
+    return TRUE;
+}
+
+static char label_line(labeler_slot_t* slot, const char* line, size_t length)
+{
+    // the line isn't terminated, it's part of the whole input
+    char fen[LABELER_MAX_LINE];
+    const size_t fen_length = SDL_min(length, sizeof(fen) - 1);
+    SDL_memcpy(fen, line, fen_length);
+    fen[fen_length] = '\0';
+
+    position_t position;
+    if (length >= sizeof(fen) || !position_from_fen(&position, fen)) return append(slot, line, length) && append(slot, "\terror\n", 7);
+
+    position_label_t label;
+    labeler_label_position(&position, &label);
+
+    char is_appended = append(slot, line, length) && append(slot, "\t", 1);
+
+    for (int i = 0; i != label.moves_count && is_appended; ++i)
+    {
+        char uci[MAX_UCI_SIZE + 1];
+        move_to_uci(label.moves[i], uci);
+
+        const size_t uci_length = SDL_strlen(uci);
+        if (i + 1 != label.moves_count) uci[uci_length] = ' ';
+        is_appended = append(slot, uci, uci_length + (i + 1 != label.moves_count));
+    }
+
+    char status[MAX_BUFFER_SIZE];
+    const int status_length = SDL_snprintf(status, sizeof(status), "\t%i\t%s\t%s\n", label.in_check ? 1 : 0, outcome_to_string(label.outcome), label.reason ? label.reason : "-");
+
+    return is_appended && append(slot, status, status_length);
+}
+
+// a chunk owns the lines starting inside it, even if they end in the next one
+static void label_chunk(const labeler_t* labeler, int chunk, labeler_slot_t* slot)
+{
+    size_t position = (size_t)chunk * LABELER_CHUNK_SIZE;
+    const size_t end = SDL_min(position + LABELER_CHUNK_SIZE, labeler->size);
+
+    while (position && position < end && labeler->text[position - 1] != '\n') position++;
+
+    while (position < end && !slot->is_failed)
+    {
+        size_t length = 0;
+        while (position + length < labeler->size && labeler->text[position + length] != '\n') length++;
+
+        const size_t next = position + length + 1;
+        if (length && labeler->text[position + length - 1] == '\r') length--;
+
+        if (length)
+        {
+            slot->is_failed = !label_line(slot, labeler->text + position, length);
+            slot->lines++;
+        }
+
+        position = next;
+    }
+}
+
+static int text_worker(void* data)
+{
+    labeler_t* labeler = (labeler_t*)data;
+
+    for (ever)
+    {
+        const int chunk = SDL_AtomicAdd(&labeler->next_chunk, 1);
+        if (chunk >= labeler->chunks_count) break;
+
+        // wait for the writer to free the slot this chunk goes to
+        labeler_slot_t* slot = &labeler->slots[chunk % labeler->slots_count];
+
+        SDL_LockMutex(labeler->lock);
+        while (chunk >= labeler->written_chunks + labeler->slots_count) SDL_CondWait(labeler->changed, labeler->lock);
+        SDL_UnlockMutex(labeler->lock);
+
+        slot->length = 0;
+        slot->lines = 0;
+        label_chunk(labeler, chunk, slot);
+
+        SDL_LockMutex(labeler->lock);
+        slot->is_ready = TRUE;
+        SDL_CondBroadcast(labeler->changed);
+        SDL_UnlockMutex(labeler->lock);
+    }
+
+    return 0;
+}
+
+long long labeler_label_text(const char* text, size_t size, FILE* output, int threads)
+{
+    labeler_t labeler;
+    SDL_memset(&labeler, 0, sizeof(labeler_t));
+    labeler.text = text;
+    labeler.size = size;
+    labeler.chunks_count = (int)((size + LABELER_CHUNK_SIZE - 1) / LABELER_CHUNK_SIZE);
+
+    const int threads_count = SDL_max(1, SDL_min(threads, labeler.chunks_count));
+    labeler.slots_count = threads_count * LABELER_SLOTS_PER_THREAD;
+    labeler.slots = (labeler_slot_t*)calloc(labeler.slots_count, sizeof(labeler_slot_t));
+    SDL_Thread** workers = (SDL_Thread**)calloc(threads_count, sizeof(SDL_Thread*));
+
+    if (!labeler.slots || !workers)
+    {
+        SDL_Log("Couldn't allocate labeler buffers");
+        free(labeler.slots);
+        free(workers);
+        return -1;
+    }
+
+    labeler.lock = SDL_CreateMutex();
+    labeler.changed = SDL_CreateCond();
+
+    for (int i = 0; i != threads_count; ++i) workers[i] = SDL_CreateThread(text_worker, "labeler", &labeler);
+
+    // this thread is the only writer: chunks go out in order, one fwrite each
+    long long lines = 0;
+    char is_failed = FALSE;
+
+    for (int chunk = 0; chunk != labeler.chunks_count; ++chunk)
+    {
+        labeler_slot_t* slot = &labeler.slots[chunk % labeler.slots_count];
+
+        SDL_LockMutex(labeler.lock);
+        while (!slot->is_ready) SDL_CondWait(labeler.changed, labeler.lock);
+        SDL_UnlockMutex(labeler.lock);
+
+        is_failed = is_failed || slot->is_failed || fwrite(slot->output, 1, slot->length, output) != slot->length;
+        lines += slot->lines;
+
+        SDL_LockMutex(labeler.lock);
+        slot->is_ready = FALSE;
+        labeler.written_chunks++;
+        SDL_CondBroadcast(labeler.changed);
+        SDL_UnlockMutex(labeler.lock);
+    }
+
+    for (int i = 0; i != threads_count; ++i) SDL_WaitThread(workers[i], NULL);
+
+    for (int i = 0; i != labeler.slots_count; ++i) free(labeler.slots[i].output);
+    free(labeler.slots);
+    free(workers);
+    SDL_DestroyCond(labeler.changed);
+    SDL_DestroyMutex(labeler.lock);
+
+    return is_failed ? -1 : lines;
+}
+#pragma endregion
+
+// stdin can't be mapped, it's read whole
+static char* read_stream(FILE* stream, size_t* size)
+{
+    size_t capacity = LABELER_CHUNK_SIZE;
+    char* text = (char*)malloc(capacity);
+    *size = 0;
+
+    while (text)
+    {
+        *size += fread(text + *size, 1, capacity - *size, stream);
+        if (*size != capacity) break;
+
+        capacity *= 2;
+        char* grown = (char*)realloc(text, capacity);
+        if (!grown) free(text);
+        text = grown;
+    }
+
+    return text;
+}
+
+int labeler_main(int argc, char** argv)
+{
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+    int threads = SDL_GetCPUCount();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--label") && value) input_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--output") && value) output_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--threads") && value) threads = SDL_atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Unknown labeler option: %s\n", argv[i]);
+            input_path = NULL;
+            break;
+        }
+    }
+
+    if (!input_path)
+    {
+        fprintf(stderr, "usage: chess --label <positions.fen | -> [--output file] [--threads n]\n");
+        return 1;
+    }
+
+    position_init();
+
+    mapped_file_t input;
+    SDL_memset(&input, 0, sizeof(mapped_file_t));
+    char* buffer = NULL;
+    size_t size = 0;
+
+    if (!SDL_strcmp(input_path, "-"))
+    {
+        buffer = read_stream(stdin, &size);
+        CHECK(buffer, 1, "Couldn't read positions from stdin");
+    } else if (!mapped_file_open(&input, input_path))
+    {
+        SDL_Log("Couldn't map %s", input_path);
+        return 1;
+    }
+
+    FILE* output = output_path ? fopen(output_path, "wb") : stdout;
+    if (!output)
+    {
+        SDL_Log("Couldn't open labeler output file %s", output_path);
+        free(buffer);
+        mapped_file_close(&input);
+        return 1;
+    }
+
+    const Uint64 start_counter = SDL_GetPerformanceCounter();
+    const long long lines = labeler_label_text(buffer ? buffer : (const char*)input.data, buffer ? size : input.size, output, SDL_max(1, threads));
+    const double seconds = (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency();
+
+    if (output != stdout) fclose(output);
+    else fflush(stdout);
+
+    fprintf(stderr, "label: %lli positions in %.2fs, %.0f positions/s\n", lines, seconds, lines / SDL_max(seconds, 1e-9));
+
+    free(buffer);
+    mapped_file_close(&input);
+
+    return lines >= 0 ? 0 : 1;
+}
@@ -1,12 +1,110 @@
 #define SDL_MAIN_HANDLED
 
+#include <book_builder.h>
+#include <epd.h>
 #include <game.h>
+#include <input.h>
+#include <labeler.h>
+#include <match.h>
+#include <selfplay.h>
+#include <server.h>
+#include <startup_profiler.h>
+#include <tablebase_generator.h>
+#include <tuner.h>
 
 int main(int argc, char **argv)
 {
+    const char *profile_output = NULL;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *engine_side = NULL;
+    const char *uci_command = NULL;
+    unsigned engine_time_ms = 0;
+    unsigned clock_s = 0, clock_increment_s = 0;
+    int clock_moves = 0;
+    char is_analysis_visible = FALSE;
+    int analysis_lines = 0;
+
+    // headless modes never open a window
+    if (argc > 1 && !strcmp(argv[1], "--selfplay")) return selfplay_main(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--match")) return match_main(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--build-book")) return book_builder_main(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--generate-tablebases")) return tablebase_generator_main(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--serve")) return server_main(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--label")) return labeler_main(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--epd")) return epd_main(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--tune")) return tuner_main(argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--profile-startup"))
+        {
+            // an optional path after the flag selects the json output
+            profile_output = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "1";
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc)
+        {
+            record_path = argv[++i];
+        } else if (!strcmp(argv[i], "--replay") && i + 1 < argc)
+        {
+            replay_path = argv[++i];
+        } else if (!strcmp(argv[i], "--engine") && i + 1 < argc)
+        {
+            engine_side = argv[++i];
+        } else if (!strcmp(argv[i], "--uci-engine") && i + 1 < argc)
+        {
+            uci_command = argv[++i];
+        } else if (!strcmp(argv[i], "--clock") && i + 1 < argc)
+        {
+            // seconds[+increment][/moves]: "300+2" is five minutes plus two seconds a move, "5400/40" 90 minutes every 40 moves
+            const char *value = argv[++i];
+            if (SDL_sscanf(value, "%u", &clock_s) == 1)
+            {
+                const char *increment = SDL_strchr(value, '+');
+                const char *moves = SDL_strchr(value, '/');
+                if (increment) clock_increment_s = (unsigned)atoi(increment + 1);
+                if (moves) clock_moves = SDL_max(atoi(moves + 1), 0);
+            }
+        } else if (!strcmp(argv[i], "--engine-time") && i + 1 < argc)
+        {
+            engine_time_ms = (unsigned)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--analysis"))
+        {
+            // an optional number after the flag sets how many lines are shown
+            is_analysis_visible = TRUE;
+            if (i + 1 < argc && argv[i + 1][0] != '-') analysis_lines = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--headless"))
+        {
+            // no window on screen nor sound device, the software renderer draws into the dummy framebuffer
+            SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+            SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        }
+    }
+
+    // a replay reproduces the input frame by frame, the clocks and the engine's searches run on the wall clock and
+    // would play out differently on every run
+    if (replay_path && (clock_s || engine_side || uci_command))
+    {
+        SDL_Log("--replay can't be combined with --clock, --engine or --uci-engine, they depend on the wall clock");
+        return 1;
+    }
+
+    startup_profiler_init(profile_output);
+    input_new(record_path, replay_path);
+
     game_t game;
     memset(&game, 0, sizeof(game_t));
 
+    // the engine plays the given side, the human the other one. An external engine plays black unless told otherwise
+    game.has_engine = (engine_side && (!strcmp(engine_side, "white") || !strcmp(engine_side, "black"))) || uci_command;
+    game.is_engine_white = engine_side && !strcmp(engine_side, "white");
+    game.uci_command = uci_command;
+    game.clock_ms = clock_s * 1000u;
+    game.clock_increment_ms = clock_increment_s * 1000u;
+    game.clock_moves = clock_moves;
+    game.engine_time_ms = engine_time_ms;
+    game.is_analysis_visible = is_analysis_visible;
+    game.analysis_lines = analysis_lines;
+
     game_init(&game);
     game_update(&game);
 
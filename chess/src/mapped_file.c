@@ -0,0 +1,72 @@
+#include <mapped_file.h>
+#include <private.h>
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+char mapped_file_open(mapped_file_t* file, const char* path)
+{
+    SDL_memset(file, 0, sizeof(mapped_file_t));
+
+#ifdef _WIN32
+    file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if ((HANDLE)file->file == INVALID_HANDLE_VALUE)
+    {
+        file->file = NULL;
+        return FALSE;
+    }
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx((HANDLE)file->file, &file_size);
+    file->size = (size_t)file_size.QuadPart;
+
+    file->mapping = CreateFileMappingA((HANDLE)file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file->mapping) file->data = (const unsigned char*)MapViewOfFile((HANDLE)file->mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return FALSE;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return FALSE;
+    }
+
+    file->size = (size_t)st.st_size;
+
+    // the mapping stays valid after closing the descriptor
+    void* data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data != MAP_FAILED) file->data = (const unsigned char*)data;
+#endif
+
+    if (!file->data)
+    {
+        mapped_file_close(file);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void mapped_file_close(mapped_file_t* file)
+{
+#ifdef _WIN32
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->mapping) CloseHandle((HANDLE)file->mapping);
+    if (file->file) CloseHandle((HANDLE)file->file);
+#else
+    if (file->data) munmap((void*)file->data, file->size);
+#endif
+    SDL_memset(file, 0, sizeof(mapped_file_t));
+}
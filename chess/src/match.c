@@ -0,0 +1,292 @@
+#include <match.h>
+#include <openings.h>
+#include <selfplay.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef enum sprt_verdict { sprt_running = 0, sprt_h0, sprt_h1 } sprt_verdict_t;
+
+typedef struct match {
+    match_options_t options;
+    openings_t openings;
+    book_t book;
+    tablebases_t tablebases;
+    SDL_atomic_t next_pair;
+    SDL_atomic_t stop;
+    char date[MAX_PGN_TAG_SIZE]; // read once before the workers start, localtime isn't thread safe
+
+    // shared between workers, only touched with the lock held
+    SDL_mutex* lock;
+    FILE* output;
+    int wins, draws, losses; // from engine a point of view
+    double llr;
+    sprt_verdict_t verdict;
+    Uint64 start_counter;
+} match_t;
+
+static double elo_to_score(double elo) { return 1.0 / (1.0 + SDL_pow(10.0, -elo / 400.0)); }
+
+static double score_to_elo(double score)
+{
+    score = SDL_min(SDL_max(score, 1e-6), 1.0 - 1e-6);
+    return -400.0 * SDL_log10(1.0 / score - 1.0);
+}
+
+// mean score and its per game variance
+static double get_score(double wins, double draws, double losses, double* variance)
+{
+    const double games = wins + draws + losses;
+    const double win = wins / games, draw = draws / games, loss = losses / games;
+    const double score = win + draw / 2.0;
+
+    *variance = win * (1.0 - score) * (1.0 - score) + draw * (0.5 - score) * (0.5 - score) + loss * score * score;
+    return score;
+}
+
+// log likelihood ratio of h1 against h0, normal approximation of the trinomial results
+static double get_llr(const match_t* match)
+{
+    if (!(match->wins + match->draws + match->losses)) return 0.0;
+
+    // the pseudo counts regularize the trinomial: a match that only ever wins, or never draws, still gets a finite
+    // positive variance and its llr moves towards a bound instead of sitting at zero forever
+    const double wins = match->wins + MATCH_SPRT_PSEUDO_COUNT, draws = match->draws + MATCH_SPRT_PSEUDO_COUNT, losses = match->losses + MATCH_SPRT_PSEUDO_COUNT;
+    const double games = wins + draws + losses;
+
+    double variance = 0.0;
+    const double score = get_score(wins, draws, losses, &variance);
+
+    const double score0 = elo_to_score(match->options.elo0), score1 = elo_to_score(match->options.elo1);
+    return games * (score1 - score0) * (2.0 * score - score0 - score1) / (2.0 * variance);
+}
+
+static double get_elo(const match_t* match, double* error)
+{
+    const int games = match->wins + match->draws + match->losses;
+    *error = 0.0;
+    if (!games) return 0.0;
+
+    double variance = 0.0;
+    const double score = get_score(match->wins, match->draws, match->losses, &variance);
+
+    // 95% confidence interval
+    const double margin = 1.959964 * SDL_sqrt(variance / games);
+    *error = (score_to_elo(score + margin) - score_to_elo(score - margin)) / 2.0;
+
+    return score_to_elo(score);
+}
+
+static void print_status(const match_t* match, FILE* stream)
+{
+    const double lower = SDL_log(match->options.beta / (1.0 - match->options.alpha));
+    const double upper = SDL_log((1.0 - match->options.beta) / match->options.alpha);
+
+    double error = 0.0;
+    const double elo = get_elo(match, &error);
+
+    fprintf(stream, "match: %i games, %s vs %s: +%i -%i =%i, elo %.1f +/- %.1f, llr %.2f [%.2f, %.2f]\n", match->wins + match->draws + match->losses, match->options.engines[0].name,
+            match->options.engines[1].name, match->wins, match->losses, match->draws, elo, error, match->llr, lower, upper);
+}
+
+static void record_game(match_t* match, const pgn_game_t* game, char is_engine_a_white, const char* pgn, int pgn_length)
+{
+    SDL_LockMutex(match->lock);
+
+    if (pgn_length > 0) fwrite(pgn, 1, pgn_length, match->output);
+
+    if (game->outcome == outcome_draw) match->draws++;
+    else if ((game->outcome == outcome_white_wins) == is_engine_a_white) match->wins++;
+    else match->losses++;
+
+    match->llr = get_llr(match);
+
+    // stop as soon as one hypothesis is accepted, the games still running are thrown away
+    if (match->verdict == sprt_running)
+    {
+        if (match->llr >= SDL_log((1.0 - match->options.beta) / match->options.alpha)) match->verdict = sprt_h1;
+        else if (match->llr <= SDL_log(match->options.beta / (1.0 - match->options.alpha))) match->verdict = sprt_h0;
+
+        if (match->verdict != sprt_running) SDL_AtomicSet(&match->stop, TRUE);
+    }
+
+    if ((match->wins + match->draws + match->losses) % 10 == 0) print_status(match, stderr);
+
+    SDL_UnlockMutex(match->lock);
+}
+
+static int match_worker(void* data)
+{
+    match_t* match = (match_t*)data;
+    const match_options_t* options = &match->options;
+
+    search_t* searches[MAX_PLAYERS] = {(search_t*)malloc(sizeof(search_t)), (search_t*)malloc(sizeof(search_t))};
+    pgn_game_t* game = (pgn_game_t*)malloc(sizeof(pgn_game_t));
+    char* pgn = (char*)malloc(PGN_BUFFER_SIZE);
+
+    if (searches[0] && searches[1] && game && pgn)
+    {
+        search_new(searches[0], &options->engines[0].params);
+        search_new(searches[1], &options->engines[1].params);
+        searches[0]->tablebases = searches[1]->tablebases = options->tablebases_path ? &match->tablebases : NULL;
+
+        const int pairs_count = (options->max_games + 1) / 2;
+
+        // each pair plays the same opening twice with colors reversed, so that unbalanced openings cancel out
+        for (ever)
+        {
+            const int pair = SDL_AtomicAdd(&match->next_pair, 1);
+            if (pair >= pairs_count || SDL_AtomicGet(&match->stop)) break;
+
+            position_t start;
+            if (match->openings.count) start = match->openings.positions[pair % match->openings.count];
+            else position_set_start(&start);
+
+            engine_game_options_t game_options;
+            SDL_memset(&game_options, 0, sizeof(engine_game_options_t));
+            game_options.random_plies = options->random_plies;
+            game_options.max_plies = options->max_plies;
+            game_options.seed = options->seed ^ ((unsigned long long)(pair + 1) * 0x9E3779B97F4A7C15ull);
+            game_options.stop = &match->stop;
+            game_options.book = options->book_path ? &match->book : NULL;
+            game_options.book_selection = options->book_selection;
+            game_options.tablebases = options->tablebases_path ? &match->tablebases : NULL;
+
+            for (int round = 0; round != 2; ++round)
+            {
+                // searches and limits are indexed by is_white
+                const char is_engine_a_white = (round == 0);
+                search_t* players[MAX_PLAYERS] = {is_engine_a_white ? searches[1] : searches[0], is_engine_a_white ? searches[0] : searches[1]};
+                const search_limits_t* limits[MAX_PLAYERS] = {&options->engines[is_engine_a_white ? 1 : 0].limits, &options->engines[is_engine_a_white ? 0 : 1].limits};
+
+                if (!engine_game_play(game, &start, players, limits, &game_options)) break;
+
+                SDL_strlcpy(game->event, "Engine match", sizeof(game->event));
+                SDL_strlcpy(game->white, options->engines[is_engine_a_white ? 0 : 1].name, sizeof(game->white));
+                SDL_strlcpy(game->black, options->engines[is_engine_a_white ? 1 : 0].name, sizeof(game->black));
+                SDL_strlcpy(game->date, match->date, sizeof(game->date));
+                game->round = pair * 2 + round + 1;
+
+                record_game(match, game, is_engine_a_white, pgn, pgn_write_game(game, pgn, PGN_BUFFER_SIZE));
+            }
+        }
+    } else
+    {
+        SDL_Log("Couldn't allocate memory for match worker");
+    }
+
+    free(searches[0]);
+    free(searches[1]);
+    free(game);
+    free(pgn);
+
+    return 0;
+}
+
+static char parse_options(match_options_t* options, int argc, char** argv)
+{
+    SDL_memset(options, 0, sizeof(match_options_t));
+    options->max_games = MATCH_DEFAULT_GAMES;
+    options->threads = SDL_GetCPUCount();
+    options->random_plies = -1;
+    options->max_plies = SELFPLAY_DEFAULT_MAX_PLIES;
+    options->seed = 1;
+    options->output_path = MATCH_DEFAULT_OUTPUT;
+    options->elo0 = MATCH_DEFAULT_ELO0;
+    options->elo1 = MATCH_DEFAULT_ELO1;
+    options->alpha = MATCH_DEFAULT_ALPHA;
+    options->beta = MATCH_DEFAULT_BETA;
+
+    const char* specs[MAX_PLAYERS] = {"name=a", "name=b"};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--match"))
+        {
+            if (value && value[0] != '-') options->max_games = SDL_atoi(argv[++i]);
+        } else if (!SDL_strcmp(argv[i], "--engine-a") && value) specs[0] = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--engine-b") && value) specs[1] = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--threads") && value) options->threads = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--openings") && value) options->openings_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--book") && value) options->book_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--book-keys") && value) options->book_keys_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--book-best")) options->book_selection = book_best;
+        else if (!SDL_strcmp(argv[i], "--tablebases") && value) options->tablebases_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--random-plies") && value) options->random_plies = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--max-plies") && value) options->max_plies = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--elo0") && value) options->elo0 = SDL_atof(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--elo1") && value) options->elo1 = SDL_atof(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--alpha") && value) options->alpha = SDL_atof(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--beta") && value) options->beta = SDL_atof(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--seed") && value) options->seed = SDL_strtoull(argv[++i], NULL, 10);
+        else if (!SDL_strcmp(argv[i], "--pgn") && value) options->output_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Unknown match option: %s\n", argv[i]);
+            return FALSE;
+        }
+    }
+
+    for (int i = 0; i != MAX_PLAYERS; ++i)
+    {
+        if (!engine_config_parse(&options->engines[i], specs[i])) return FALSE;
+        if (!options->engines[i].limits.depth && !options->engines[i].limits.nodes && !options->engines[i].limits.time_ms) options->engines[i].limits.depth = SELFPLAY_DEFAULT_DEPTH;
+    }
+
+    if (options->random_plies < 0) options->random_plies = (options->openings_path || options->book_path) ? 0 : SELFPLAY_DEFAULT_RANDOM_PLIES;
+    options->threads = SDL_max(1, options->threads);
+
+    return options->max_games > 0 && options->elo1 > options->elo0 && options->alpha > 0.0 && options->beta > 0.0;
+}
+
+int match_main(int argc, char** argv)
+{
+    match_t match;
+    SDL_memset(&match, 0, sizeof(match_t));
+
+    if (!parse_options(&match.options, argc, argv))
+    {
+        fprintf(stderr, "usage: chess --match [games] --engine-a name=a,depth=5,nodes=0,time=0,eval=file --engine-b ... [--threads n] [--openings file] [--book file] [--book-keys file] [--book-best] [--tablebases dir] [--random-plies n] [--max-plies n] "
+                        "[--elo0 x] [--elo1 x] [--alpha x] [--beta x] [--seed n] [--pgn file]\n");
+        return 1;
+    }
+
+    position_init();
+
+    if (match.options.openings_path && !openings_load(&match.openings, match.options.openings_path)) return 1;
+    if (match.options.book_path && !book_open(&match.book, match.options.book_path, match.options.book_keys_path)) return 1;
+    if (match.options.tablebases_path && !tablebases_open(&match.tablebases, match.options.tablebases_path)) return 1;
+
+    match.output = fopen(match.options.output_path, "wb");
+    CHECK(match.output, 1, "Couldn't open match output file");
+
+    match.lock = SDL_CreateMutex();
+    pgn_get_date(match.date, sizeof(match.date));
+    match.start_counter = SDL_GetPerformanceCounter();
+
+    const int threads_count = SDL_min(match.options.threads, (match.options.max_games + 1) / 2);
+    SDL_Thread** threads = (SDL_Thread**)calloc(threads_count, sizeof(SDL_Thread*));
+
+    for (int i = 0; i != threads_count; ++i) threads[i] = SDL_CreateThread(match_worker, "match", &match);
+    for (int i = 0; i != threads_count; ++i) SDL_WaitThread(threads[i], NULL);
+
+    const double seconds = (double)(SDL_GetPerformanceCounter() - match.start_counter) / SDL_GetPerformanceFrequency();
+
+    print_status(&match, stdout);
+    printf("match: %s after %.1fs on %i threads -> %s\n",
+           match.verdict == sprt_h1   ? "H1 accepted, engine a is stronger"
+           : match.verdict == sprt_h0 ? "H0 accepted, engine a is not stronger"
+                                      : "no verdict",
+           seconds, threads_count, match.options.output_path);
+
+    free(threads);
+    SDL_DestroyMutex(match.lock);
+    fclose(match.output);
+    openings_destroy(&match.openings);
+    book_close(&match.book);
+    tablebases_close(&match.tablebases);
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <openings.h>
+
+#include <SDL.h>
+
+#include <stdio.h>
+
+char openings_load(openings_t* openings, const char* path)
+{
+    SDL_memset(openings, 0, sizeof(openings_t));
+
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(path, &size);
+    CHECK(text, FALSE, "Couldn't read openings file");
+
+    // one position per line at most
+    int lines = 1;
+    for (size_t i = 0; i != size; ++i) lines += (text[i] == '\n');
+
+    openings->positions = (position_t*)SDL_malloc(sizeof(position_t) * lines);
+    if (!openings->positions)
+    {
+        SDL_free(text);
+        return FALSE;
+    }
+
+    for (char* line = text; line && *line;)
+    {
+        char* next = SDL_strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        while (*line == ' ' || *line == '\t') line++;
+
+        if (*line && *line != '#' && *line != '\r')
+        {
+            if (position_from_fen(&openings->positions[openings->count], line)) openings->count++;
+            else SDL_Log("Skipping invalid opening: %s", line);
+        }
+
+        line = next;
+    }
+
+    SDL_free(text);
+
+    if (!openings->count) openings_destroy(openings);
+    CHECK(openings->count, FALSE, "Openings file has no valid position");
+
+    return TRUE;
+}
+
+void openings_destroy(openings_t* openings)
+{
+    SDL_free(openings->positions);
+    SDL_memset(openings, 0, sizeof(openings_t));
+}
@@ -0,0 +1,263 @@
+#include <perf_hud.h>
+#include <private.h>
+#include <text.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+extern renderer_t *renderer;
+
+typedef struct perf {
+    perf_frame_t current;
+    perf_frame_t history[PERF_HISTORY_SIZE];
+    unsigned long long frames_count;
+    unsigned long long movegen_start;
+
+    char is_hud_visible;
+    char was_toggle_pressed;
+    char is_inside_hud; // the overlay's own text updates and draws aren't the game's, nothing is counted meanwhile
+    float since_hud_refresh_ms;
+    render_text_t *hud_lines[PERF_HUD_LINES];
+
+    FILE *dump;
+    char is_dump_json;
+
+    char keeps_summary;
+    perf_summary_t summary;
+} perf_t;
+
+static perf_t perf;
+
+static int compare_floats(const void *a, const void *b)
+{
+    const float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+void perf_new(char keep_summary)
+{
+    SDL_memset(&perf, 0, sizeof(perf_t));
+    perf.keeps_summary = keep_summary;
+
+    const char *dump_path = SDL_getenv(PERF_DUMP_ENV);
+    if (!dump_path || !*dump_path) return;
+
+    perf.dump = fopen(dump_path, "w");
+    if (!perf.dump)
+    {
+        SDL_Log("Couldn't open %s to dump frame statistics", dump_path);
+        return;
+    }
+
+    const size_t len = SDL_strlen(dump_path);
+    perf.is_dump_json = len > 5 && !SDL_strcmp(dump_path + len - 5, ".json");
+
+    if (perf.is_dump_json)
+        fprintf(perf.dump, "[\n");
+    else
+        fprintf(perf.dump, "frame,frame_ms,draw_calls,texture_uploads,text_updates,glyph_rasterizations,allocations,moves,movegen_ms\n");
+}
+
+void perf_count(perf_counter_t counter)
+{
+    if (!perf.is_inside_hud) perf.current.counters[counter]++;
+}
+
+void perf_movegen_begin() { perf.movegen_start = SDL_GetPerformanceCounter(); }
+
+void perf_movegen_end() { perf.current.movegen_ms += (float)((SDL_GetPerformanceCounter() - perf.movegen_start) * 1000.0 / SDL_GetPerformanceFrequency()); }
+
+static void dump_frame(const perf_frame_t *frame)
+{
+    const unsigned *c = frame->counters;
+
+    if (perf.is_dump_json)
+    {
+        fprintf(perf.dump,
+                "%s  {\"frame\": %llu, \"frame_ms\": %.3f, \"draw_calls\": %u, \"texture_uploads\": %u, \"text_updates\": %u, \"glyph_rasterizations\": %u, \"allocations\": %u, \"moves\": %u, \"movegen_ms\": %.3f}",
+                perf.frames_count ? ",\n" : "",
+                perf.frames_count,
+                frame->frame_ms,
+                c[perf_draw_calls],
+                c[perf_texture_uploads],
+                c[perf_text_updates],
+                c[perf_glyph_rasterizations],
+                c[perf_allocations],
+                c[perf_moves],
+                frame->movegen_ms);
+    } else
+    {
+        fprintf(perf.dump, "%llu,%.3f,%u,%u,%u,%u,%u,%u,%.3f\n", perf.frames_count, frame->frame_ms, c[perf_draw_calls], c[perf_texture_uploads], c[perf_text_updates], c[perf_glyph_rasterizations], c[perf_allocations], c[perf_moves], frame->movegen_ms);
+    }
+}
+
+static void add_to_summary(const perf_frame_t *frame)
+{
+    perf_summary_t *summary = &perf.summary;
+
+    if (summary->frames_count == summary->capacity)
+    {
+        const unsigned long long capacity = SDL_max(summary->capacity * 2, (unsigned long long)PERF_HISTORY_SIZE);
+        float *frame_times = (float *)realloc(summary->frame_times, sizeof(float) * capacity);
+        if (!frame_times) return;
+
+        summary->frame_times = frame_times;
+        summary->capacity = capacity;
+    }
+
+    summary->frame_times[summary->frames_count++] = frame->frame_ms;
+    summary->total_ms += frame->frame_ms;
+    summary->total_movegen_ms += frame->movegen_ms;
+    summary->max_movegen_ms = SDL_max(summary->max_movegen_ms, frame->movegen_ms);
+
+    if (frame->counters[perf_moves])
+    {
+        summary->move_frames_count++;
+        summary->move_frames_ms += frame->frame_ms;
+        summary->max_move_frame_ms = SDL_max(summary->max_move_frame_ms, frame->frame_ms);
+    }
+
+    for (unsigned long i = 0ul; i != MAX_PERF_COUNTERS; ++i) summary->counters[i] += frame->counters[i];
+}
+
+static void refresh_hud()
+{
+    const unsigned long samples = (unsigned long)SDL_min(perf.frames_count, (unsigned long long)PERF_HISTORY_SIZE);
+    if (samples == 0) return;
+
+    float frame_times[PERF_HISTORY_SIZE];
+    float max_movegen_ms = 0.0f;
+    unsigned max_counters[MAX_PERF_COUNTERS] = {0};
+
+    for (unsigned long i = 0ul; i != samples; ++i)
+    {
+        const perf_frame_t *frame = &perf.history[i];
+        frame_times[i] = frame->frame_ms;
+        max_movegen_ms = SDL_max(max_movegen_ms, frame->movegen_ms);
+
+        for (unsigned long c = 0ul; c != MAX_PERF_COUNTERS; ++c)
+        {
+            max_counters[c] = SDL_max(max_counters[c], frame->counters[c]);
+        }
+    }
+
+    qsort(frame_times, samples, sizeof(float), compare_floats);
+
+    // the last frame tells what happens now, the max over the history catches the spikes
+    const perf_frame_t *last = &perf.history[(perf.frames_count - 1) % PERF_HISTORY_SIZE];
+    const unsigned *c = last->counters;
+
+    char buffer[PERF_HUD_LINES][MAX_BUFFER_SIZE];
+    SDL_snprintf(buffer[0], MAX_BUFFER_SIZE, "FRAME p50 %.2f p90 %.2f p99 %.2f max %.2f", frame_times[samples / 2], frame_times[samples * 9 / 10], frame_times[samples * 99 / 100], frame_times[samples - 1]);
+    SDL_snprintf(buffer[1], MAX_BUFFER_SIZE, "DRAW CALLS %u (max %u)", c[perf_draw_calls], max_counters[perf_draw_calls]);
+    SDL_snprintf(buffer[2], MAX_BUFFER_SIZE, "TEXTURE UPLOADS %u (max %u)", c[perf_texture_uploads], max_counters[perf_texture_uploads]);
+    SDL_snprintf(buffer[3], MAX_BUFFER_SIZE, "TEXT UPDATES %u RASTERIZED %u (max %u)", c[perf_text_updates], c[perf_glyph_rasterizations], max_counters[perf_text_updates]);
+    SDL_snprintf(buffer[4], MAX_BUFFER_SIZE, "MOVEGEN %.3f ms (max %.3f)", last->movegen_ms, max_movegen_ms);
+
+    for (unsigned long i = 0ul; i != PERF_HUD_LINES; ++i)
+    {
+        if (!perf.hud_lines[i])
+            perf.hud_lines[i] = text_new("../assets/fonts/Lato-Black.ttf", 12, buffer[i], TURN);
+        else
+            text_update(perf.hud_lines[i], buffer[i]);
+    }
+}
+
+void perf_frame_end(float frame_ms, const unsigned char *keys)
+{
+    // F1 toggles the overlay on the press edge only
+    const char is_toggle_pressed = keys && keys[SDL_SCANCODE_F1];
+    if (is_toggle_pressed && !perf.was_toggle_pressed)
+    {
+        perf.is_hud_visible = !perf.is_hud_visible;
+        perf.since_hud_refresh_ms = PERF_HUD_REFRESH_MS;
+    }
+    perf.was_toggle_pressed = is_toggle_pressed;
+
+    perf.current.frame_ms = frame_ms;
+    perf.history[perf.frames_count % PERF_HISTORY_SIZE] = perf.current;
+
+    if (perf.dump) dump_frame(&perf.current);
+    if (perf.keeps_summary) add_to_summary(&perf.current);
+
+    perf.frames_count++;
+    SDL_memset(&perf.current, 0, sizeof(perf_frame_t));
+
+    // refreshing the hud a few times per second keeps it readable and cheap
+    perf.since_hud_refresh_ms += frame_ms;
+    if (perf.is_hud_visible && perf.since_hud_refresh_ms >= PERF_HUD_REFRESH_MS)
+    {
+        perf.is_inside_hud = TRUE;
+        refresh_hud();
+        perf.is_inside_hud = FALSE;
+        perf.since_hud_refresh_ms = 0.0f;
+    }
+}
+
+void perf_hud_draw()
+{
+    if (!perf.is_hud_visible || !perf.hud_lines[0]) return;
+
+    SDL_Renderer *native_renderer = (SDL_Renderer *)renderer->sdl_renderer;
+
+    int width = 0, height = 0;
+    for (unsigned long i = 0ul; i != PERF_HUD_LINES; ++i)
+    {
+        width = SDL_max(width, perf.hud_lines[i]->width);
+        height += perf.hud_lines[i]->height;
+    }
+
+    const SDL_Rect background = {4, 4, width + 8, height + 8};
+    SDL_SetRenderDrawColor(native_renderer, 0, 0, 0, 190);
+    SDL_RenderFillRect(native_renderer, &background);
+
+    perf.is_inside_hud = TRUE;
+    int pen_y = background.y + 4;
+    for (unsigned long i = 0ul; i != PERF_HUD_LINES; ++i)
+    {
+        text_draw(perf.hud_lines[i], background.x + 4, pen_y);
+        pen_y += perf.hud_lines[i]->height;
+    }
+    perf.is_inside_hud = FALSE;
+}
+
+void perf_print_summary(FILE *stream)
+{
+    perf_summary_t *summary = &perf.summary;
+    const unsigned long long frames = summary->frames_count;
+    if (!frames) return;
+
+    qsort(summary->frame_times, (size_t)frames, sizeof(float), compare_floats);
+
+    const float *times = summary->frame_times;
+    const unsigned long long *c = summary->counters;
+
+    fprintf(stream, "frames: %llu in %.2f s, %.1f fps\n", frames, summary->total_ms / 1000.0, frames * 1000.0 / SDL_max(summary->total_ms, 1e-9));
+    fprintf(stream, "frame ms: mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", summary->total_ms / frames, times[frames / 2], times[frames * 9 / 10], times[frames * 99 / 100], times[frames - 1]);
+    fprintf(stream, "moves: %llu, frame ms mean %.3f max %.3f\n", c[perf_moves], summary->move_frames_count ? summary->move_frames_ms / summary->move_frames_count : 0.0, summary->max_move_frame_ms);
+    fprintf(stream, "movegen ms: total %.3f max %.3f\n", summary->total_movegen_ms, summary->max_movegen_ms);
+    fprintf(stream, "per frame: draw calls %.1f, texture uploads %.2f, text updates %.2f, glyph rasterizations %.2f, allocations %.2f\n",
+            (double)c[perf_draw_calls] / frames, (double)c[perf_texture_uploads] / frames, (double)c[perf_text_updates] / frames, (double)c[perf_glyph_rasterizations] / frames, (double)c[perf_allocations] / frames);
+    fprintf(stream, "allocations: %llu\n", c[perf_allocations]);
+}
+
+void perf_destroy()
+{
+    for (unsigned long i = 0ul; i != PERF_HUD_LINES; ++i)
+    {
+        if (perf.hud_lines[i]) text_destroy(perf.hud_lines[i]);
+    }
+
+    if (perf.dump)
+    {
+        if (perf.is_dump_json) fprintf(perf.dump, "\n]\n");
+        fclose(perf.dump);
+    }
+
+    free(perf.summary.frame_times);
+
+    SDL_memset(&perf, 0, sizeof(perf_t));
+}
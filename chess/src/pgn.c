@@ -0,0 +1,91 @@
+#include <pgn.h>
+
+#include <SDL.h>
+
+#include <time.h>
+
+void pgn_game_new(pgn_game_t* game, const position_t* start)
+{
+    SDL_memset(game, 0, sizeof(pgn_game_t));
+    SDL_strlcpy(game->event, "?", sizeof(game->event));
+    SDL_strlcpy(game->white, "?", sizeof(game->white));
+    SDL_strlcpy(game->black, "?", sizeof(game->black));
+    SDL_strlcpy(game->date, "????.??.??", sizeof(game->date));
+
+    position_t initial;
+    position_set_start(&initial);
+
+    if (start && start->hash != initial.hash) position_to_fen(start, game->fen, sizeof(game->fen));
+}
+
+void pgn_get_date(char* date, size_t size)
+{
+    const time_t now = time(NULL);
+    const struct tm* local = localtime(&now);
+    if (!local || !strftime(date, size, "%Y.%m.%d", local)) SDL_strlcpy(date, "????.??.??", size);
+}
+
+// appends formatted text and keeps track of the remaining space
+static char append(char* buffer, size_t size, int* length, const char* fmt, ...)
+{
+    if (*length < 0) return FALSE;
+
+    va_list args;
+    va_start(args, fmt);
+    const int written = SDL_vsnprintf(buffer + *length, size - *length, fmt, args);
+    va_end(args);
+
+    if (written < 0 || (size_t)(*length + written) >= size)
+    {
+        *length = -1;
+        return FALSE;
+    }
+
+    *length += written;
+    return TRUE;
+}
+
+int pgn_write_game(const pgn_game_t* game, char* buffer, size_t size)
+{
+    int length = 0;
+
+    append(buffer, size, &length, "[Event \"%s\"]\n[Site \"?\"]\n[Date \"%s\"]\n[Round \"%i\"]\n", game->event, game->date, game->round);
+    append(buffer, size, &length, "[White \"%s\"]\n[Black \"%s\"]\n[Result \"%s\"]\n", game->white, game->black, outcome_to_string(game->outcome));
+    if (game->fen[0]) append(buffer, size, &length, "[SetUp \"1\"]\n[FEN \"%s\"]\n", game->fen);
+    append(buffer, size, &length, "[PlyCount \"%i\"]\n", game->moves_count);
+    if (game->termination[0]) append(buffer, size, &length, "[Termination \"%s\"]\n", game->termination);
+    append(buffer, size, &length, "\n");
+
+    position_t position;
+    if (!game->fen[0] || !position_from_fen(&position, game->fen)) position_set_start(&position);
+
+    // replay the game to write each move in san, wrapping lines like most pgn tools do
+    int line_length = 0;
+    for (int i = 0; i != game->moves_count; ++i)
+    {
+        char token[MAX_SAN_SIZE + 16];
+        char san[MAX_SAN_SIZE];
+        position_move_to_san(&position, game->moves[i], san);
+
+        if (position.is_white_to_move) SDL_snprintf(token, sizeof(token), "%i. %s", position.fullmove_number, san);
+        else if (i == 0) SDL_snprintf(token, sizeof(token), "%i... %s", position.fullmove_number, san);
+        else SDL_snprintf(token, sizeof(token), "%s", san);
+
+        const int token_length = (int)SDL_strlen(token);
+        if (line_length && line_length + 1 + token_length > PGN_LINE_WIDTH)
+        {
+            append(buffer, size, &length, "\n");
+            line_length = 0;
+        }
+
+        append(buffer, size, &length, line_length ? " %s" : "%s", token);
+        line_length += token_length + (line_length ? 1 : 0);
+
+        undo_t undo;
+        position_make_move(&position, game->moves[i], &undo);
+    }
+
+    append(buffer, size, &length, line_length ? " %s\n\n" : "%s\n\n", outcome_to_string(game->outcome));
+
+    return length;
+}
@@ -5,13 +5,11 @@
 
 static const char* _get_team(struct player player) { return player.is_white ? "WHITE" : "BLACK"; }
 
-player_t* player_new(char is_white)
+player_t* player_new(arena_t* arena, char is_white)
 {
-    player_t* player = (player_t*)calloc(1, sizeof(player_t));
+    player_t* player = (player_t*)arena_alloc(arena, sizeof(player_t));
     CHECK(player, NULL, "Couldn't allocate memory for player struct");
     player->is_white = is_white;
     player->get_team = _get_team;
     return player;
-}
-
-void player_destroy(player_t* player) { free(player); }
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,1018 @@
+#include <position.h>
+
+#include <SDL.h>
+
+#include <limits.h>
+
+#define ROW(index) ((index) / CELLS_PER_ROW)
+#define COLUMN(index) ((index) % CELLS_PER_ROW)
+#define PIECE_TYPE(square) ((piece_type_t)((square) < 0 ? -(square) : (square)))
+#define IS_WHITE(square) ((square) > 0)
+
+// north, south, west, east then the diagonals: the first four are rook rays, the others bishop rays
+static const int direction_offsets[MAX_DIR] = {-8, 8, -1, 1, -9, -7, 7, 9};
+
+static int ray_lengths[BOARD_SZ][MAX_DIR];
+static int knight_targets[BOARD_SZ][8], knight_targets_count[BOARD_SZ];
+static int king_targets[BOARD_SZ][8], king_targets_count[BOARD_SZ];
+
+// castling rights that survive a move from or to a cell
+static unsigned char castling_masks[BOARD_SZ];
+
+// zobrist keys: [piece][cell] with white pieces first, then castling, en passant column and side
+static unsigned long long piece_keys[12][BOARD_SZ];
+static unsigned long long castling_keys[16];
+static unsigned long long enpassant_keys[CELLS_PER_ROW];
+static unsigned long long side_key;
+
+static char is_initialized = FALSE;
+
+static const char piece_letters[] = " RNBQKP";
+
+static unsigned long long split_mix(unsigned long long* state)
+{
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static int piece_key_index(signed char square) { return IS_WHITE(square) ? square - 1 : 5 - square; }
+
+static void add_target(int targets[8], int* count, int index, int row_offset, int column_offset)
+{
+    const int row = ROW(index) + row_offset, column = COLUMN(index) + column_offset;
+    if (row < 0 || row >= CELLS_PER_ROW || column < 0 || column >= CELLS_PER_ROW) return;
+
+    targets[(*count)++] = row * CELLS_PER_ROW + column;
+}
+
+void position_init()
+{
+    if (is_initialized) return;
+
+    static const int knight_jumps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+    static const int king_steps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        const int row = ROW(i), column = COLUMN(i);
+        const int north = row, south = CELLS_PER_ROW - 1 - row, west = column, east = CELLS_PER_ROW - 1 - column;
+
+        ray_lengths[i][0] = north;
+        ray_lengths[i][1] = south;
+        ray_lengths[i][2] = west;
+        ray_lengths[i][3] = east;
+        ray_lengths[i][4] = SDL_min(north, west);
+        ray_lengths[i][5] = SDL_min(north, east);
+        ray_lengths[i][6] = SDL_min(south, west);
+        ray_lengths[i][7] = SDL_min(south, east);
+
+        for (int j = 0; j != 8; ++j)
+        {
+            add_target(knight_targets[i], &knight_targets_count[i], i, knight_jumps[j][0], knight_jumps[j][1]);
+            add_target(king_targets[i], &king_targets_count[i], i, king_steps[j][0], king_steps[j][1]);
+        }
+
+        castling_masks[i] = 0xF;
+    }
+
+    castling_masks[LOWER_LEFT_ROOK_INDEX] &= ~CASTLE_WHITE_LONG;
+    castling_masks[LOWER_RIGHT_ROOK_INDEX] &= ~CASTLE_WHITE_SHORT;
+    castling_masks[LOWER_LEFT_ROOK_INDEX + 4] &= ~(CASTLE_WHITE_LONG | CASTLE_WHITE_SHORT);
+    castling_masks[UPPER_LEFT_ROOK_INDEX] &= ~CASTLE_BLACK_LONG;
+    castling_masks[UPPER_RIGHT_ROOK_INDEX] &= ~CASTLE_BLACK_SHORT;
+    castling_masks[UPPER_LEFT_ROOK_INDEX + 4] &= ~(CASTLE_BLACK_LONG | CASTLE_BLACK_SHORT);
+
+    // fixed seed: hashes must be the same on every run and every machine
+    unsigned long long seed = 0x43484553534321ull;
+    for (int i = 0; i != 12; ++i)
+        for (int j = 0; j != BOARD_SZ; ++j) piece_keys[i][j] = split_mix(&seed);
+    for (int i = 0; i != 16; ++i) castling_keys[i] = split_mix(&seed);
+    for (int i = 0; i != CELLS_PER_ROW; ++i) enpassant_keys[i] = split_mix(&seed);
+    side_key = split_mix(&seed);
+
+    is_initialized = TRUE;
+}
+
+static unsigned long long compute_hash(const position_t* position)
+{
+    unsigned long long hash = castling_keys[position->castling];
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        if (position->squares[i]) hash ^= piece_keys[piece_key_index(position->squares[i])][i];
+    }
+
+    if (position->enpassant_index != INVALID_INDEX) hash ^= enpassant_keys[COLUMN(position->enpassant_index)];
+    if (position->is_white_to_move) hash ^= side_key;
+
+    return hash;
+}
+
+static char can_capture_enpassant(const position_t* position, int pawn_index)
+{
+    // the cell is only stored when a pawn of the side to move is next to the one that moved, hashes stay equal for equal positions
+    const signed char capturing_pawn = position->is_white_to_move ? pawn : -pawn;
+    const int column = COLUMN(pawn_index);
+
+    return (column > 0 && position->squares[pawn_index - 1] == capturing_pawn) || (column < CELLS_PER_ROW - 1 && position->squares[pawn_index + 1] == capturing_pawn);
+}
+
+static void update_derived_state(position_t* position)
+{
+    if (position->enpassant_index != INVALID_INDEX)
+    {
+        const int pawn_index = position->enpassant_index + (position->is_white_to_move ? CELLS_PER_ROW : -CELLS_PER_ROW);
+        if (CHECK_IDX_RANGE(pawn_index) || !can_capture_enpassant(position, pawn_index)) position->enpassant_index = INVALID_INDEX;
+    }
+
+    position->king_index[0] = position->king_index[1] = INVALID_INDEX;
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        if (PIECE_TYPE(position->squares[i]) == king) position->king_index[IS_WHITE(position->squares[i]) ? 1 : 0] = i;
+    }
+
+    position->hash = compute_hash(position);
+}
+
+void position_set_start(position_t* position) { position_from_fen(position, START_FEN); }
+
+char position_from_fen(position_t* position, const char* fen)
+{
+    SDL_memset(position, 0, sizeof(position_t));
+    position->enpassant_index = INVALID_INDEX;
+    position->fullmove_number = 1;
+
+    const char* c = fen;
+    int index = 0;
+
+    // piece placement
+    for (; *c && *c != ' '; ++c)
+    {
+        if (*c == '/') continue;
+
+        if (*c >= '1' && *c <= '8')
+        {
+            index += *c - '0';
+            continue;
+        }
+
+        const char* letter = SDL_strchr(piece_letters + 1, *c >= 'a' ? *c - ('a' - 'A') : *c);
+        if (!letter || index >= BOARD_SZ) return FALSE;
+
+        const signed char type = (signed char)(letter - piece_letters);
+        position->squares[index++] = (*c >= 'a') ? -type : type;
+    }
+
+    if (index != BOARD_SZ || *c++ != ' ') return FALSE;
+
+    // side to move
+    position->is_white_to_move = (*c == 'w');
+    if (*c != 'w' && *c != 'b') return FALSE;
+    c++;
+
+    // castling rights
+    while (*c == ' ') c++;
+    for (; *c && *c != ' '; ++c)
+    {
+        switch (*c)
+        {
+        case 'K': position->castling |= CASTLE_WHITE_SHORT; break;
+        case 'Q': position->castling |= CASTLE_WHITE_LONG; break;
+        case 'k': position->castling |= CASTLE_BLACK_SHORT; break;
+        case 'q': position->castling |= CASTLE_BLACK_LONG; break;
+        default: break;
+        }
+    }
+
+    // en passant cell
+    while (*c == ' ') c++;
+    if (*c >= 'a' && *c <= 'h' && c[1] >= '1' && c[1] <= '8')
+    {
+        position->enpassant_index = (signed char)(('8' - c[1]) * CELLS_PER_ROW + (c[0] - 'a'));
+        c += 2;
+    }
+    while (*c && *c != ' ') c++;
+
+    // clocks are optional, epd lines don't have them
+    while (*c == ' ') c++;
+    if (*c >= '0' && *c <= '9') position->halfmove_clock = (int)SDL_strtol(c, (char**)&c, 10);
+    while (*c == ' ') c++;
+    if (*c >= '0' && *c <= '9') position->fullmove_number = (int)SDL_strtol(c, (char**)&c, 10);
+    position->fullmove_number = SDL_max(1, position->fullmove_number);
+
+    update_derived_state(position);
+
+    return position->king_index[0] != INVALID_INDEX && position->king_index[1] != INVALID_INDEX;
+}
+
+void position_to_fen(const position_t* position, char* buffer, size_t size)
+{
+    char fen[MAX_FEN_SIZE];
+    int length = 0;
+
+    for (int row = 0; row != CELLS_PER_ROW; ++row)
+    {
+        int empty = 0;
+        for (int column = 0; column != CELLS_PER_ROW; ++column)
+        {
+            const signed char square = position->squares[row * CELLS_PER_ROW + column];
+            if (!square)
+            {
+                empty++;
+                continue;
+            }
+
+            if (empty) fen[length++] = (char)('0' + empty);
+            empty = 0;
+
+            const char letter = piece_letters[PIECE_TYPE(square)];
+            fen[length++] = IS_WHITE(square) ? letter : (char)(letter + ('a' - 'A'));
+        }
+
+        if (empty) fen[length++] = (char)('0' + empty);
+        if (row != CELLS_PER_ROW - 1) fen[length++] = '/';
+    }
+
+    fen[length++] = ' ';
+    fen[length++] = position->is_white_to_move ? 'w' : 'b';
+    fen[length++] = ' ';
+
+    if (!position->castling) fen[length++] = '-';
+    if (position->castling & CASTLE_WHITE_SHORT) fen[length++] = 'K';
+    if (position->castling & CASTLE_WHITE_LONG) fen[length++] = 'Q';
+    if (position->castling & CASTLE_BLACK_SHORT) fen[length++] = 'k';
+    if (position->castling & CASTLE_BLACK_LONG) fen[length++] = 'q';
+    fen[length++] = ' ';
+
+    if (position->enpassant_index == INVALID_INDEX)
+    {
+        fen[length++] = '-';
+    } else
+    {
+        fen[length++] = (char)('a' + COLUMN(position->enpassant_index));
+        fen[length++] = (char)('8' - ROW(position->enpassant_index));
+    }
+    fen[length] = '\0';
+
+    SDL_snprintf(buffer, size, "%s %i %i", fen, position->halfmove_clock, position->fullmove_number);
+}
+
+void position_from_snapshot(position_t* position, const snapshot_t* snapshot)
+{
+    SDL_memset(position, 0, sizeof(position_t));
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        char is_white = FALSE;
+        const piece_type_t type = snapshot_get_square(snapshot, i, &is_white);
+        position->squares[i] = (signed char)(is_white ? type : -(int)type);
+    }
+
+    position->is_white_to_move = snapshot_is_white_to_move(snapshot);
+    position->castling = snapshot->flags & (CASTLE_WHITE_SHORT | CASTLE_WHITE_LONG | CASTLE_BLACK_SHORT | CASTLE_BLACK_LONG);
+    position->halfmove_clock = snapshot->halfmove_clock;
+    position->fullmove_number = snapshot->fullmove_number;
+
+    // snapshots store the pawn to take, positions the cell the capturing pawn lands on
+    position->enpassant_index = INVALID_INDEX;
+    if (snapshot->enpassant_index != INVALID_INDEX)
+    {
+        position->enpassant_index = (signed char)(snapshot->enpassant_index + (position->is_white_to_move ? -CELLS_PER_ROW : CELLS_PER_ROW));
+    }
+
+    update_derived_state(position);
+}
+
+void position_set_squares(position_t* position, const signed char* squares, char is_white_to_move)
+{
+    SDL_memset(position, 0, sizeof(position_t));
+    SDL_memcpy(position->squares, squares, sizeof(position->squares));
+
+    position->is_white_to_move = is_white_to_move;
+    position->enpassant_index = INVALID_INDEX;
+    position->fullmove_number = 1;
+
+    update_derived_state(position);
+}
+
+void position_to_snapshot(const position_t* position, snapshot_t* snapshot)
+{
+    snapshot_clear(snapshot);
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        const signed char square = position->squares[i];
+        if (square) snapshot_set_square(snapshot, i, PIECE_TYPE(square), IS_WHITE(square));
+    }
+
+    snapshot->flags = position->castling | (position->is_white_to_move ? SNAPSHOT_WHITE_TO_MOVE : 0);
+    snapshot->halfmove_clock = (unsigned char)SDL_min(position->halfmove_clock, UCHAR_MAX);
+    snapshot->fullmove_number = (unsigned short)position->fullmove_number;
+
+    if (position->enpassant_index != INVALID_INDEX)
+    {
+        snapshot->enpassant_index = (signed char)(position->enpassant_index + (position->is_white_to_move ? CELLS_PER_ROW : -CELLS_PER_ROW));
+    }
+}
+
+piece_type_t position_get_piece(const position_t* position, int index, char* is_white)
+{
+    const signed char square = position->squares[index];
+    if (is_white) *is_white = IS_WHITE(square);
+    return PIECE_TYPE(square);
+}
+
+char position_is_attacked(const position_t* position, int index, char by_white)
+{
+    const signed char* squares = position->squares;
+    const signed char sign = by_white ? 1 : -1;
+    const int column = COLUMN(index);
+
+    // pawns attack diagonally towards the other side
+    const int pawn_row_offset = by_white ? CELLS_PER_ROW : -CELLS_PER_ROW;
+    const int pawn_left = index + pawn_row_offset - 1, pawn_right = index + pawn_row_offset + 1;
+    if (column > 0 && !CHECK_IDX_RANGE(pawn_left) && squares[pawn_left] == sign * pawn) return TRUE;
+    if (column < CELLS_PER_ROW - 1 && !CHECK_IDX_RANGE(pawn_right) && squares[pawn_right] == sign * pawn) return TRUE;
+
+    for (int i = 0; i != knight_targets_count[index]; ++i)
+    {
+        if (squares[knight_targets[index][i]] == sign * knight) return TRUE;
+    }
+
+    for (int i = 0; i != king_targets_count[index]; ++i)
+    {
+        if (squares[king_targets[index][i]] == sign * king) return TRUE;
+    }
+
+    for (int direction = 0; direction != MAX_DIR; ++direction)
+    {
+        const signed char slider = (direction < 4) ? rook : bishop;
+
+        for (int step = 1, target = index; step <= ray_lengths[index][direction]; ++step)
+        {
+            target += direction_offsets[direction];
+            const signed char square = squares[target];
+            if (!square) continue;
+
+            if (square == sign * slider || square == sign * queen) return TRUE;
+            break;
+        }
+    }
+
+    return FALSE;
+}
+
+char position_in_check(const position_t* position)
+{
+    const int king_index = position->king_index[position->is_white_to_move ? 1 : 0];
+    return king_index != INVALID_INDEX && position_is_attacked(position, king_index, !position->is_white_to_move);
+}
+
+static void add_move(move_t* moves, int* count, int from, int to, piece_type_t promotion, unsigned char flags)
+{
+    moves[(*count)++] = (move_t){(unsigned char)from, (unsigned char)to, (unsigned char)promotion, flags};
+}
+
+static void add_pawn_move(move_t* moves, int* count, int from, int to, unsigned char flags, char captures_only)
+{
+    const int row = ROW(to);
+
+    if (row == 0 || row == CELLS_PER_ROW - 1)
+    {
+        // underpromotions are quiet enough to be skipped by the quiescence search
+        add_move(moves, count, from, to, queen, flags);
+        if (captures_only) return;
+
+        add_move(moves, count, from, to, rook, flags);
+        add_move(moves, count, from, to, bishop, flags);
+        add_move(moves, count, from, to, knight, flags);
+        return;
+    }
+
+    if (!captures_only || (flags & (MOVE_CAPTURE | MOVE_ENPASSANT))) add_move(moves, count, from, to, none, flags);
+}
+
+static void generate_castling(const position_t* position, move_t* moves, int* count)
+{
+    const char is_white = position->is_white_to_move;
+    const int king_index = is_white ? LOWER_LEFT_ROOK_INDEX + 4 : UPPER_LEFT_ROOK_INDEX + 4;
+    const unsigned char short_right = is_white ? CASTLE_WHITE_SHORT : CASTLE_BLACK_SHORT;
+    const unsigned char long_right = is_white ? CASTLE_WHITE_LONG : CASTLE_BLACK_LONG;
+    const signed char* squares = position->squares;
+
+    if (!(position->castling & (short_right | long_right)) || position_is_attacked(position, king_index, !is_white)) return;
+
+    if ((position->castling & short_right) && !squares[king_index + 1] && !squares[king_index + 2] && squares[king_index + 3] == (is_white ? rook : -rook))
+    {
+        if (!position_is_attacked(position, king_index + 1, !is_white)) add_move(moves, count, king_index, king_index + 2, none, MOVE_CASTLING);
+    }
+
+    if ((position->castling & long_right) && !squares[king_index - 1] && !squares[king_index - 2] && !squares[king_index - 3] && squares[king_index - 4] == (is_white ? rook : -rook))
+    {
+        if (!position_is_attacked(position, king_index - 1, !is_white)) add_move(moves, count, king_index, king_index - 2, none, MOVE_CASTLING);
+    }
+}
+
+static int generate_pseudo_moves(const position_t* position, move_t* moves, char captures_only)
+{
+    const signed char* squares = position->squares;
+    const char is_white = position->is_white_to_move;
+    const int forward = is_white ? -CELLS_PER_ROW : CELLS_PER_ROW;
+    const int start_row = is_white ? CELLS_PER_ROW - 2 : 1;
+    int count = 0;
+
+    for (int from = 0; from != BOARD_SZ; ++from)
+    {
+        const signed char square = squares[from];
+        if (!square || IS_WHITE(square) != is_white) continue;
+
+        const piece_type_t type = PIECE_TYPE(square);
+
+        switch (type)
+        {
+        case pawn:
+        {
+            const int to = from + forward;
+            if (CHECK_IDX_RANGE(to)) break;
+
+            if (!squares[to])
+            {
+                add_pawn_move(moves, &count, from, to, 0, captures_only);
+                if (!captures_only && ROW(from) == start_row && !squares[to + forward]) add_move(moves, &count, from, to + forward, none, MOVE_DOUBLE_PUSH);
+            }
+
+            for (int side = -1; side <= 1; side += 2)
+            {
+                if ((side < 0 && COLUMN(from) == 0) || (side > 0 && COLUMN(from) == CELLS_PER_ROW - 1)) continue;
+
+                const int target = to + side;
+                if (squares[target] && IS_WHITE(squares[target]) != is_white) add_pawn_move(moves, &count, from, target, MOVE_CAPTURE, captures_only);
+                else if (target == position->enpassant_index) add_pawn_move(moves, &count, from, target, MOVE_ENPASSANT, captures_only);
+            }
+            break;
+        }
+        case knight:
+        case king:
+        {
+            const int* targets = (type == knight) ? knight_targets[from] : king_targets[from];
+            const int targets_count = (type == knight) ? knight_targets_count[from] : king_targets_count[from];
+
+            for (int i = 0; i != targets_count; ++i)
+            {
+                const signed char target = squares[targets[i]];
+                if (!target && !captures_only) add_move(moves, &count, from, targets[i], none, 0);
+                else if (target && IS_WHITE(target) != is_white) add_move(moves, &count, from, targets[i], none, MOVE_CAPTURE);
+            }
+            break;
+        }
+        default:
+        {
+            const int first_direction = (type == bishop) ? 4 : 0;
+            const int last_direction = (type == rook) ? 4 : MAX_DIR;
+
+            for (int direction = first_direction; direction != last_direction; ++direction)
+            {
+                for (int step = 1, to = from; step <= ray_lengths[from][direction]; ++step)
+                {
+                    to += direction_offsets[direction];
+                    const signed char target = squares[to];
+
+                    if (!target)
+                    {
+                        if (!captures_only) add_move(moves, &count, from, to, none, 0);
+                        continue;
+                    }
+
+                    if (IS_WHITE(target) != is_white) add_move(moves, &count, from, to, none, MOVE_CAPTURE);
+                    break;
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    if (!captures_only) generate_castling(position, moves, &count);
+
+    return count;
+}
+
+int position_generate_moves(const position_t* position, move_t* moves, char captures_only)
+{
+    move_t pseudo_moves[MAX_MOVES];
+    const int pseudo_count = generate_pseudo_moves(position, pseudo_moves, captures_only);
+
+    // a move is legal when it doesn't leave our own king attacked
+    position_t copy = *position;
+    int count = 0;
+
+    for (int i = 0; i != pseudo_count; ++i)
+    {
+        undo_t undo;
+        position_make_move(&copy, pseudo_moves[i], &undo);
+
+        const int king_index = copy.king_index[position->is_white_to_move ? 1 : 0];
+        if (king_index == INVALID_INDEX || !position_is_attacked(&copy, king_index, copy.is_white_to_move)) moves[count++] = pseudo_moves[i];
+
+        position_unmake_move(&copy, pseudo_moves[i], &undo);
+    }
+
+    return count;
+}
+
+static void put_piece(position_t* position, int index, signed char square)
+{
+    position->squares[index] = square;
+    position->hash ^= piece_keys[piece_key_index(square)][index];
+}
+
+static void remove_piece(position_t* position, int index)
+{
+    position->hash ^= piece_keys[piece_key_index(position->squares[index])][index];
+    position->squares[index] = 0;
+}
+
+void position_make_move(position_t* position, move_t move, undo_t* undo)
+{
+    const signed char piece = position->squares[move.from];
+    const char is_white = IS_WHITE(piece);
+
+    undo->hash = position->hash;
+    undo->halfmove_clock = position->halfmove_clock;
+    undo->enpassant_index = position->enpassant_index;
+    undo->castling = position->castling;
+    undo->captured = 0;
+
+    if (position->enpassant_index != INVALID_INDEX) position->hash ^= enpassant_keys[COLUMN(position->enpassant_index)];
+    position->enpassant_index = INVALID_INDEX;
+
+    if (move.flags & MOVE_ENPASSANT)
+    {
+        const int captured_index = move.to + (is_white ? CELLS_PER_ROW : -CELLS_PER_ROW);
+        undo->captured = position->squares[captured_index];
+        remove_piece(position, captured_index);
+    } else if (position->squares[move.to])
+    {
+        undo->captured = position->squares[move.to];
+        remove_piece(position, move.to);
+    }
+
+    remove_piece(position, move.from);
+    put_piece(position, move.to, move.promotion ? (signed char)(is_white ? move.promotion : -move.promotion) : piece);
+
+    if (move.flags & MOVE_CASTLING)
+    {
+        const char is_short = move.to > move.from;
+        const int rook_from = is_short ? move.from + 3 : move.from - 4;
+        const int rook_to = is_short ? move.from + 1 : move.from - 1;
+
+        const signed char castling_rook = position->squares[rook_from];
+        remove_piece(position, rook_from);
+        put_piece(position, rook_to, castling_rook);
+    }
+
+    if (PIECE_TYPE(piece) == king) position->king_index[is_white ? 1 : 0] = move.to;
+
+    position->hash ^= castling_keys[position->castling];
+    position->castling &= castling_masks[move.from] & castling_masks[move.to];
+    position->hash ^= castling_keys[position->castling];
+
+    position->halfmove_clock = (PIECE_TYPE(piece) == pawn || undo->captured) ? 0 : position->halfmove_clock + 1;
+    if (!is_white) position->fullmove_number++;
+
+    position->is_white_to_move = !position->is_white_to_move;
+    position->hash ^= side_key;
+
+    if ((move.flags & MOVE_DOUBLE_PUSH) && can_capture_enpassant(position, move.to))
+    {
+        position->enpassant_index = (signed char)((move.from + move.to) / 2);
+        position->hash ^= enpassant_keys[COLUMN(position->enpassant_index)];
+    }
+}
+
+void position_unmake_move(position_t* position, move_t move, const undo_t* undo)
+{
+    position->is_white_to_move = !position->is_white_to_move;
+
+    const char is_white = position->is_white_to_move;
+    const signed char moved = position->squares[move.to];
+    const signed char piece = move.promotion ? (signed char)(is_white ? pawn : -pawn) : moved;
+
+    position->squares[move.from] = piece;
+    position->squares[move.to] = 0;
+
+    if (move.flags & MOVE_ENPASSANT) position->squares[move.to + (is_white ? CELLS_PER_ROW : -CELLS_PER_ROW)] = undo->captured;
+    else position->squares[move.to] = undo->captured;
+
+    if (move.flags & MOVE_CASTLING)
+    {
+        const char is_short = move.to > move.from;
+        const int rook_from = is_short ? move.from + 3 : move.from - 4;
+        const int rook_to = is_short ? move.from + 1 : move.from - 1;
+
+        position->squares[rook_from] = position->squares[rook_to];
+        position->squares[rook_to] = 0;
+    }
+
+    if (PIECE_TYPE(piece) == king) position->king_index[is_white ? 1 : 0] = move.from;
+    if (!is_white) position->fullmove_number--;
+
+    position->hash = undo->hash;
+    position->halfmove_clock = undo->halfmove_clock;
+    position->enpassant_index = undo->enpassant_index;
+    position->castling = undo->castling;
+}
+
+void position_make_null_move(position_t* position, undo_t* undo)
+{
+    undo->hash = position->hash;
+    undo->halfmove_clock = position->halfmove_clock;
+    undo->enpassant_index = position->enpassant_index;
+    undo->castling = position->castling;
+    undo->captured = 0;
+
+    if (position->enpassant_index != INVALID_INDEX) position->hash ^= enpassant_keys[COLUMN(position->enpassant_index)];
+    position->enpassant_index = INVALID_INDEX;
+    position->halfmove_clock++;
+    position->is_white_to_move = !position->is_white_to_move;
+    position->hash ^= side_key;
+}
+
+void position_unmake_null_move(position_t* position, const undo_t* undo)
+{
+    position->is_white_to_move = !position->is_white_to_move;
+    position->hash = undo->hash;
+    position->halfmove_clock = undo->halfmove_clock;
+    position->enpassant_index = undo->enpassant_index;
+}
+
+char position_has_insufficient_material(const position_t* position)
+{
+    int minor_pieces = 0;
+
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        switch (PIECE_TYPE(position->squares[i]))
+        {
+        case pawn:
+        case rook:
+        case queen: return FALSE;
+        case knight:
+        case bishop: minor_pieces++; break;
+        default: break;
+        }
+    }
+
+    return minor_pieces <= 1;
+}
+
+char position_is_repetition(const unsigned long long* hashes, int count, int halfmove_clock, int times)
+{
+    // only positions with the same side to move since the last capture or pawn move can repeat
+    const unsigned long long current = hashes[count - 1];
+    int found = 1;
+
+    for (int i = count - 3; i >= 0 && i >= count - 1 - halfmove_clock; i -= 2)
+    {
+        if (hashes[i] == current && ++found >= times) return TRUE;
+    }
+
+    return FALSE;
+}
+
+outcome_t position_get_outcome(const position_t* position, const unsigned long long* hashes, int hashes_count, const char** reason)
+{
+    move_t moves[MAX_MOVES];
+    const char* ignored = NULL;
+    if (!reason) reason = &ignored;
+
+    if (!position_generate_moves(position, moves, FALSE))
+    {
+        if (!position_in_check(position))
+        {
+            *reason = "stalemate";
+            return outcome_draw;
+        }
+
+        *reason = "checkmate";
+        return position->is_white_to_move ? outcome_black_wins : outcome_white_wins;
+    }
+
+    *reason = NULL;
+    if (position->halfmove_clock >= 100) *reason = "fifty move rule";
+    else if (hashes && position_is_repetition(hashes, hashes_count, position->halfmove_clock, 3)) *reason = "threefold repetition";
+    else if (position_has_insufficient_material(position)) *reason = "insufficient material";
+
+    return *reason ? outcome_draw : outcome_none;
+}
+
+const char* outcome_to_string(outcome_t outcome)
+{
+    switch (outcome)
+    {
+    case outcome_white_wins: return "1-0";
+    case outcome_black_wins: return "0-1";
+    case outcome_draw: return "1/2-1/2";
+    default: return "*";
+    }
+}
+
+char move_equals(move_t a, move_t b) { return a.from == b.from && a.to == b.to && a.promotion == b.promotion; }
+
+void move_to_uci(move_t move, char* buffer)
+{
+    buffer[0] = (char)('a' + COLUMN(move.from));
+    buffer[1] = (char)('8' - ROW(move.from));
+    buffer[2] = (char)('a' + COLUMN(move.to));
+    buffer[3] = (char)('8' - ROW(move.to));
+    buffer[4] = move.promotion ? (char)(piece_letters[move.promotion] + ('a' - 'A')) : '\0';
+    buffer[5] = '\0';
+}
+
+char position_parse_uci(const position_t* position, const char* text, move_t* move)
+{
+    move_t moves[MAX_MOVES];
+    const int count = position_generate_moves(position, moves, FALSE);
+
+    for (int i = 0; i != count; ++i)
+    {
+        char uci[MAX_UCI_SIZE];
+        move_to_uci(moves[i], uci);
+
+        if (!SDL_strncmp(uci, text, SDL_strlen(uci)) && (text[SDL_strlen(uci)] == '\0' || text[SDL_strlen(uci)] == ' ' || text[SDL_strlen(uci)] == '\n'))
+        {
+            *move = moves[i];
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static char is_legal_move(const position_t* position, move_t move)
+{
+    position_t copy = *position;
+    undo_t undo;
+    position_make_move(&copy, move, &undo);
+
+    const int king_index = copy.king_index[position->is_white_to_move ? 1 : 0];
+    return king_index == INVALID_INDEX || !position_is_attacked(&copy, king_index, copy.is_white_to_move);
+}
+
+// stops at the first legal move instead of generating them all
+static char has_legal_move(const position_t* position)
+{
+    move_t moves[MAX_MOVES];
+    const int count = generate_pseudo_moves(position, moves, FALSE);
+
+    for (int i = 0; i != count; ++i)
+    {
+        if (is_legal_move(position, moves[i])) return TRUE;
+    }
+
+    return FALSE;
+}
+
+// cells holding a piece of the side to move that can reach the target, pins aside.
+// Pieces are looked up from the target like attacks are, instead of generating every move.
+static int find_origins(const position_t* position, int to, piece_type_t type, int* origins)
+{
+    const signed char* squares = position->squares;
+    const char is_white = position->is_white_to_move;
+    const signed char piece = is_white ? (signed char)type : -(signed char)type;
+    const signed char target = squares[to];
+    int count = 0;
+
+    if (target && IS_WHITE(target) == is_white) return 0;
+
+    switch (type)
+    {
+    case pawn:
+    {
+        const int backward = is_white ? CELLS_PER_ROW : -CELLS_PER_ROW;
+        const int from = to + backward;
+        if (CHECK_IDX_RANGE(from)) break;
+
+        if (!target)
+        {
+            // double pushes land on the fourth row from their side
+            if (squares[from] == piece) origins[count++] = from;
+            else if (!squares[from] && ROW(to) == (is_white ? 4 : 3) && squares[from + backward] == piece) origins[count++] = from + backward;
+        }
+
+        if (target || to == position->enpassant_index)
+        {
+            if (COLUMN(to) > 0 && squares[from - 1] == piece) origins[count++] = from - 1;
+            if (COLUMN(to) < CELLS_PER_ROW - 1 && squares[from + 1] == piece) origins[count++] = from + 1;
+        }
+        break;
+    }
+    case knight:
+    case king:
+    {
+        const int* targets = (type == knight) ? knight_targets[to] : king_targets[to];
+        const int targets_count = (type == knight) ? knight_targets_count[to] : king_targets_count[to];
+
+        for (int i = 0; i != targets_count; ++i)
+        {
+            if (squares[targets[i]] == piece) origins[count++] = targets[i];
+        }
+        break;
+    }
+    default:
+    {
+        const int first_direction = (type == bishop) ? 4 : 0;
+        const int last_direction = (type == rook) ? 4 : MAX_DIR;
+
+        for (int direction = first_direction; direction != last_direction; ++direction)
+        {
+            for (int step = 1, from = to; step <= ray_lengths[to][direction]; ++step)
+            {
+                from += direction_offsets[direction];
+                if (!squares[from]) continue;
+
+                if (squares[from] == piece) origins[count++] = from;
+                break;
+            }
+        }
+        break;
+    }
+    }
+
+    return count;
+}
+
+static move_t make_move_from(const position_t* position, int from, int to, piece_type_t promotion)
+{
+    unsigned char flags = position->squares[to] ? MOVE_CAPTURE : 0;
+
+    if (PIECE_TYPE(position->squares[from]) == pawn)
+    {
+        if (to == position->enpassant_index && COLUMN(from) != COLUMN(to)) flags |= MOVE_ENPASSANT;
+        if (SDL_abs(to - from) == 2 * CELLS_PER_ROW) flags |= MOVE_DOUBLE_PUSH;
+    }
+
+    return (move_t){(unsigned char)from, (unsigned char)to, (unsigned char)promotion, flags};
+}
+
+// accepts what pgn files contain in practice: "0-0" castling, redundant disambiguation, missing '=' and annotations
+char position_parse_san(const position_t* position, const char* text, move_t* move)
+{
+    char san[MAX_BUFFER_SIZE];
+    int length = 0;
+
+    for (const char* c = text; *c && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n' && length != MAX_BUFFER_SIZE - 1; ++c)
+    {
+        if (*c != '+' && *c != '#' && *c != '!' && *c != '?' && *c != 'x' && *c != '=' && *c != '-') san[length++] = (*c == '0') ? 'O' : *c;
+    }
+    san[length] = '\0';
+
+    if (!SDL_strcmp(san, "OO") || !SDL_strcmp(san, "OOO"))
+    {
+        move_t moves[2];
+        int count = 0;
+        generate_castling(position, moves, &count);
+
+        for (int i = 0; i != count; ++i)
+        {
+            if ((moves[i].to > moves[i].from) == (length == 2) && is_legal_move(position, moves[i]))
+            {
+                *move = moves[i];
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
+    piece_type_t type = pawn, promotion = none;
+    const char* found = length ? SDL_strchr(piece_letters + 1, san[0]) : NULL;
+    if (found)
+    {
+        type = (piece_type_t)(found - piece_letters);
+        SDL_memmove(san, san + 1, length--);
+    }
+
+    // trailing promotion piece, then the destination cell, anything left before it disambiguates
+    if (length && type == pawn && (found = SDL_strchr(piece_letters + 1, san[length - 1])) && san[length - 1] != 'K' && san[length - 1] != 'P')
+    {
+        promotion = (piece_type_t)(found - piece_letters);
+        san[--length] = '\0';
+    }
+
+    if (length < 2 || san[length - 2] < 'a' || san[length - 2] > 'h' || san[length - 1] < '1' || san[length - 1] > '8') return FALSE;
+
+    const int to = ('8' - san[length - 1]) * CELLS_PER_ROW + (san[length - 2] - 'a');
+    int from_column = -1, from_row = -1;
+
+    for (int i = 0; i != length - 2; ++i)
+    {
+        if (san[i] >= 'a' && san[i] <= 'h') from_column = san[i] - 'a';
+        else if (san[i] >= '1' && san[i] <= '8') from_row = '8' - san[i];
+        else return FALSE;
+    }
+
+    // pawns only change column when capturing, and promote exactly when they reach the last row
+    if (type == pawn && from_column == -1) from_column = COLUMN(to);
+    if ((type == pawn && (ROW(to) == 0 || ROW(to) == CELLS_PER_ROW - 1)) != (promotion != none)) return FALSE;
+
+    int origins[MAX_DIR * 2];
+    const int origins_count = find_origins(position, to, type, origins);
+    int matches = 0;
+
+    for (int i = 0; i != origins_count; ++i)
+    {
+        if ((from_column != -1 && COLUMN(origins[i]) != from_column) || (from_row != -1 && ROW(origins[i]) != from_row)) continue;
+
+        const move_t candidate = make_move_from(position, origins[i], to, promotion);
+        if (!is_legal_move(position, candidate)) continue;
+
+        *move = candidate;
+        matches++;
+    }
+
+    return matches == 1;
+}
+
+void position_move_to_san(const position_t* position, move_t move, char* buffer)
+{
+    const piece_type_t type = PIECE_TYPE(position->squares[move.from]);
+    int length = 0;
+
+    if (move.flags & MOVE_CASTLING)
+    {
+        length = SDL_snprintf(buffer, MAX_SAN_SIZE, move.to > move.from ? "O-O" : "O-O-O");
+    } else
+    {
+        const char is_capture = (move.flags & (MOVE_CAPTURE | MOVE_ENPASSANT)) != 0;
+
+        if (type == pawn)
+        {
+            if (is_capture) buffer[length++] = (char)('a' + COLUMN(move.from));
+        } else
+        {
+            buffer[length++] = piece_letters[type];
+
+            // disambiguate only against pieces of the same type that can legally go to the same cell
+            int origins[MAX_DIR * 2];
+            const int origins_count = find_origins(position, move.to, type, origins);
+            char is_ambiguous = FALSE, same_column = FALSE, same_row = FALSE;
+
+            for (int i = 0; i != origins_count; ++i)
+            {
+                if (origins[i] == move.from || !is_legal_move(position, make_move_from(position, origins[i], move.to, none))) continue;
+
+                is_ambiguous = TRUE;
+                same_column |= COLUMN(origins[i]) == COLUMN(move.from);
+                same_row |= ROW(origins[i]) == ROW(move.from);
+            }
+
+            if (is_ambiguous && (!same_column || same_row)) buffer[length++] = (char)('a' + COLUMN(move.from));
+            if (is_ambiguous && same_column) buffer[length++] = (char)('8' - ROW(move.from));
+        }
+
+        if (is_capture) buffer[length++] = 'x';
+        buffer[length++] = (char)('a' + COLUMN(move.to));
+        buffer[length++] = (char)('8' - ROW(move.to));
+
+        if (move.promotion)
+        {
+            buffer[length++] = '=';
+            buffer[length++] = piece_letters[move.promotion];
+        }
+    }
+
+    // check and mate suffix
+    position_t copy = *position;
+    undo_t undo;
+    position_make_move(&copy, move, &undo);
+
+    if (position_in_check(&copy)) buffer[length++] = has_legal_move(&copy) ? '+' : '#';
+
+    buffer[length] = '\0';
+}
+
+char position_find_move(const position_t* before, const position_t* after, move_t* move)
+{
+    move_t moves[MAX_MOVES];
+    const int count = position_generate_moves(before, moves, FALSE);
+    position_t copy = *before;
+
+    for (int i = 0; i != count; ++i)
+    {
+        undo_t undo;
+        position_make_move(&copy, moves[i], &undo);
+        const char is_found = !SDL_memcmp(copy.squares, after->squares, sizeof(copy.squares));
+        position_unmake_move(&copy, moves[i], &undo);
+
+        if (is_found)
+        {
+            *move = moves[i];
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
@@ -5,12 +5,12 @@ static char is_empty(queue_t* queue) { return queue->count == 0; }
 
 static char is_full(queue_t* queue) { return queue->count == queue->capacity; }
 
-queue_t* queue_new(size_t size, size_t allocation_size)
+queue_t* queue_new(arena_t* arena, size_t size, size_t allocation_size)
 {
-    queue_t* queue = (queue_t*)calloc(1, sizeof(queue_t));
+    queue_t* queue = (queue_t*)arena_alloc(arena, sizeof(queue_t));
     CHECK(queue, NULL, "Couldn't allocate memory for queue");
 
-    queue->data = (void*)malloc(allocation_size);
+    queue->data = (void**)arena_alloc(arena, allocation_size);
     queue->rear = -1;
     queue->capacity = size;
 
@@ -0,0 +1,389 @@
+#include <search.h>
+
+#define NODES_BETWEEN_CHECKS 2048
+
+// move ordering scores
+#define PV_MOVE_SCORE 1000000
+#define CAPTURE_SCORE 100000
+#define KILLER_SCORE 90000
+
+static const int victim_values[PAWN + 1] = {0, 5, 3, 3, 9, 0, 1};
+
+void search_new(search_t* search, const eval_params_t* params)
+{
+    SDL_memset(search, 0, sizeof(search_t));
+    search->params = params ? params : &default_eval_params;
+    position_set_start(&search->position);
+    search->hashes[search->hashes_count++] = search->position.hash;
+}
+
+void search_clear(search_t* search) { SDL_memset(search->tt, 0, sizeof(search->tt)); }
+
+void search_set_position(search_t* search, const position_t* position, const unsigned long long* game_hashes, int game_hashes_count)
+{
+    search->position = *position;
+    search->hashes_count = 0;
+
+    // positions before the last capture or pawn move can't come back, the current one is always last
+    if (game_hashes)
+    {
+        const int first = SDL_max(0, game_hashes_count - 1 - position->halfmove_clock);
+        for (int i = first; i < game_hashes_count && search->hashes_count < MAX_GAME_PLIES - 1; ++i)
+        {
+            search->hashes[search->hashes_count++] = game_hashes[i];
+        }
+    }
+
+    if (!search->hashes_count || search->hashes[search->hashes_count - 1] != position->hash) search->hashes[search->hashes_count++] = position->hash;
+}
+
+static char should_stop(search_t* search)
+{
+    if (search->is_aborted) return TRUE;
+    if ((search->nodes % NODES_BETWEEN_CHECKS) != 0) return FALSE;
+
+    // a ponder hit keeps the time spent pondering, the limits apply from the start of the search
+    const char is_pondering = search->ponder && SDL_AtomicGet(search->ponder);
+
+    if ((search->stop && SDL_AtomicGet(search->stop)) || (!is_pondering && search->limits.nodes && search->nodes >= search->limits.nodes) ||
+        (!is_pondering && search->limits.time_ms && SDL_GetTicks() - search->start_ticks >= search->limits.time_ms))
+    {
+        search->is_aborted = TRUE;
+    }
+
+    return search->is_aborted;
+}
+
+static void score_moves(const search_t* search, const move_t* moves, int* scores, int count, move_t pv_move, int ply)
+{
+    for (int i = 0; i != count; ++i)
+    {
+        const move_t move = moves[i];
+
+        if (move_equals(move, pv_move)) scores[i] = PV_MOVE_SCORE;
+        else if (move.flags & (MOVE_CAPTURE | MOVE_ENPASSANT))
+        {
+            // most valuable victim, least valuable attacker
+            const piece_type_t victim = (move.flags & MOVE_ENPASSANT) ? pawn : position_get_piece(&search->position, move.to, NULL);
+            const piece_type_t attacker = position_get_piece(&search->position, move.from, NULL);
+            scores[i] = CAPTURE_SCORE + victim_values[victim] * 10 - victim_values[attacker] + move.promotion;
+        } else if (move.promotion) scores[i] = CAPTURE_SCORE + move.promotion;
+        else if (move_equals(move, search->killers[ply][0])) scores[i] = KILLER_SCORE;
+        else if (move_equals(move, search->killers[ply][1])) scores[i] = KILLER_SCORE - 1;
+        else scores[i] = 0;
+    }
+}
+
+// selection sort step: moves are picked lazily because most nodes cut off after the first few
+static move_t pick_move(move_t* moves, int* scores, int count, int index)
+{
+    int best = index;
+    for (int i = index + 1; i < count; ++i)
+    {
+        if (scores[i] > scores[best]) best = i;
+    }
+
+    const move_t move = moves[best];
+    const int score = scores[best];
+    moves[best] = moves[index];
+    scores[best] = scores[index];
+    moves[index] = move;
+    scores[index] = score;
+
+    return move;
+}
+
+static int quiescence(search_t* search, int alpha, int beta, int ply)
+{
+    search->nodes++;
+    if (should_stop(search)) return 0;
+
+    const int stand_pat = evaluate(&search->position, search->params);
+    if (ply >= MAX_SEARCH_DEPTH - 1 || stand_pat >= beta) return stand_pat;
+    if (stand_pat > alpha) alpha = stand_pat;
+
+    move_t moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    const int count = position_generate_moves(&search->position, moves, TRUE);
+    score_moves(search, moves, scores, count, (move_t){0}, ply);
+
+    for (int i = 0; i != count; ++i)
+    {
+        const move_t move = pick_move(moves, scores, count, i);
+
+        undo_t undo;
+        position_make_move(&search->position, move, &undo);
+        const int score = -quiescence(search, -beta, -alpha, ply + 1);
+        position_unmake_move(&search->position, move, &undo);
+
+        if (search->is_aborted) return 0;
+        if (score >= beta) return score;
+        if (score > alpha) alpha = score;
+    }
+
+    return alpha;
+}
+
+// exact score from the tablebases, the distance to mate counts from the root like the searched mates
+static char probe_tablebases(const search_t* search, int ply, int* score)
+{
+    int wdl = 0, dtm = 0;
+    if (!search->tablebases || !tablebases_probe(search->tablebases, &search->position, &wdl, &dtm)) return FALSE;
+
+    if (wdl > 0) *score = MATE_SCORE - ply - dtm;
+    else if (wdl < 0) *score = -MATE_SCORE + ply + dtm;
+    else *score = 0;
+
+    return TRUE;
+}
+
+// nothing to search once the root is in a table: the best move is the one keeping the best value
+static char search_tablebases_root(search_t* search, search_result_t* result)
+{
+    position_t* position = &search->position;
+
+    int score = 0;
+    if (!probe_tablebases(search, 0, &score)) return FALSE;
+
+    move_t moves[MAX_MOVES];
+    const int count = position_generate_moves(position, moves, FALSE);
+
+    int best_score = -INFINITE_SCORE;
+    for (int i = 0; i != count; ++i)
+    {
+        undo_t undo;
+        position_make_move(position, moves[i], &undo);
+        const char is_found = probe_tablebases(search, 1, &score);
+        position_unmake_move(position, moves[i], &undo);
+
+        // a double push giving en passant rights leaves the tables, the search can still have it
+        if (!is_found || -score <= best_score) continue;
+
+        best_score = -score;
+        result->best_move = moves[i];
+    }
+
+    if (best_score == -INFINITE_SCORE) return FALSE;
+
+    result->score = best_score;
+    result->depth = 1;
+    result->pv[0] = result->best_move;
+    result->pv_length = 1;
+
+    return TRUE;
+}
+
+static int score_to_tt(int score, int ply)
+{
+    if (score > MATE_SCORE - MAX_SEARCH_DEPTH) return score + ply;
+    if (score < -MATE_SCORE + MAX_SEARCH_DEPTH) return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply)
+{
+    if (score > MATE_SCORE - MAX_SEARCH_DEPTH) return score - ply;
+    if (score < -MATE_SCORE + MAX_SEARCH_DEPTH) return score + ply;
+    return score;
+}
+
+static void store_tt(search_t* search, int depth, int ply, int score, tt_bound_t bound, move_t move)
+{
+    const unsigned long long key = search->position.hash;
+    tt_entry_t* entry = &search->tt[key & (SEARCH_TT_SIZE - 1)];
+
+    // a deeper bound on the same position is worth more, anything else is replaced
+    if (entry->key == key && entry->depth > depth && bound != tt_exact) return;
+
+    entry->key = key;
+    entry->move = move;
+    entry->score = (short)score_to_tt(score, ply);
+    entry->depth = (signed char)SDL_min(depth, 127);
+    entry->bound = (unsigned char)bound;
+}
+
+static int negamax(search_t* search, int alpha, int beta, int depth, int ply)
+{
+    position_t* position = &search->position;
+    search->pv_length[ply] = 0;
+
+    if (ply > 0)
+    {
+        // a repetition or the fifty move rule end the game here
+        if (position->halfmove_clock >= 100 || position_is_repetition(search->hashes, search->hashes_count, position->halfmove_clock, 2)) return 0;
+        if (position_has_insufficient_material(position)) return 0;
+
+        int score = 0;
+        if (probe_tablebases(search, ply, &score)) return score;
+    }
+
+    const char in_check = position_in_check(position);
+    if (in_check) depth++;
+
+    if (depth <= 0 || ply >= MAX_SEARCH_DEPTH - 1) return quiescence(search, alpha, beta, ply);
+
+    search->nodes++;
+    if (should_stop(search)) return 0;
+
+    // only null window nodes are cut by the table, pv nodes are searched so the pv stays whole
+    const tt_entry_t* entry = &search->tt[position->hash & (SEARCH_TT_SIZE - 1)];
+    const char is_tt_hit = entry->bound != tt_none && entry->key == position->hash;
+    if (is_tt_hit && ply > 0 && beta - alpha == 1 && entry->depth >= depth)
+    {
+        const int score = score_from_tt(entry->score, ply);
+        if (entry->bound == tt_exact || (entry->bound == tt_lower && score >= beta) || (entry->bound == tt_upper && score <= alpha)) return score;
+    }
+
+    move_t moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    int count = position_generate_moves(position, moves, FALSE);
+    const int legal_count = count;
+
+    // the other lines of a multi pv search already own these root moves
+    for (int i = 0; ply == 0 && i < count; ++i)
+    {
+        for (int j = 0; j != search->excluded_count; ++j)
+        {
+            if (!move_equals(moves[i], search->excluded_moves[j])) continue;
+
+            moves[i--] = moves[--count];
+            break;
+        }
+    }
+
+    if (!legal_count) return in_check ? -MATE_SCORE + ply : 0;
+    if (!count) return -INFINITE_SCORE;
+
+    // the table knows the best move of this very position, the pv only the one of the previous iteration's line
+    const char has_tt_move = ply > 0 && is_tt_hit && !move_equals(entry->move, (move_t){0});
+    const move_t first_move = has_tt_move ? entry->move : search->pv[0][ply];
+    score_moves(search, moves, scores, count, first_move, ply);
+
+    // the root of a multi pv line doesn't see every move, what it finds isn't true for the position
+    const char is_storing = ply > 0 || !search->excluded_count;
+    const int original_alpha = alpha;
+    move_t best_move = {0};
+
+    for (int i = 0; i != count; ++i)
+    {
+        const move_t move = pick_move(moves, scores, count, i);
+
+        undo_t undo;
+        position_make_move(position, move, &undo);
+        search->hashes[search->hashes_count++] = position->hash;
+
+        int score = 0;
+        if (i == 0)
+        {
+            score = -negamax(search, -beta, -alpha, depth - 1, ply + 1);
+        } else
+        {
+            // principal variation search: prove the move is worse with a null window first
+            score = -negamax(search, -alpha - 1, -alpha, depth - 1, ply + 1);
+            if (score > alpha && score < beta) score = -negamax(search, -beta, -alpha, depth - 1, ply + 1);
+        }
+
+        search->hashes_count--;
+        position_unmake_move(position, move, &undo);
+
+        if (search->is_aborted) return 0;
+
+        if (score > alpha)
+        {
+            alpha = score;
+            best_move = move;
+
+            // the pv of this ply is the move followed by the pv of the child
+            search->pv[ply][0] = move;
+            for (int j = 0; j != search->pv_length[ply + 1]; ++j) search->pv[ply][j + 1] = search->pv[ply + 1][j];
+            search->pv_length[ply] = search->pv_length[ply + 1] + 1;
+
+            if (score >= beta)
+            {
+                if (!(move.flags & (MOVE_CAPTURE | MOVE_ENPASSANT)) && !move.promotion && !move_equals(move, search->killers[ply][0]))
+                {
+                    search->killers[ply][1] = search->killers[ply][0];
+                    search->killers[ply][0] = move;
+                }
+
+                if (is_storing) store_tt(search, depth, ply, score, tt_lower, move);
+                return score;
+            }
+        }
+    }
+
+    if (is_storing) store_tt(search, depth, ply, alpha, alpha > original_alpha ? tt_exact : tt_upper, best_move);
+    return alpha;
+}
+
+void search_run(search_t* search, const search_limits_t* limits, search_result_t* result) { search_run_multipv(search, limits, result, 1); }
+
+void search_run_multipv(search_t* search, const search_limits_t* limits, search_result_t* results, int lines)
+{
+    SDL_memset(results, 0, sizeof(search_result_t) * lines);
+    SDL_memset(search->pv, 0, sizeof(search->pv));
+    SDL_memset(search->pv_length, 0, sizeof(search->pv_length));
+    SDL_memset(search->killers, 0, sizeof(search->killers));
+
+    search->limits = *limits;
+    search->nodes = 0;
+    search->is_aborted = FALSE;
+    search->start_ticks = SDL_GetTicks();
+    search->excluded_count = 0;
+
+    // always have a move to play, even if the first iteration gets aborted
+    move_t moves[MAX_MOVES];
+    const int moves_count = position_generate_moves(&search->position, moves, FALSE);
+    if (moves_count) results[0].best_move = moves[0];
+
+    // there can't be more lines than root moves, the tables only know the best one
+    const int max_depth = (limits->depth > 0) ? SDL_min(limits->depth, MAX_SEARCH_DEPTH - 1) : MAX_SEARCH_DEPTH - 1;
+    const int first_depth = search_tablebases_root(search, &results[0]) ? max_depth + 1 : 1;
+    lines = SDL_max(1, SDL_min(SDL_min(lines, moves_count), MAX_MULTIPV));
+
+    for (int depth = first_depth; depth <= max_depth; ++depth)
+    {
+        for (int line = 0; line != lines; ++line)
+        {
+            search_result_t* result = &results[line];
+
+            // each line orders its moves with its own pv from the previous iteration
+            SDL_memcpy(search->pv[0], result->pv, sizeof(move_t) * result->pv_length);
+            const int score = negamax(search, -INFINITE_SCORE, INFINITE_SCORE, depth, 0);
+
+            // an aborted iteration is only trusted for its first moves, keep the last complete one
+            if (search->is_aborted) break;
+
+            result->score = score;
+            result->depth = depth;
+            result->pv_length = search->pv_length[0];
+            SDL_memcpy(result->pv, search->pv[0], sizeof(move_t) * result->pv_length);
+            if (result->pv_length) result->best_move = result->pv[0];
+
+            search->excluded_moves[search->excluded_count++] = result->best_move;
+        }
+
+        search->excluded_count = 0;
+        if (search->is_aborted) break;
+
+        if (search->on_iteration)
+        {
+            for (int line = 0; line != lines; ++line)
+            {
+                results[line].nodes = search->nodes;
+                results[line].time_ms = SDL_GetTicks() - search->start_ticks;
+            }
+            if (!search->on_iteration(results, lines, search->callback_data)) break;
+        }
+
+        // no point going deeper once a forced mate has been found
+        if (IS_MATE_SCORE(results[0].score) && MATE_SCORE - SDL_abs(results[0].score) <= depth) break;
+    }
+
+    search->excluded_count = 0;
+    for (int line = 0; line != lines; ++line)
+    {
+        results[line].nodes = search->nodes;
+        results[line].time_ms = SDL_GetTicks() - search->start_ticks;
+    }
+}
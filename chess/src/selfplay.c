@@ -0,0 +1,191 @@
+#include <engine_game.h>
+#include <openings.h>
+#include <selfplay.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct selfplay {
+    selfplay_options_t options;
+    openings_t openings;
+    book_t book; // mapped once, read by every worker
+    tablebases_t tablebases;
+    SDL_atomic_t next_game;
+    char date[MAX_PGN_TAG_SIZE]; // read once before the workers start, localtime isn't thread safe
+
+    // everything below is shared between workers and only touched with the lock held
+    SDL_mutex* lock;
+    FILE* output;
+    int results[outcome_draw + 1];
+    int finished_games;
+    Uint64 start_counter;
+} selfplay_t;
+
+static void play_game(selfplay_t* selfplay, search_t* search, int index, pgn_game_t* game)
+{
+    const selfplay_options_t* options = &selfplay->options;
+
+    position_t start;
+    if (selfplay->openings.count) start = selfplay->openings.positions[index % selfplay->openings.count];
+    else position_set_start(&start);
+
+    // the same search plays both sides
+    search_t* searches[MAX_PLAYERS] = {search, search};
+    const search_limits_t* limits[MAX_PLAYERS] = {&options->limits, &options->limits};
+
+    engine_game_options_t game_options;
+    SDL_memset(&game_options, 0, sizeof(engine_game_options_t));
+    game_options.random_plies = options->random_plies;
+    game_options.max_plies = options->max_plies;
+    game_options.seed = options->seed ^ ((unsigned long long)(index + 1) * 0x9E3779B97F4A7C15ull);
+    game_options.book = options->book_path ? &selfplay->book : NULL;
+    game_options.book_selection = options->book_selection;
+    game_options.tablebases = options->tablebases_path ? &selfplay->tablebases : NULL;
+
+    engine_game_play(game, &start, searches, limits, &game_options);
+
+    SDL_strlcpy(game->event, "Self-play", sizeof(game->event));
+    SDL_strlcpy(game->white, "chess", sizeof(game->white));
+    SDL_strlcpy(game->black, "chess", sizeof(game->black));
+    SDL_strlcpy(game->date, selfplay->date, sizeof(game->date));
+    game->round = index + 1;
+}
+
+static int selfplay_worker(void* data)
+{
+    selfplay_t* selfplay = (selfplay_t*)data;
+
+    search_t* search = (search_t*)malloc(sizeof(search_t));
+    pgn_game_t* game = (pgn_game_t*)malloc(sizeof(pgn_game_t));
+    char* pgn = (char*)malloc(PGN_BUFFER_SIZE);
+
+    if (!search || !game || !pgn)
+    {
+        SDL_Log("Couldn't allocate memory for self-play worker");
+        free(search);
+        free(game);
+        free(pgn);
+        return -1;
+    }
+
+    search_new(search, NULL);
+    search->tablebases = selfplay->options.tablebases_path ? &selfplay->tablebases : NULL;
+
+    // workers only meet on the game counter and when a finished game is written
+    for (ever)
+    {
+        const int index = SDL_AtomicAdd(&selfplay->next_game, 1);
+        if (index >= selfplay->options.games) break;
+
+        play_game(selfplay, search, index, game);
+        const int length = pgn_write_game(game, pgn, PGN_BUFFER_SIZE);
+
+        SDL_LockMutex(selfplay->lock);
+
+        if (length > 0) fwrite(pgn, 1, length, selfplay->output);
+        selfplay->results[game->outcome]++;
+        selfplay->finished_games++;
+
+        const int progress_step = SDL_max(1, selfplay->options.games / 20);
+        if (selfplay->finished_games % progress_step == 0)
+        {
+            const double seconds = (double)(SDL_GetPerformanceCounter() - selfplay->start_counter) / SDL_GetPerformanceFrequency();
+            fprintf(stderr, "selfplay: %i/%i games, %.2f games/s\n", selfplay->finished_games, selfplay->options.games, selfplay->finished_games / seconds);
+        }
+
+        SDL_UnlockMutex(selfplay->lock);
+    }
+
+    free(search);
+    free(game);
+    free(pgn);
+
+    return 0;
+}
+
+static char parse_options(selfplay_options_t* options, int argc, char** argv)
+{
+    SDL_memset(options, 0, sizeof(selfplay_options_t));
+    options->threads = SDL_GetCPUCount();
+    options->random_plies = -1;
+    options->max_plies = SELFPLAY_DEFAULT_MAX_PLIES;
+    options->seed = 1;
+    options->output_path = SELFPLAY_DEFAULT_OUTPUT;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--selfplay") && value) options->games = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--threads") && value) options->threads = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--depth") && value) options->limits.depth = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--nodes") && value) options->limits.nodes = SDL_strtoull(argv[++i], NULL, 10);
+        else if (!SDL_strcmp(argv[i], "--openings") && value) options->openings_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--book") && value) options->book_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--book-keys") && value) options->book_keys_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--book-best")) options->book_selection = book_best;
+        else if (!SDL_strcmp(argv[i], "--tablebases") && value) options->tablebases_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--random-plies") && value) options->random_plies = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--max-plies") && value) options->max_plies = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--seed") && value) options->seed = SDL_strtoull(argv[++i], NULL, 10);
+        else if (!SDL_strcmp(argv[i], "--pgn") && value) options->output_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Unknown self-play option: %s\n", argv[i]);
+            return FALSE;
+        }
+    }
+
+    if (!options->limits.depth && !options->limits.nodes) options->limits.depth = SELFPLAY_DEFAULT_DEPTH;
+    options->threads = SDL_max(1, options->threads);
+
+    // an openings file or a book already gives variety, random moves on top are opt-in
+    if (options->random_plies < 0) options->random_plies = (options->openings_path || options->book_path) ? 0 : SELFPLAY_DEFAULT_RANDOM_PLIES;
+
+    return options->games > 0;
+}
+
+int selfplay_main(int argc, char** argv)
+{
+    selfplay_t selfplay;
+    SDL_memset(&selfplay, 0, sizeof(selfplay_t));
+
+    if (!parse_options(&selfplay.options, argc, argv))
+    {
+        fprintf(stderr, "usage: chess --selfplay <games> [--threads n] [--depth n] [--nodes n] [--openings file] [--book file] [--book-keys file] [--book-best] [--tablebases dir] [--random-plies n] [--max-plies n] [--seed n] [--pgn file]\n");
+        return 1;
+    }
+
+    position_init();
+
+    if (selfplay.options.openings_path && !openings_load(&selfplay.openings, selfplay.options.openings_path)) return 1;
+    if (selfplay.options.book_path && !book_open(&selfplay.book, selfplay.options.book_path, selfplay.options.book_keys_path)) return 1;
+    if (selfplay.options.tablebases_path && !tablebases_open(&selfplay.tablebases, selfplay.options.tablebases_path)) return 1;
+
+    selfplay.output = fopen(selfplay.options.output_path, "wb");
+    CHECK(selfplay.output, 1, "Couldn't open self-play output file");
+
+    selfplay.lock = SDL_CreateMutex();
+    pgn_get_date(selfplay.date, sizeof(selfplay.date));
+    selfplay.start_counter = SDL_GetPerformanceCounter();
+
+    const int threads_count = SDL_min(selfplay.options.threads, selfplay.options.games);
+    SDL_Thread** threads = (SDL_Thread**)calloc(threads_count, sizeof(SDL_Thread*));
+
+    for (int i = 0; i != threads_count; ++i) threads[i] = SDL_CreateThread(selfplay_worker, "selfplay", &selfplay);
+    for (int i = 0; i != threads_count; ++i) SDL_WaitThread(threads[i], NULL);
+
+    const double seconds = (double)(SDL_GetPerformanceCounter() - selfplay.start_counter) / SDL_GetPerformanceFrequency();
+
+    printf("selfplay: %i games in %.2fs on %i threads, %.2f games/s\n", selfplay.finished_games, seconds, threads_count, selfplay.finished_games / seconds);
+    printf("selfplay: white wins %i, black wins %i, draws %i -> %s\n", selfplay.results[outcome_white_wins], selfplay.results[outcome_black_wins], selfplay.results[outcome_draw], selfplay.options.output_path);
+
+    free(threads);
+    SDL_DestroyMutex(selfplay.lock);
+    fclose(selfplay.output);
+    openings_destroy(&selfplay.openings);
+    book_close(&selfplay.book);
+    tablebases_close(&selfplay.tablebases);
+
+    return 0;
+}
@@ -0,0 +1,622 @@
+#include <server.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 64
+
+// epoll ids past the connection slots
+#define LISTEN_ID SERVER_MAX_CONNECTIONS
+#define WAKE_ID (SERVER_MAX_CONNECTIONS + 1)
+
+typedef struct server_request {
+    struct server_request* next;     // next request of the same connection
+    struct server_request* next_job; // next search waiting for a worker
+    position_t position;
+    search_limits_t limits;
+    char is_done; // written by the workers with the lock held
+    char response[SERVER_MAX_RESPONSE];
+} server_request_t;
+
+typedef struct server_connection {
+    char is_used;
+    int fd; // -1 once the client is gone, the slot then waits for its searches to come back
+    char is_waiting_output;
+
+    char input[SERVER_MAX_LINE];
+    int input_length;
+    char* output;
+    int output_length;
+    int output_capacity;
+
+    // answers leave in the order the requests came, a slow search holds back the ones after it
+    server_request_t* first;
+    server_request_t* last;
+} server_connection_t;
+
+typedef struct server {
+    server_options_t options;
+    tablebases_t tablebases;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd; // workers write to it when a search is done
+    server_connection_t connections[SERVER_MAX_CONNECTIONS];
+
+    // search queue, shared with the workers
+    SDL_mutex* lock;
+    SDL_cond* has_jobs;
+    server_request_t* first_job;
+    server_request_t* last_job;
+    SDL_atomic_t stop;
+} server_t;
+
+static volatile sig_atomic_t is_interrupted = FALSE;
+
+static void on_signal(int signal_number)
+{
+    (void)signal_number;
+    is_interrupted = TRUE;
+}
+
+static char set_nonblocking(int fd) { return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) == 0; }
+
+static char watch(server_t* server, int fd, int operation, unsigned events, unsigned id)
+{
+    struct epoll_event event;
+    SDL_memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u32 = id;
+
+    return epoll_ctl(server->epoll_fd, operation, fd, &event) == 0;
+}
+
+#pragma region Workers
+static int server_worker(void* data)
+{
+    server_t* server = (server_t*)data;
+
+    // every worker keeps its search between requests, nothing gets allocated per query and the transposition table
+    // stays warm for the next position of the same game
+    search_t* search = (search_t*)malloc(sizeof(search_t));
+    CHECK(search, -1, "Couldn't allocate memory for server worker");
+
+    search_new(search, NULL);
+    search->stop = &server->stop;
+    search->tablebases = server->options.tablebases_path ? &server->tablebases : NULL;
+
+    for (ever)
+    {
+        SDL_LockMutex(server->lock);
+        while (!server->first_job && !SDL_AtomicGet(&server->stop)) SDL_CondWait(server->has_jobs, server->lock);
+
+        server_request_t* request = server->first_job;
+        if (request)
+        {
+            server->first_job = request->next_job;
+            if (!server->first_job) server->last_job = NULL;
+        }
+
+        SDL_UnlockMutex(server->lock);
+        if (!request) break;
+
+        search_result_t result;
+        search_set_position(search, &request->position, NULL, 0);
+        search_run(search, &request->limits, &result);
+
+        char uci[MAX_UCI_SIZE];
+        move_to_uci(result.best_move, uci);
+        SDL_snprintf(request->response, SERVER_MAX_RESPONSE, "ok %s %i %i %llu\n", uci, result.score, result.depth, result.nodes);
+
+        SDL_LockMutex(server->lock);
+        request->is_done = TRUE;
+        SDL_UnlockMutex(server->lock);
+
+        const uint64_t one = 1;
+        if (write(server->wake_fd, &one, sizeof(one)) != sizeof(one)) SDL_Log("Couldn't wake up the server loop");
+    }
+
+    free(search);
+    return 0;
+}
+#pragma endregion
+
+#pragma region Requests
+static void answer(server_request_t* request, const char* text)
+{
+    SDL_snprintf(request->response, SERVER_MAX_RESPONSE, "%s\n", text);
+    request->is_done = TRUE;
+}
+
+static void answer_moves(server_request_t* request)
+{
+    move_t moves[MAX_MOVES];
+    const int count = position_generate_moves(&request->position, moves, FALSE);
+
+    int length = SDL_snprintf(request->response, SERVER_MAX_RESPONSE, "ok");
+    for (int i = 0; i != count; ++i)
+    {
+        char uci[MAX_UCI_SIZE];
+        move_to_uci(moves[i], uci);
+        length += SDL_snprintf(request->response + length, SERVER_MAX_RESPONSE - length, " %s", uci);
+    }
+
+    SDL_snprintf(request->response + length, SERVER_MAX_RESPONSE - length, "\n");
+    request->is_done = TRUE;
+}
+
+static void answer_status(server_request_t* request)
+{
+    const char* reason = NULL;
+    const outcome_t outcome = position_get_outcome(&request->position, NULL, 0, &reason);
+
+    if (!reason) reason = position_in_check(&request->position) ? "check" : "-";
+
+    SDL_snprintf(request->response, SERVER_MAX_RESPONSE, "ok %s %s\n", outcome_to_string(outcome), reason);
+    request->is_done = TRUE;
+}
+
+static void handle_request(server_t* server, server_request_t* request, char* line)
+{
+    const size_t length = SDL_strlen(line);
+    if (length && line[length - 1] == '\r') line[length - 1] = '\0';
+
+    if (!SDL_strcmp(line, "ping"))
+    {
+        answer(request, "ok");
+        return;
+    }
+
+    char* arguments = SDL_strchr(line, ' ');
+    if (!arguments)
+    {
+        answer(request, "error unknown request");
+        return;
+    }
+
+    *arguments++ = '\0';
+
+    // the verb is checked first, an unknown request is never blamed on its fen
+    const char is_best = !SDL_strcmp(line, "best");
+    if (!is_best && SDL_strcmp(line, "moves") && SDL_strcmp(line, "status"))
+    {
+        answer(request, "error unknown request");
+        return;
+    }
+
+    // best takes the depth before the position
+    int depth = 0;
+    if (is_best)
+    {
+        depth = SDL_atoi(arguments);
+        arguments = SDL_strchr(arguments, ' ');
+
+        if (depth <= 0 || depth >= MAX_SEARCH_DEPTH || !arguments)
+        {
+            answer(request, "error expected best <depth> <fen>");
+            return;
+        }
+
+        arguments++;
+    }
+
+    if (!position_from_fen(&request->position, arguments))
+    {
+        answer(request, "error invalid fen");
+        return;
+    }
+
+    if (!SDL_strcmp(line, "moves")) answer_moves(request);
+    else if (!SDL_strcmp(line, "status")) answer_status(request);
+    else
+    {
+        move_t moves[MAX_MOVES];
+        if (!position_generate_moves(&request->position, moves, FALSE))
+        {
+            answer(request, "error no legal moves");
+            return;
+        }
+
+        request->limits.depth = depth;
+
+        SDL_LockMutex(server->lock);
+        if (server->last_job) server->last_job->next_job = request;
+        else server->first_job = request;
+        server->last_job = request;
+        SDL_CondSignal(server->has_jobs);
+        SDL_UnlockMutex(server->lock);
+    }
+}
+#pragma endregion
+
+#pragma region Connections
+static void release_connection(server_connection_t* connection)
+{
+    free(connection->output);
+    SDL_memset(connection, 0, sizeof(server_connection_t));
+    connection->fd = -1;
+}
+
+static void close_connection(server_t* server, server_connection_t* connection)
+{
+    if (connection->fd < 0) return;
+
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->fd = -1;
+    connection->output_length = 0;
+}
+
+static void write_output(server_t* server, server_connection_t* connection, unsigned id)
+{
+    int written = 0;
+
+    while (written != connection->output_length)
+    {
+        const ssize_t count = send(connection->fd, connection->output + written, connection->output_length - written, MSG_NOSIGNAL);
+
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (count <= 0)
+        {
+            close_connection(server, connection);
+            return;
+        }
+
+        written += (int)count;
+    }
+
+    SDL_memmove(connection->output, connection->output + written, connection->output_length - written);
+    connection->output_length -= written;
+
+    // only ask for EPOLLOUT while the client isn't keeping up
+    const char is_waiting_output = connection->output_length != 0;
+    if (is_waiting_output != connection->is_waiting_output)
+    {
+        watch(server, connection->fd, EPOLL_CTL_MOD, EPOLLIN | (is_waiting_output ? EPOLLOUT : 0), id);
+        connection->is_waiting_output = is_waiting_output;
+    }
+}
+
+static char append_output(server_connection_t* connection, const char* text)
+{
+    const int length = (int)SDL_strlen(text);
+
+    if (connection->output_length + length > connection->output_capacity)
+    {
+        const int capacity = SDL_max(connection->output_capacity * 2, connection->output_length + length);
+        char* output = (char*)realloc(connection->output, capacity);
+        CHECK(output, FALSE, "Couldn't grow connection output");
+
+        connection->output = output;
+        connection->output_capacity = capacity;
+    }
+
+    SDL_memcpy(connection->output + connection->output_length, text, length);
+    connection->output_length += length;
+
+    return TRUE;
+}
+
+// sends every answer ready at the front of the queue in one write
+static void flush_connection(server_t* server, server_connection_t* connection, unsigned id)
+{
+    SDL_LockMutex(server->lock);
+
+    while (connection->first && connection->first->is_done)
+    {
+        server_request_t* request = connection->first;
+        connection->first = request->next;
+        if (!connection->first) connection->last = NULL;
+
+        if (connection->fd >= 0 && !append_output(connection, request->response)) close_connection(server, connection);
+        free(request);
+    }
+
+    SDL_UnlockMutex(server->lock);
+
+    if (connection->fd >= 0 && connection->output_length) write_output(server, connection, id);
+    if (connection->fd < 0 && !connection->first) release_connection(connection);
+}
+
+static void read_connection(server_t* server, server_connection_t* connection, unsigned id)
+{
+    for (ever)
+    {
+        const ssize_t count = read(connection->fd, connection->input + connection->input_length, SERVER_MAX_LINE - connection->input_length);
+
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (count <= 0)
+        {
+            close_connection(server, connection);
+            break;
+        }
+
+        connection->input_length += (int)count;
+
+        // every complete line is a request, a partial one waits for the next read
+        int start = 0;
+        for (int i = 0; i != connection->input_length; ++i)
+        {
+            if (connection->input[i] != '\n') continue;
+
+            connection->input[i] = '\0';
+
+            server_request_t* request = (server_request_t*)calloc(1, sizeof(server_request_t));
+            if (!request)
+            {
+                SDL_Log("Couldn't allocate server request");
+                close_connection(server, connection);
+                break;
+            }
+
+            handle_request(server, request, connection->input + start);
+
+            // the workers never touch the queue links, only is_done
+            if (connection->last) connection->last->next = request;
+            else connection->first = request;
+            connection->last = request;
+
+            start = i + 1;
+        }
+
+        if (connection->fd < 0) break;
+
+        SDL_memmove(connection->input, connection->input + start, connection->input_length - start);
+        connection->input_length -= start;
+
+        if (connection->input_length == SERVER_MAX_LINE)
+        {
+            SDL_Log("Request longer than %i bytes, closing the connection", SERVER_MAX_LINE);
+            close_connection(server, connection);
+            break;
+        }
+    }
+
+    flush_connection(server, connection, id);
+}
+
+static void accept_connections(server_t* server)
+{
+    for (ever)
+    {
+        const int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) break;
+
+        int slot = 0;
+        while (slot != SERVER_MAX_CONNECTIONS && server->connections[slot].is_used) slot++;
+
+        if (slot == SERVER_MAX_CONNECTIONS || !set_nonblocking(fd) || !watch(server, fd, EPOLL_CTL_ADD, EPOLLIN, (unsigned)slot))
+        {
+            SDL_Log("Couldn't accept another connection");
+            close(fd);
+            continue;
+        }
+
+        server->connections[slot].is_used = TRUE;
+        server->connections[slot].fd = fd;
+    }
+}
+#pragma endregion
+
+static int open_listen_socket(const server_options_t* options)
+{
+    int fd = -1;
+
+    if (options->socket_path)
+    {
+        struct sockaddr_un address;
+        SDL_memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        SDL_strlcpy(address.sun_path, options->socket_path, sizeof(address.sun_path));
+
+        // a socket file left by a previous run would make bind fail
+        unlink(options->socket_path);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    } else
+    {
+        struct sockaddr_in address;
+        SDL_memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((unsigned short)options->port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        const int reuse = 1;
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        if (fd >= 0 && bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    if (fd >= 0 && (listen(fd, SOMAXCONN) != 0 || !set_nonblocking(fd)))
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+static void run_loop(server_t* server)
+{
+    struct epoll_event events[MAX_EVENTS];
+
+    while (!is_interrupted)
+    {
+        const int count = epoll_wait(server->epoll_fd, events, MAX_EVENTS, -1);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) break;
+
+        for (int i = 0; i != count; ++i)
+        {
+            const unsigned id = events[i].data.u32;
+
+            if (id == LISTEN_ID) accept_connections(server);
+            else if (id == WAKE_ID)
+            {
+                uint64_t value = 0;
+                if (read(server->wake_fd, &value, sizeof(value)) < 0) SDL_Log("Couldn't read the wake up counter");
+
+                // a worker doesn't say which search it finished, every waiting connection gets a look
+                for (unsigned slot = 0; slot != SERVER_MAX_CONNECTIONS; ++slot)
+                {
+                    if (server->connections[slot].first) flush_connection(server, &server->connections[slot], slot);
+                }
+            } else
+            {
+                server_connection_t* connection = &server->connections[id];
+                if (connection->fd < 0) continue;
+
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) read_connection(server, connection, id);
+                else if (events[i].events & EPOLLOUT) write_output(server, connection, id);
+            }
+        }
+    }
+}
+
+static char parse_options(server_options_t* options, int argc, char** argv)
+{
+    SDL_memset(options, 0, sizeof(server_options_t));
+    options->port = SERVER_DEFAULT_PORT;
+    options->threads = SDL_GetCPUCount();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--serve")) continue;
+        else if (!SDL_strcmp(argv[i], "--socket") && value) options->socket_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--port") && value) options->port = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--threads") && value) options->threads = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--tablebases") && value) options->tablebases_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "Unknown server option: %s\n", argv[i]);
+            return FALSE;
+        }
+    }
+
+    options->threads = SDL_max(1, options->threads);
+    return options->port > 0 && options->port <= 65535;
+}
+
+int server_main(int argc, char** argv)
+{
+    server_t* server = (server_t*)calloc(1, sizeof(server_t));
+    CHECK(server, 1, "Couldn't allocate memory for the server");
+
+    if (!parse_options(&server->options, argc, argv))
+    {
+        fprintf(stderr, "usage: chess --serve [--socket path | --port n] [--threads n] [--tablebases dir]\n");
+        free(server);
+        return 1;
+    }
+
+    position_init();
+
+    for (int i = 0; i != SERVER_MAX_CONNECTIONS; ++i) server->connections[i].fd = -1;
+    if (server->options.tablebases_path && !tablebases_open(&server->tablebases, server->options.tablebases_path)) SDL_Log("No tablebase found in %s", server->options.tablebases_path);
+
+    server->listen_fd = open_listen_socket(&server->options);
+    server->epoll_fd = epoll_create1(0);
+    server->wake_fd = eventfd(0, EFD_NONBLOCK);
+
+    if (server->listen_fd < 0 || server->epoll_fd < 0 || server->wake_fd < 0 || !watch(server, server->listen_fd, EPOLL_CTL_ADD, EPOLLIN, LISTEN_ID) ||
+        !watch(server, server->wake_fd, EPOLL_CTL_ADD, EPOLLIN, WAKE_ID))
+    {
+        SDL_Log("Couldn't start the server: %s", strerror(errno));
+        if (server->listen_fd >= 0) close(server->listen_fd);
+        if (server->epoll_fd >= 0) close(server->epoll_fd);
+        if (server->wake_fd >= 0) close(server->wake_fd);
+        tablebases_close(&server->tablebases);
+        free(server);
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    server->lock = SDL_CreateMutex();
+    server->has_jobs = SDL_CreateCond();
+
+    SDL_Thread** threads = (SDL_Thread**)calloc(server->options.threads, sizeof(SDL_Thread*));
+    for (int i = 0; i != server->options.threads; ++i) threads[i] = SDL_CreateThread(server_worker, "server", server);
+
+    if (server->options.socket_path) printf("server: listening on %s with %i search threads\n", server->options.socket_path, server->options.threads);
+    else printf("server: listening on 127.0.0.1:%i with %i search threads\n", server->options.port, server->options.threads);
+    fflush(stdout);
+
+    run_loop(server);
+
+    // the running searches abort, the queued ones are dropped with their connections
+    SDL_LockMutex(server->lock);
+    SDL_AtomicSet(&server->stop, TRUE);
+    SDL_CondBroadcast(server->has_jobs);
+    SDL_UnlockMutex(server->lock);
+
+    for (int i = 0; i != server->options.threads; ++i) SDL_WaitThread(threads[i], NULL);
+
+    for (int i = 0; i != SERVER_MAX_CONNECTIONS; ++i)
+    {
+        server_connection_t* connection = &server->connections[i];
+        close_connection(server, connection);
+
+        while (connection->first)
+        {
+            server_request_t* request = connection->first;
+            connection->first = request->next;
+            free(request);
+        }
+
+        free(connection->output);
+    }
+
+    close(server->listen_fd);
+    close(server->epoll_fd);
+    close(server->wake_fd);
+    if (server->options.socket_path) unlink(server->options.socket_path);
+
+    free(threads);
+    SDL_DestroyCond(server->has_jobs);
+    SDL_DestroyMutex(server->lock);
+    tablebases_close(&server->tablebases);
+    free(server);
+
+    printf("server: stopped\n");
+    return 0;
+}
+
+#else
+
+int server_main(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    fprintf(stderr, "The analysis server is built on epoll and only runs on Linux\n");
+    return 1;
+}
+
+#endif
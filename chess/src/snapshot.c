@@ -0,0 +1,65 @@
+#include <snapshot.h>
+
+#include <SDL.h>
+
+void snapshot_clear(snapshot_t* snapshot)
+{
+    SDL_memset(snapshot, 0, sizeof(snapshot_t));
+    snapshot->enpassant_index = INVALID_INDEX;
+    snapshot->fullmove_number = 1;
+}
+
+void snapshot_set_square(snapshot_t* snapshot, int index, piece_type_t type, char is_white)
+{
+    if (CHECK_IDX_RANGE(index)) return;
+
+    const unsigned char value = (type == none) ? 0 : (unsigned char)(type | (is_white ? SNAPSHOT_WHITE_BIT : 0));
+    const int shift = (index & 1) ? 4 : 0;
+
+    unsigned char* byte = &snapshot->squares[index >> 1];
+    *byte = (unsigned char)((*byte & ~(0xF << shift)) | (value << shift));
+}
+
+piece_type_t snapshot_get_square(const snapshot_t* snapshot, int index, char* is_white)
+{
+    if (CHECK_IDX_RANGE(index)) return none;
+
+    const unsigned char value = (snapshot->squares[index >> 1] >> ((index & 1) ? 4 : 0)) & 0xF;
+
+    if (is_white) *is_white = (value & SNAPSHOT_WHITE_BIT) ? TRUE : FALSE;
+    return (piece_type_t)(value & SNAPSHOT_TYPE_MASK);
+}
+
+char snapshot_is_white_to_move(const snapshot_t* snapshot) { return (snapshot->flags & SNAPSHOT_WHITE_TO_MOVE) ? TRUE : FALSE; }
+
+void history_reset(history_t* history, const snapshot_t* initial)
+{
+    history->first_ply = 0;
+    history->last_ply = 0;
+    history->current_ply = 0;
+    history->plies[0] = *initial;
+}
+
+void history_push(history_t* history, const snapshot_t* snapshot)
+{
+    // a new move after an undo starts a new line, the redo plies are gone
+    history->last_ply = ++history->current_ply;
+    history->plies[history->current_ply % HISTORY_SIZE] = *snapshot;
+
+    // the oldest ply has just been overwritten
+    if (history->last_ply - history->first_ply >= HISTORY_SIZE) history->first_ply++;
+}
+
+const snapshot_t* history_undo(history_t* history) { return history_seek(history, history->current_ply - 1); }
+
+const snapshot_t* history_redo(history_t* history) { return history_seek(history, history->current_ply + 1); }
+
+const snapshot_t* history_seek(history_t* history, int ply)
+{
+    if (ply < history->first_ply || ply > history->last_ply || ply == history->current_ply) return NULL;
+
+    history->current_ply = ply;
+    return history_current(history);
+}
+
+const snapshot_t* history_current(const history_t* history) { return &history->plies[history->current_ply % HISTORY_SIZE]; }
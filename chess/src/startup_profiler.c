@@ -0,0 +1,116 @@
+#include <private.h>
+#include <startup_profiler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+typedef struct startup_profiler {
+    char is_enabled;
+    char is_finished;
+    const char* json_path;
+    unsigned long long origin;
+    startup_phase_t phases[MAX_STARTUP_PHASES];
+    int phases_count;
+    int open_phases[MAX_STARTUP_PHASE_DEPTH];
+    int depth;
+} startup_profiler_t;
+
+static startup_profiler_t profiler;
+
+static double to_ms(unsigned long long ticks) { return (double)(ticks * 1000.0) / (double)SDL_GetPerformanceFrequency(); }
+
+void startup_profiler_init(const char* output)
+{
+    SDL_memset(&profiler, 0, sizeof(startup_profiler_t));
+
+    // command line wins over the environment
+    if (!output) output = SDL_getenv(STARTUP_PROFILER_ENV);
+    if (!output || !*output || !SDL_strcmp(output, "0")) return;
+
+    profiler.is_enabled = TRUE;
+    profiler.json_path = (!SDL_strcmp(output, "1") || !SDL_strcmp(output, "stderr")) ? NULL : output;
+    profiler.origin = SDL_GetPerformanceCounter();
+}
+
+void startup_profiler_begin(const char* phase)
+{
+    if (!profiler.is_enabled || profiler.is_finished) return;
+
+    if (profiler.phases_count == MAX_STARTUP_PHASES || profiler.depth == MAX_STARTUP_PHASE_DEPTH)
+    {
+        SDL_Log("Startup profiler is full, dropping phase %s", phase);
+        return;
+    }
+
+    startup_phase_t* current = &profiler.phases[profiler.phases_count];
+    current->name = phase;
+    current->depth = profiler.depth;
+    current->begin = SDL_GetPerformanceCounter();
+
+    profiler.open_phases[profiler.depth++] = profiler.phases_count++;
+}
+
+void startup_profiler_end()
+{
+    if (!profiler.is_enabled || profiler.is_finished || profiler.depth == 0) return;
+
+    profiler.phases[profiler.open_phases[--profiler.depth]].end = SDL_GetPerformanceCounter();
+}
+
+static void report_stderr(unsigned long long total)
+{
+    fprintf(stderr, "---------------- startup phases ----------------\n");
+
+    for (int i = 0; i != profiler.phases_count; ++i)
+    {
+        const startup_phase_t* phase = &profiler.phases[i];
+        fprintf(stderr, "%*s%-*s %9.3f ms  (at %9.3f ms)\n", phase->depth * 2, "", 36 - phase->depth * 2, phase->name, to_ms(phase->end - phase->begin), to_ms(phase->begin - profiler.origin));
+    }
+
+    fprintf(stderr, "%-36s %9.3f ms\n", "total", to_ms(total));
+    fprintf(stderr, "------------------------------------------------\n");
+}
+
+static void report_json(unsigned long long total)
+{
+    FILE* file = fopen(profiler.json_path, "w");
+    if (!file)
+    {
+        SDL_Log("Couldn't open %s to write startup timings", profiler.json_path);
+        return;
+    }
+
+    fprintf(file, "{\n  \"total_ms\": %.3f,\n  \"phases\": [\n", to_ms(total));
+
+    for (int i = 0; i != profiler.phases_count; ++i)
+    {
+        const startup_phase_t* phase = &profiler.phases[i];
+        fprintf(file, "    {\"name\": \"%s\", \"depth\": %i, \"start_ms\": %.3f, \"duration_ms\": %.3f}%s\n", phase->name, phase->depth, to_ms(phase->begin - profiler.origin), to_ms(phase->end - phase->begin), i + 1 == profiler.phases_count ? "" : ",");
+    }
+
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+void startup_profiler_finish()
+{
+    if (!profiler.is_enabled || profiler.is_finished) return;
+
+    // close whatever is still open, usually the first frame
+    while (profiler.depth > 0)
+    {
+        startup_profiler_end();
+    }
+
+    const unsigned long long total = SDL_GetPerformanceCounter() - profiler.origin;
+
+    if (profiler.json_path)
+        report_json(total);
+    else
+        report_stderr(total);
+
+    profiler.is_finished = TRUE;
+}
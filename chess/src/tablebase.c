@@ -0,0 +1,427 @@
+#include <tablebase.h>
+
+#include <SDL.h>
+
+#include <limits.h>
+#include <stdio.h>
+
+#define ROW(index) ((index) / CELLS_PER_ROW)
+#define COLUMN(index) ((index) % CELLS_PER_ROW)
+
+// board symmetries that bring the white king where the tables expect it
+#define MIRROR_FILE 0x1
+#define MIRROR_RANK 0x2
+#define TRANSPOSE 0x4
+
+#define TRIANGLE_SQUARES 10
+#define HALF_BOARD_SQUARES 32
+
+// pieces after the king, strongest first
+static const char piece_order[] = "QRBNP";
+static const piece_type_t piece_order_types[] = {queen, rook, bishop, knight, pawn};
+
+// a1 b1 c1 d1 b2 c2 d2 c3 d3 d4
+static const int triangle_squares[TRIANGLE_SQUARES] = {56, 57, 58, 59, 49, 50, 51, 42, 43, 35};
+
+static int get_regions_count(const tablebase_t* table) { return table->has_pawns ? HALF_BOARD_SQUARES : TRIANGLE_SQUARES; }
+
+static int get_region(const tablebase_t* table, int square)
+{
+    if (table->has_pawns) return ROW(square) * 4 + COLUMN(square);
+
+    for (int i = 0; i != TRIANGLE_SQUARES; ++i)
+    {
+        if (triangle_squares[i] == square) return i;
+    }
+
+    return -1;
+}
+
+static int get_region_square(const tablebase_t* table, int region) { return table->has_pawns ? (region / 4) * CELLS_PER_ROW + region % 4 : triangle_squares[region]; }
+
+static int apply_transform(int square, int transform)
+{
+    if (transform & MIRROR_FILE) square ^= CELLS_PER_ROW - 1;
+    if (transform & MIRROR_RANK) square ^= BOARD_SZ - CELLS_PER_ROW;
+
+    // swaps files and ranks, the a1-h8 diagonal stays where it is
+    if (transform & TRANSPOSE) square = (CELLS_PER_ROW - 1 - COLUMN(square)) * CELLS_PER_ROW + (CELLS_PER_ROW - 1 - ROW(square));
+
+    return square;
+}
+
+static int get_transform(const tablebase_t* table, int king_square)
+{
+    int transform = 0;
+
+    if (COLUMN(king_square) > 3)
+    {
+        transform |= MIRROR_FILE;
+        king_square = apply_transform(king_square, MIRROR_FILE);
+    }
+
+    // pawns only allow the left-right mirror
+    if (table->has_pawns) return transform;
+
+    if (ROW(king_square) < 4)
+    {
+        transform |= MIRROR_RANK;
+        king_square = apply_transform(king_square, MIRROR_RANK);
+    }
+
+    // rank above the file: below the a1-h8 diagonal after transposing
+    if (CELLS_PER_ROW - 1 - ROW(king_square) > COLUMN(king_square)) transform |= TRANSPOSE;
+
+    return transform;
+}
+
+// positive when side a has more material than side b, both are the pieces after the king in piece_order
+static int compare_sides(const char* a, const char* b)
+{
+    const int length_a = (int)SDL_strlen(a), length_b = (int)SDL_strlen(b);
+    if (length_a != length_b) return length_a - length_b;
+
+    for (int i = 0; i != length_a; ++i)
+    {
+        if (a[i] != b[i]) return (int)(SDL_strchr(piece_order, b[i]) - SDL_strchr(piece_order, a[i]));
+    }
+
+    return 0;
+}
+
+char tablebase_init(tablebase_t* table, const char* signature)
+{
+    SDL_memset(table, 0, sizeof(tablebase_t));
+
+    const size_t length = SDL_strlen(signature);
+    if (length < 2 || length > TABLEBASE_MAX_PIECES || signature[0] != 'K') return FALSE;
+
+    const char* black_king = SDL_strchr(signature + 1, 'K');
+    if (!black_king || SDL_strchr(black_king + 1, 'K')) return FALSE;
+
+    SDL_strlcpy(table->signature, signature, sizeof(table->signature));
+    table->pieces[table->pieces_count++] = king;
+    table->pieces[table->pieces_count++] = -king;
+
+    for (const char* c = signature + 1; *c; ++c)
+    {
+        if (c == black_king) continue;
+
+        const char* letter = SDL_strchr(piece_order, *c);
+        if (!letter) return FALSE;
+
+        const piece_type_t type = piece_order_types[letter - piece_order];
+        table->pieces[table->pieces_count++] = (signed char)(c < black_king ? type : -(int)type);
+        table->has_pawns |= (type == pawn);
+    }
+
+    table->positions_count = 2 * get_regions_count(table);
+    for (int i = 1; i != table->pieces_count; ++i) table->positions_count *= BOARD_SZ;
+
+    return TRUE;
+}
+
+static unsigned int get_index(const tablebase_t* table, const signed char* squares, char is_white_to_move, int transform)
+{
+    signed char transformed[BOARD_SZ] = {0};
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        if (squares[i]) transformed[apply_transform(i, transform)] = squares[i];
+    }
+
+    int cells[TABLEBASE_MAX_PIECES];
+    char is_used[TABLEBASE_MAX_PIECES] = {0};
+
+    // pieces of the same kind go in board order, so that swapping them gives the same index
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        if (!transformed[i]) continue;
+
+        int slot = 0;
+        while (slot != table->pieces_count && (is_used[slot] || table->pieces[slot] != transformed[i])) slot++;
+        if (slot == table->pieces_count) return table->positions_count;
+
+        is_used[slot] = TRUE;
+        cells[slot] = i;
+    }
+
+    for (int i = 0; i != table->pieces_count; ++i)
+    {
+        if (!is_used[i]) return table->positions_count;
+    }
+
+    unsigned int index = (unsigned int)get_region(table, cells[0]);
+    unsigned int multiplier = (unsigned int)get_regions_count(table);
+
+    for (int i = 1; i != table->pieces_count; ++i)
+    {
+        index += (unsigned int)cells[i] * multiplier;
+        multiplier *= BOARD_SZ;
+    }
+
+    return index + (is_white_to_move ? multiplier : 0);
+}
+
+unsigned int tablebase_index(const tablebase_t* table, const signed char* squares, char is_white_to_move)
+{
+    int king_square = 0;
+    while (king_square != BOARD_SZ && squares[king_square] != king) king_square++;
+    if (king_square == BOARD_SZ) return table->positions_count;
+
+    const int transform = get_transform(table, king_square);
+    const unsigned int index = get_index(table, squares, is_white_to_move, transform);
+
+    // a king on the a1-h8 diagonal leaves two ways to fold the board, the smallest index is the one kept
+    const int folded_king = apply_transform(king_square, transform);
+    if (table->has_pawns || CELLS_PER_ROW - 1 - ROW(folded_king) != COLUMN(folded_king)) return index;
+
+    return SDL_min(index, get_index(table, squares, is_white_to_move, transform ^ TRANSPOSE));
+}
+
+char tablebase_decode(const tablebase_t* table, unsigned int index, signed char* squares, char* is_white_to_move)
+{
+    const unsigned int original_index = index;
+    SDL_memset(squares, 0, sizeof(signed char) * BOARD_SZ);
+
+    const int regions_count = get_regions_count(table);
+    int cells[TABLEBASE_MAX_PIECES];
+
+    cells[0] = get_region_square(table, index % regions_count);
+    index /= regions_count;
+
+    for (int i = 1; i != table->pieces_count; ++i)
+    {
+        cells[i] = index % BOARD_SZ;
+        index /= BOARD_SZ;
+    }
+
+    *is_white_to_move = (index != 0);
+
+    for (int i = 0; i != table->pieces_count; ++i)
+    {
+        // two pieces on one cell or a pawn where it can't be
+        if (squares[cells[i]]) return FALSE;
+        if ((table->pieces[i] == pawn || table->pieces[i] == -pawn) && (ROW(cells[i]) == 0 || ROW(cells[i]) == CELLS_PER_ROW - 1)) return FALSE;
+
+        squares[cells[i]] = table->pieces[i];
+    }
+
+    // the same position folded another way, or with twin pieces swapped, is only kept once
+    return tablebase_index(table, squares, *is_white_to_move) == original_index;
+}
+
+unsigned char tablebase_get(const tablebase_t* table, unsigned int index)
+{
+    if (index >= table->positions_count) return TABLEBASE_UNKNOWN;
+    if (table->values) return table->values[index];
+
+    // (count, value) pairs
+    const unsigned char* run = table->blocks + table->offsets[index / TABLEBASE_BLOCK_SIZE];
+    const unsigned char* end = table->blocks + table->offsets[index / TABLEBASE_BLOCK_SIZE + 1];
+
+    for (unsigned int offset = index % TABLEBASE_BLOCK_SIZE; run < end; run += 2)
+    {
+        if (offset < run[0]) return run[1];
+        offset -= run[0];
+    }
+
+    return TABLEBASE_UNKNOWN;
+}
+
+char tablebase_write(const tablebase_t* table, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    CHECK(file, FALSE, "Couldn't write tablebase file");
+
+    tablebase_header_t header;
+    SDL_memset(&header, 0, sizeof(tablebase_header_t));
+    header.magic = TABLEBASE_MAGIC;
+    header.version = TABLEBASE_VERSION;
+    SDL_strlcpy(header.signature, table->signature, sizeof(header.signature));
+    header.positions_count = table->positions_count;
+    header.blocks_count = (table->positions_count + TABLEBASE_BLOCK_SIZE - 1) / TABLEBASE_BLOCK_SIZE;
+    header.max_dtm = (uint32_t)table->max_dtm;
+
+    uint32_t* offsets = (uint32_t*)SDL_calloc(header.blocks_count + 1, sizeof(uint32_t));
+    unsigned char* runs = (unsigned char*)SDL_malloc(TABLEBASE_BLOCK_SIZE * 2);
+
+    if (!offsets || !runs)
+    {
+        SDL_free(offsets);
+        SDL_free(runs);
+        fclose(file);
+        return FALSE;
+    }
+
+    // the offsets are only known once the blocks are written, they get filled in at the end
+    fwrite(&header, sizeof(tablebase_header_t), 1, file);
+    fwrite(offsets, sizeof(uint32_t), header.blocks_count + 1, file);
+
+    for (uint32_t block = 0; block != header.blocks_count; ++block)
+    {
+        const unsigned int first = block * TABLEBASE_BLOCK_SIZE;
+        const unsigned int last = SDL_min(first + TABLEBASE_BLOCK_SIZE, table->positions_count);
+        int length = 0;
+
+        // illegal positions are never probed, they join whatever run is around them
+        for (unsigned int i = first; i < last;)
+        {
+            unsigned char value = table->values[i];
+            unsigned int count = 1;
+
+            for (; i + count < last && count < UCHAR_MAX; ++count)
+            {
+                const unsigned char next = table->values[i + count];
+                if (value == TABLEBASE_ILLEGAL) value = next;
+                else if (next != value && next != TABLEBASE_ILLEGAL) break;
+            }
+
+            runs[length++] = (unsigned char)count;
+            runs[length++] = value;
+            i += count;
+        }
+
+        fwrite(runs, 1, length, file);
+        offsets[block + 1] = offsets[block] + length;
+    }
+
+    fseek(file, sizeof(tablebase_header_t), SEEK_SET);
+    const char is_written = fwrite(offsets, sizeof(uint32_t), header.blocks_count + 1, file) == header.blocks_count + 1;
+
+    fclose(file);
+    SDL_free(offsets);
+    SDL_free(runs);
+
+    return is_written;
+}
+
+char tablebase_get_signature(const signed char* squares, char* signature)
+{
+    char sides[MAX_PLAYERS][TABLEBASE_SIGNATURE_SIZE] = {{0}};
+    int lengths[MAX_PLAYERS] = {0};
+
+    for (int i = 0; i != (int)SDL_arraysize(piece_order_types); ++i)
+    {
+        for (int j = 0; j != BOARD_SZ; ++j)
+        {
+            if (squares[j] == piece_order_types[i] && lengths[1] < TABLEBASE_MAX_PIECES) sides[1][lengths[1]++] = piece_order[i];
+            if (squares[j] == -(int)piece_order_types[i] && lengths[0] < TABLEBASE_MAX_PIECES) sides[0][lengths[0]++] = piece_order[i];
+        }
+    }
+
+    const char is_black_stronger = compare_sides(sides[1], sides[0]) < 0;
+    SDL_snprintf(signature, TABLEBASE_SIGNATURE_SIZE, "K%sK%s", sides[is_black_stronger ? 0 : 1], sides[is_black_stronger ? 1 : 0]);
+
+    return is_black_stronger;
+}
+
+static char open_table(tablebase_t* table, const char* path, const char* signature)
+{
+    if (!tablebase_init(table, signature) || !mapped_file_open(&table->file, path)) return FALSE;
+
+    const tablebase_header_t* header = (const tablebase_header_t*)table->file.data;
+
+    char is_valid = table->file.size >= sizeof(tablebase_header_t) && header->magic == TABLEBASE_MAGIC && header->version == TABLEBASE_VERSION &&
+                    !SDL_strncmp(header->signature, signature, TABLEBASE_SIGNATURE_SIZE) && header->positions_count == table->positions_count &&
+                    header->blocks_count == (table->positions_count + TABLEBASE_BLOCK_SIZE - 1) / TABLEBASE_BLOCK_SIZE;
+
+    const size_t blocks_start = is_valid ? sizeof(tablebase_header_t) + (header->blocks_count + 1) * sizeof(uint32_t) : 0;
+    is_valid = is_valid && table->file.size >= blocks_start;
+
+    if (is_valid)
+    {
+        table->offsets = (const uint32_t*)(table->file.data + sizeof(tablebase_header_t));
+        table->blocks = table->file.data + blocks_start;
+        table->max_dtm = (int)header->max_dtm;
+        is_valid = blocks_start + table->offsets[header->blocks_count] <= table->file.size;
+    }
+
+    if (!is_valid)
+    {
+        SDL_Log("Tablebase %s is invalid or out of date, ignoring it", path);
+        mapped_file_close(&table->file);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+char tablebases_open(tablebases_t* tablebases, const char* directory)
+{
+    SDL_memset(tablebases, 0, sizeof(tablebases_t));
+
+    // every material with up to four pieces, the stronger side first
+    static const char* extras[] = {"", "Q", "R", "B", "N", "P", "QQ", "QR", "QB", "QN", "QP", "RR", "RB", "RN", "RP", "BB", "BN", "BP", "NN", "NP", "PP"};
+
+    for (int white = 0; white != (int)SDL_arraysize(extras); ++white)
+    {
+        for (int black = 0; black != (int)SDL_arraysize(extras); ++black)
+        {
+            if (SDL_strlen(extras[white]) + SDL_strlen(extras[black]) + 2 > TABLEBASE_MAX_PIECES || !extras[white][0] || compare_sides(extras[white], extras[black]) < 0) continue;
+            if (tablebases->count == MAX_TABLEBASES) break;
+
+            char signature[TABLEBASE_SIGNATURE_SIZE];
+            char path[MAX_BUFFER_SIZE * 4];
+            SDL_snprintf(signature, sizeof(signature), "K%sK%s", extras[white], extras[black]);
+            SDL_snprintf(path, sizeof(path), "%s/%s%s", directory, signature, TABLEBASE_EXTENSION);
+
+            if (open_table(&tablebases->tables[tablebases->count], path, signature)) tablebases->count++;
+        }
+    }
+
+    return tablebases->count > 0;
+}
+
+void tablebases_close(tablebases_t* tablebases)
+{
+    for (int i = 0; i != tablebases->count; ++i) mapped_file_close(&tablebases->tables[i].file);
+    SDL_memset(tablebases, 0, sizeof(tablebases_t));
+}
+
+const tablebase_t* tablebases_find(const tablebases_t* tablebases, const char* signature)
+{
+    for (int i = 0; i != tablebases->count; ++i)
+    {
+        if (!SDL_strcmp(tablebases->tables[i].signature, signature)) return &tablebases->tables[i];
+    }
+
+    return NULL;
+}
+
+unsigned char tablebases_get_value(const tablebases_t* tablebases, const position_t* position)
+{
+    if (!tablebases || !tablebases->count || position->castling || position->enpassant_index != INVALID_INDEX) return TABLEBASE_UNKNOWN;
+
+    int pieces_count = 0;
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        if (position->squares[i] && ++pieces_count > TABLEBASE_MAX_PIECES) return TABLEBASE_UNKNOWN;
+    }
+
+    if (pieces_count == 2) return TABLEBASE_DRAW;
+
+    char signature[TABLEBASE_SIGNATURE_SIZE];
+    const char is_flipped = tablebase_get_signature(position->squares, signature);
+
+    const tablebase_t* table = tablebases_find(tablebases, signature);
+    if (!table) return TABLEBASE_UNKNOWN;
+
+    if (!is_flipped) return tablebase_get(table, tablebase_index(table, position->squares, position->is_white_to_move));
+
+    // the tables have the stronger side as white: swap the colors and turn the board upside down
+    signed char squares[BOARD_SZ];
+    for (int i = 0; i != BOARD_SZ; ++i) squares[i ^ (BOARD_SZ - CELLS_PER_ROW)] = (signed char)-position->squares[i];
+
+    return tablebase_get(table, tablebase_index(table, squares, !position->is_white_to_move));
+}
+
+char tablebases_probe(const tablebases_t* tablebases, const position_t* position, int* wdl, int* dtm)
+{
+    const unsigned char value = tablebases_get_value(tablebases, position);
+    if (value == TABLEBASE_UNKNOWN || value == TABLEBASE_ILLEGAL) return FALSE;
+
+    *dtm = (value == TABLEBASE_DRAW) ? 0 : value - TABLEBASE_MATE;
+    *wdl = (value == TABLEBASE_DRAW) ? 0 : ((*dtm % 2) ? 1 : -1);
+
+    return TRUE;
+}
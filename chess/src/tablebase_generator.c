@@ -0,0 +1,444 @@
+#include <tablebase_generator.h>
+
+#include <SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ROW(index) ((index) / CELLS_PER_ROW)
+#define COLUMN(index) ((index) % CELLS_PER_ROW)
+
+typedef struct generator {
+    tablebases_t tablebases; // finished tables, the ones being built probe their children here
+    const char* directory;
+    int threads;
+
+    // the table being built: workers read table->values and write next, that become the values after each pass
+    tablebase_t* table;
+    unsigned char* next;
+    int pass;
+    int children_max_dtm;
+    SDL_atomic_t next_block;
+    SDL_atomic_t changed;
+
+    // one bit per position: only the parents of what the last pass resolved need another look
+    SDL_atomic_t* dirty;
+    SDL_atomic_t* next_dirty;
+    unsigned char* wake_pass; // pass at which a capture or a promotion becomes visible, 0 when there's none left
+} generator_t;
+
+// { row step, column step } for every direction a piece moves in
+static const int piece_steps[PAWN + 1][8][2] = {
+    [rook] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}},
+    [knight] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}},
+    [bishop] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}},
+    [queen] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}},
+    [king] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}},
+};
+static const int piece_steps_count[PAWN + 1] = {[rook] = 4, [knight] = 8, [bishop] = 4, [queen] = 8, [king] = 8};
+
+static char is_marked(const SDL_atomic_t* bits, unsigned int index) { return (SDL_AtomicGet((SDL_atomic_t*)&bits[index / 32]) >> (index % 32)) & 1; }
+
+static void mark(SDL_atomic_t* bits, unsigned int index)
+{
+    SDL_atomic_t* word = &bits[index / 32];
+    const int bit = (int)(1u << (index % 32));
+
+    for (ever)
+    {
+        const int old = SDL_AtomicGet(word);
+        if ((old & bit) || SDL_AtomicCAS(word, old, old | bit)) return;
+    }
+}
+
+static void mark_parent(generator_t* generator, const signed char* squares, char is_white_to_move)
+{
+    const unsigned int index = tablebase_index(generator->table, squares, is_white_to_move);
+    if (index < generator->table->positions_count) mark(generator->next_dirty, index);
+}
+
+// takes back every quiet move of the side that just moved, captures and promotions come from other tables
+static void mark_parents(generator_t* generator, const signed char* squares, char is_white_to_move)
+{
+    const char is_white_moved = !is_white_to_move;
+
+    signed char parent[BOARD_SZ];
+    SDL_memcpy(parent, squares, BOARD_SZ);
+
+    for (int from = 0; from != BOARD_SZ; ++from)
+    {
+        const signed char piece = squares[from];
+        if (!piece || (piece > 0) != is_white_moved) continue;
+
+        const piece_type_t type = (piece_type_t)abs(piece);
+        parent[from] = 0;
+
+        if (type == pawn)
+        {
+            // white pawns go up the board, so they come from the row below, and never from the last one
+            const int back = is_white_moved ? CELLS_PER_ROW : -CELLS_PER_ROW;
+            const int start_row = is_white_moved ? CELLS_PER_ROW - 2 : 1;
+            const int to = from + back;
+
+            if (ROW(to) != (is_white_moved ? CELLS_PER_ROW - 1 : 0) && !squares[to])
+            {
+                parent[to] = piece;
+                mark_parent(generator, parent, is_white_moved);
+                parent[to] = 0;
+
+                if (ROW(to + back) == start_row && !squares[to + back])
+                {
+                    parent[to + back] = piece;
+                    mark_parent(generator, parent, is_white_moved);
+                    parent[to + back] = 0;
+                }
+            }
+        } else
+        {
+            const char is_slider = type == rook || type == bishop || type == queen;
+
+            for (int i = 0; i != piece_steps_count[type]; ++i)
+            {
+                int row = ROW(from), column = COLUMN(from);
+
+                for (ever)
+                {
+                    row += piece_steps[type][i][0];
+                    column += piece_steps[type][i][1];
+                    if (row < 0 || row >= CELLS_PER_ROW || column < 0 || column >= CELLS_PER_ROW || squares[row * CELLS_PER_ROW + column]) break;
+
+                    parent[row * CELLS_PER_ROW + column] = piece;
+                    mark_parent(generator, parent, is_white_moved);
+                    parent[row * CELLS_PER_ROW + column] = 0;
+
+                    if (!is_slider) break;
+                }
+            }
+        }
+
+        parent[from] = piece;
+    }
+}
+
+// pass 0 finds illegal positions, mates and stalemates
+static unsigned char get_initial_value(const position_t* position)
+{
+    // the side that just moved can't have left its king in check
+    const int other_side = position->is_white_to_move ? 0 : 1;
+    if (position_is_attacked(position, position->king_index[other_side], position->is_white_to_move)) return TABLEBASE_ILLEGAL;
+
+    move_t moves[MAX_MOVES];
+    if (position_generate_moves(position, moves, FALSE)) return TABLEBASE_UNKNOWN;
+
+    return position_in_check(position) ? TABLEBASE_MATE : TABLEBASE_DRAW;
+}
+
+// pass n: a position is won in n plies if a move leads to a loss in n - 1, lost if every move leads to a win in less than n
+static unsigned char get_value(const generator_t* generator, position_t* position, unsigned char* wake_pass)
+{
+    const tablebase_t* table = generator->table;
+
+    move_t moves[MAX_MOVES];
+    const int count = position_generate_moves(position, moves, FALSE);
+
+    int shortest_loss = -1, longest_win = -1;
+    char is_unresolved = FALSE;
+    int next_exit = 0;
+
+    for (int i = 0; i != count; ++i)
+    {
+        undo_t undo;
+        position_make_move(position, moves[i], &undo);
+
+        // captures and promotions land in another table, already complete. The index ignores en passant, so a double
+        // push that can be taken that way is resolved one ply deeper, the en passant capture among its moves
+        const char is_same_table = !undo.captured && !moves[i].promotion;
+        const char is_enpassant = position->enpassant_index != INVALID_INDEX;
+        unsigned char child_wake_pass = 0;
+        unsigned char value;
+
+        if (is_enpassant) value = get_value(generator, position, &child_wake_pass);
+        else if (is_same_table) value = tablebase_get(table, tablebase_index(table, position->squares, position->is_white_to_move));
+        else value = tablebases_get_value(&generator->tablebases, position);
+
+        position_unmake_move(position, moves[i], &undo);
+
+        const int dtm = value - TABLEBASE_MATE;
+
+        // values found in this pass are not visible yet, child tables have all theirs from the start
+        if (value < TABLEBASE_MATE || dtm >= generator->pass)
+        {
+            // no parent is marked when such a child's own children change, it's looked at again every pass instead
+            if (is_enpassant) next_exit = generator->pass + 1;
+            else if (!is_same_table && value >= TABLEBASE_MATE && (!next_exit || dtm + 1 < next_exit)) next_exit = dtm + 1;
+            is_unresolved = TRUE;
+            continue;
+        }
+
+        if (dtm % 2 == 0)
+        {
+            if (shortest_loss == -1 || dtm < shortest_loss) shortest_loss = dtm;
+        } else
+        {
+            longest_win = SDL_max(longest_win, dtm);
+        }
+    }
+
+    *wake_pass = (unsigned char)next_exit;
+
+    if (shortest_loss != -1) return (unsigned char)(TABLEBASE_MATE + shortest_loss + 1);
+    if (!is_unresolved && longest_win != -1) return (unsigned char)(TABLEBASE_MATE + longest_win + 1);
+
+    return TABLEBASE_UNKNOWN;
+}
+
+static int generator_worker(void* data)
+{
+    generator_t* generator = (generator_t*)data;
+    const tablebase_t* table = generator->table;
+
+    int changed = 0;
+
+    for (ever)
+    {
+        const unsigned int first = (unsigned int)SDL_AtomicAdd(&generator->next_block, 1) * TABLEBASE_BLOCK_SIZE;
+        if (first >= table->positions_count) break;
+
+        const unsigned int last = SDL_min(first + TABLEBASE_BLOCK_SIZE, table->positions_count);
+
+        for (unsigned int index = first; index != last; ++index)
+        {
+            if (table->values[index] != TABLEBASE_UNKNOWN) continue;
+
+            // after the first full pass, a position can only change when a child did
+            if (generator->pass > 1 && !is_marked(generator->dirty, index) && generator->wake_pass[index] != generator->pass) continue;
+
+            signed char squares[BOARD_SZ];
+            char is_white_to_move = FALSE;
+            position_t position;
+
+            if (!tablebase_decode(table, index, squares, &is_white_to_move))
+            {
+                generator->next[index] = TABLEBASE_ILLEGAL;
+                continue;
+            }
+
+            position_set_squares(&position, squares, is_white_to_move);
+
+            const unsigned char value = generator->pass ? get_value(generator, &position, &generator->wake_pass[index]) : get_initial_value(&position);
+            if (value == TABLEBASE_UNKNOWN) continue;
+
+            generator->next[index] = value;
+            changed++;
+
+            if (generator->pass) mark_parents(generator, squares, is_white_to_move);
+        }
+    }
+
+    SDL_AtomicAdd(&generator->changed, changed);
+    return 0;
+}
+
+static void run_pass(generator_t* generator)
+{
+    SDL_memcpy(generator->next, generator->table->values, generator->table->positions_count);
+    SDL_memset(generator->next_dirty, 0, (generator->table->positions_count + 31) / 32 * sizeof(SDL_atomic_t));
+    SDL_AtomicSet(&generator->next_block, 0);
+    SDL_AtomicSet(&generator->changed, 0);
+
+    SDL_Thread* threads[MAX_BUFFER_SIZE];
+    const int threads_count = SDL_min(generator->threads, MAX_BUFFER_SIZE);
+
+    for (int i = 0; i != threads_count; ++i) threads[i] = SDL_CreateThread(generator_worker, "tablebase", generator);
+    for (int i = 0; i != threads_count; ++i) SDL_WaitThread(threads[i], NULL);
+
+    // the values found in this pass become visible to the next one
+    unsigned char* values = generator->table->values;
+    generator->table->values = generator->next;
+    generator->next = values;
+
+    SDL_atomic_t* dirty = generator->dirty;
+    generator->dirty = generator->next_dirty;
+    generator->next_dirty = dirty;
+}
+
+static void free_pass_buffers(generator_t* generator)
+{
+    SDL_free(generator->next);
+    SDL_free(generator->wake_pass);
+    SDL_free(generator->dirty);
+    SDL_free(generator->next_dirty);
+    generator->next = generator->wake_pass = NULL;
+    generator->dirty = generator->next_dirty = NULL;
+}
+
+// puts the material on an empty board to let tablebase_get_signature order it
+static void get_canonical_signature(const signed char* pieces, int count, char* signature)
+{
+    signed char squares[BOARD_SZ] = {0};
+    for (int i = 0; i != count; ++i) squares[CELLS_PER_ROW + i] = pieces[i];
+
+    tablebase_get_signature(squares, signature);
+}
+
+static char generate(generator_t* generator, const char* requested)
+{
+    tablebase_t parsed;
+    if (!tablebase_init(&parsed, requested))
+    {
+        fprintf(stderr, "Invalid tablebase material: %s\n", requested);
+        return FALSE;
+    }
+
+    char signature[TABLEBASE_SIGNATURE_SIZE];
+    get_canonical_signature(parsed.pieces, parsed.pieces_count, signature);
+    if (tablebases_find(&generator->tablebases, signature)) return TRUE;
+    if (generator->tablebases.count == MAX_TABLEBASES) return FALSE;
+
+    // every table a capture or a promotion leads to must be finished first
+    tablebase_t material;
+    tablebase_init(&material, signature);
+
+    int children_max_dtm = 0;
+    for (int i = 2; i != material.pieces_count; ++i)
+    {
+        static const piece_type_t promotions[] = {none, queen, rook, bishop, knight};
+
+        for (int j = 0; j != (int)SDL_arraysize(promotions); ++j)
+        {
+            if (promotions[j] != none && material.pieces[i] != pawn && material.pieces[i] != -pawn) break;
+
+            signed char pieces[TABLEBASE_MAX_PIECES];
+            int count = 0;
+            for (int k = 0; k != material.pieces_count; ++k)
+            {
+                if (k != i) pieces[count++] = material.pieces[k];
+                else if (promotions[j] != none) pieces[count++] = (signed char)(material.pieces[k] > 0 ? promotions[j] : -(int)promotions[j]);
+            }
+
+            char child_signature[TABLEBASE_SIGNATURE_SIZE];
+            get_canonical_signature(pieces, count, child_signature);
+            if (count == 2) continue;
+
+            if (!generate(generator, child_signature)) return FALSE;
+            children_max_dtm = SDL_max(children_max_dtm, tablebases_find(&generator->tablebases, child_signature)->max_dtm);
+        }
+    }
+
+    if (generator->tablebases.count == MAX_TABLEBASES) return FALSE;
+
+    tablebase_t* table = &generator->tablebases.tables[generator->tablebases.count];
+    *table = material;
+
+    const size_t dirty_words = (table->positions_count + 31) / 32;
+
+    table->values = (unsigned char*)SDL_calloc(table->positions_count, 1);
+    generator->next = (unsigned char*)SDL_malloc(table->positions_count);
+    generator->wake_pass = (unsigned char*)SDL_calloc(table->positions_count, 1);
+    generator->dirty = (SDL_atomic_t*)SDL_calloc(dirty_words, sizeof(SDL_atomic_t));
+    generator->next_dirty = (SDL_atomic_t*)SDL_calloc(dirty_words, sizeof(SDL_atomic_t));
+
+    if (!table->values || !generator->next || !generator->wake_pass || !generator->dirty || !generator->next_dirty)
+    {
+        SDL_Log("Couldn't allocate %u positions for %s", table->positions_count, signature);
+        SDL_free(table->values);
+        free_pass_buffers(generator);
+        return FALSE;
+    }
+
+    const Uint64 start_counter = SDL_GetPerformanceCounter();
+
+    generator->table = table;
+    generator->children_max_dtm = children_max_dtm;
+
+    // retrograde passes: each one resolves the positions one ply further from mate, until nothing changes anymore
+    for (generator->pass = 0; generator->pass <= TABLEBASE_MAX_DTM; ++generator->pass)
+    {
+        run_pass(generator);
+        if (!SDL_AtomicGet(&generator->changed) && generator->pass > children_max_dtm) break;
+    }
+
+    int wins = 0, losses = 0, draws = 0;
+    for (unsigned int i = 0; i != table->positions_count; ++i)
+    {
+        if (table->values[i] == TABLEBASE_UNKNOWN) table->values[i] = TABLEBASE_DRAW;
+
+        if (table->values[i] == TABLEBASE_DRAW) draws++;
+        else if (table->values[i] >= TABLEBASE_MATE)
+        {
+            const int dtm = table->values[i] - TABLEBASE_MATE;
+            table->max_dtm = SDL_max(table->max_dtm, dtm);
+            if (dtm % 2) wins++;
+            else losses++;
+        }
+    }
+
+    free_pass_buffers(generator);
+
+    char path[MAX_BUFFER_SIZE * 4];
+    SDL_snprintf(path, sizeof(path), "%s/%s%s", generator->directory, signature, TABLEBASE_EXTENSION);
+
+    const double seconds = (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency();
+    printf("tablebase: %s, %u positions, %i wins, %i losses, %i draws, longest mate %i plies, %i passes in %.2fs -> %s\n", signature, table->positions_count, wins, losses, draws, table->max_dtm,
+           generator->pass, seconds, path);
+
+    generator->tablebases.count++;
+
+    return tablebase_write(table, path);
+}
+
+int tablebase_generator_main(int argc, char** argv)
+{
+    generator_t generator;
+    SDL_memset(&generator, 0, sizeof(generator_t));
+    generator.threads = SDL_GetCPUCount();
+
+    const char* requested[MAX_TABLEBASES];
+    int requested_count = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--generate-tablebases") && value) generator.directory = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--threads") && value) generator.threads = SDL_atoi(argv[++i]);
+        else if (argv[i][0] != '-' && requested_count != MAX_TABLEBASES) requested[requested_count++] = argv[i];
+        else
+        {
+            fprintf(stderr, "Unknown tablebase generator option: %s\n", argv[i]);
+            requested_count = -1;
+            break;
+        }
+    }
+
+    if (!generator.directory || requested_count < 0)
+    {
+        fprintf(stderr, "usage: chess --generate-tablebases <existing directory> [KQK KRK KBNK ... | all] [--threads n]\n");
+        return 1;
+    }
+
+    generator.threads = SDL_max(1, generator.threads);
+    position_init();
+
+    // what was generated before is mapped and reused as children
+    tablebases_open(&generator.tablebases, generator.directory);
+
+    static const char* all[] = {"KQK", "KRK", "KBK", "KNK", "KPK", "KQKQ", "KQKR", "KQKB", "KQKN", "KQKP", "KRKR", "KRKB", "KRKN", "KRKP", "KBKB", "KBKN", "KBKP", "KNKN", "KNKP", "KPKP",
+                                "KQQK", "KQRK", "KQBK", "KQNK", "KQPK", "KRRK", "KRBK", "KRNK", "KRPK", "KBBK", "KBNK", "KBPK", "KNNK", "KNPK", "KPPK"};
+
+    char is_generated = TRUE;
+
+    if (!requested_count || (requested_count == 1 && !SDL_strcmp(requested[0], "all")))
+    {
+        for (int i = 0; i != (int)SDL_arraysize(all) && is_generated; ++i) is_generated = generate(&generator, all[i]);
+    } else
+    {
+        for (int i = 0; i != requested_count && is_generated; ++i) is_generated = generate(&generator, requested[i]);
+    }
+
+    // generated tables own their values, the ones found in the directory are mapped
+    for (int i = 0; i != generator.tablebases.count; ++i) SDL_free(generator.tablebases.tables[i].values);
+    tablebases_close(&generator.tablebases);
+
+    return is_generated ? 0 : 1;
+}
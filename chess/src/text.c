@@ -1,3 +1,4 @@
+#include <perf_hud.h>
 #include <private.h>
 #include <text.h>
 
@@ -11,16 +12,16 @@ render_text_t *text_new(const char *font, uint16_t font_size, const char *text,
 {
     render_text_t *render_text = (render_text_t *)calloc(1, sizeof(render_text_t));
     CHECK(render_text, NULL, "Could not allocate enough bytes for struct text");
+    perf_count(perf_allocations);
 
-    render_text->font = TTF_OpenFont(font, font_size);
+    // fonts are shared between texts, the glyphs are rasterized only the first time a size is requested
+    render_text->font = font_get(font, font_size);
+    CHECK(render_text->font, NULL, "Could not load font for text");
 
     SDL_Color text_color = {color.r, color.g, color.b, color.a};
-    render_text->text_surface = TTF_RenderText_Blended(render_text->font, text, text_color);
-    render_text->copy_texture = SDL_CreateTextureFromSurface((SDL_Renderer *)renderer->sdl_renderer, render_text->text_surface);
-
     render_text->color = text_color;
 
-    SDL_QueryTexture(render_text->copy_texture, NULL, NULL, &render_text->width, &render_text->height);
+    text_update(render_text, text);
 
     return render_text;
 }
@@ -29,29 +30,67 @@ void text_draw(render_text_t *render_text, int screen_x, int screen_y)
 {
     SDL_assert_always(render_text);
 
-    SDL_Rect dstrect = {screen_x, screen_y, render_text->width, render_text->height};
-    SDL_RenderCopy((SDL_Renderer *)renderer->sdl_renderer, render_text->copy_texture, NULL, &dstrect);
-}
+    font_t *font = render_text->font;
 
-void text_update(render_text_t *render_text, char *new_text)
-{
-    SDL_FreeSurface(render_text->text_surface);
-    SDL_DestroyTexture(render_text->copy_texture);
+    SDL_Vertex vertices[MAX_BUFFER_SIZE * 4];
+    int indices[MAX_BUFFER_SIZE * 6];
+    int quads = 0;
 
-    render_text->text_surface = NULL;
-    render_text->copy_texture = NULL;
+    float atlas_w = 0.0f, atlas_h = 0.0f;
+    {
+        int w, h;
+        SDL_QueryTexture(font->atlas, NULL, NULL, &w, &h);
+        atlas_w = (float)w;
+        atlas_h = (float)h;
+    }
 
-    render_text->text_surface = TTF_RenderText_Blended(render_text->font, new_text, render_text->color);
-    render_text->copy_texture = SDL_CreateTextureFromSurface((SDL_Renderer *)renderer->sdl_renderer, render_text->text_surface);
+    // one quad per glyph, the whole string goes out with a single geometry call
+    int pen_x = screen_x;
+    for (const char *c = render_text->text; *c; ++c)
+    {
+        if (*c < FONT_FIRST_GLYPH || *c > FONT_LAST_GLYPH) continue;
 
-    // also update width and height that might be changed if the new text is wider or smaller
-    SDL_QueryTexture(render_text->copy_texture, NULL, NULL, &render_text->width, &render_text->height);
+        const glyph_t *glyph = &font->glyphs[*c - FONT_FIRST_GLYPH];
+        const SDL_Rect *src = &glyph->atlas_rect;
+
+        const float x0 = (float)pen_x, y0 = (float)screen_y;
+        const float x1 = x0 + src->w, y1 = y0 + src->h;
+        const float u0 = src->x / atlas_w, v0 = src->y / atlas_h;
+        const float u1 = (src->x + src->w) / atlas_w, v1 = (src->y + src->h) / atlas_h;
+
+        SDL_Vertex *v = &vertices[quads * 4];
+        v[0] = (SDL_Vertex){{x0, y0}, render_text->color, {u0, v0}};
+        v[1] = (SDL_Vertex){{x1, y0}, render_text->color, {u1, v0}};
+        v[2] = (SDL_Vertex){{x1, y1}, render_text->color, {u1, v1}};
+        v[3] = (SDL_Vertex){{x0, y1}, render_text->color, {u0, v1}};
+
+        int *i = &indices[quads * 6];
+        i[0] = quads * 4 + 0;
+        i[1] = quads * 4 + 1;
+        i[2] = quads * 4 + 2;
+        i[3] = quads * 4 + 0;
+        i[4] = quads * 4 + 2;
+        i[5] = quads * 4 + 3;
+
+        pen_x += glyph->advance;
+        quads++;
+    }
+
+    if (quads == 0) return;
+
+    SDL_RenderGeometry((SDL_Renderer *)renderer->sdl_renderer, font->atlas, vertices, quads * 4, indices, quads * 6);
+    perf_count(perf_draw_calls);
 }
 
-void text_destroy(render_text_t *render_text)
+void text_update(render_text_t *render_text, const char *new_text)
 {
-    SDL_FreeSurface(render_text->text_surface);
-    SDL_DestroyTexture(render_text->copy_texture);
-    TTF_CloseFont(render_text->font);
-    free(render_text);
-}
\ No newline at end of file
+    // no surface or texture is created here, the text is only laid out again
+    SDL_strlcpy(render_text->text, new_text, MAX_BUFFER_SIZE);
+    perf_count(perf_text_updates);
+
+    // also update width and height that might be changed if the new text is wider or smaller
+    render_text->width = font_measure(render_text->font, render_text->text);
+    render_text->height = render_text->font->line_height;
+}
+
+void text_destroy(render_text_t *render_text) { free(render_text); }
@@ -1,3 +1,5 @@
+#include <bundle.h>
+#include <perf_hud.h>
 #include <private.h>
 #include <texture.h>
 
@@ -23,6 +25,43 @@ void _render(struct texture *texture, uint8_t alpha, SDL_Rect *clip)
     if (alpha > 0) SDL_SetTextureAlphaMod(texture->texture, alpha);
 
     SDL_RenderCopy(native_renderer, texture->texture, NULL, &texture->quad);
+    perf_count(perf_draw_calls);
+}
+
+void texture_render_instances(texture_t *texture, const SDL_Point *positions, int count, uint8_t alpha)
+{
+    SDL_Vertex vertices[MAX_TEXTURE_INSTANCES * 4];
+    int indices[MAX_TEXTURE_INSTANCES * 6];
+
+    if (!texture || count <= 0) return;
+
+    count = SDL_min(count, MAX_TEXTURE_INSTANCES);
+
+    // every instance is a quad of the texture size, all of them go out with a single geometry call
+    const SDL_Color tint = {UCHAR_MAX, UCHAR_MAX, UCHAR_MAX, alpha};
+    const float w = (float)texture->quad.w, h = (float)texture->quad.h;
+
+    for (int i = 0; i != count; ++i)
+    {
+        const float x = (float)positions[i].x, y = (float)positions[i].y;
+
+        SDL_Vertex *v = &vertices[i * 4];
+        v[0] = (SDL_Vertex){{x, y}, tint, {0.0f, 0.0f}};
+        v[1] = (SDL_Vertex){{x + w, y}, tint, {1.0f, 0.0f}};
+        v[2] = (SDL_Vertex){{x + w, y + h}, tint, {1.0f, 1.0f}};
+        v[3] = (SDL_Vertex){{x, y + h}, tint, {0.0f, 1.0f}};
+
+        int *index = &indices[i * 6];
+        index[0] = i * 4 + 0;
+        index[1] = i * 4 + 1;
+        index[2] = i * 4 + 2;
+        index[3] = i * 4 + 0;
+        index[4] = i * 4 + 2;
+        index[5] = i * 4 + 3;
+    }
+
+    SDL_RenderGeometry((SDL_Renderer *)renderer->sdl_renderer, texture->texture, vertices, count * 4, indices, count * 6);
+    perf_count(perf_draw_calls);
 }
 
 void _set_position(struct texture *texture, int x, int y)
@@ -41,6 +80,7 @@ texture_t *texture_create_raw(uint32_t width, uint32_t height, color_t color)
 {
     texture_t *texture = (texture_t *)calloc(1, sizeof(texture_t));
     CHECK(texture, NULL, "Couldn't allocate memory for struct texture");
+    perf_count(perf_allocations);
     texture->render = _render;
     texture->set_position = _set_position;
     texture->set_size = _set_size;
@@ -50,6 +90,7 @@ texture_t *texture_create_raw(uint32_t width, uint32_t height, color_t color)
     if (!texture->texture)
     {
         SDL_Log("could not create texture: %s", SDL_GetError());
+        free(texture);
         return NULL;
     }
 
@@ -59,6 +100,8 @@ texture_t *texture_create_raw(uint32_t width, uint32_t height, color_t color)
     if (SDL_LockTexture(texture->texture, NULL, (void **)&pixels, &pitch))
     {
         SDL_Log("unable to lock texture: %s", SDL_GetError());
+        SDL_DestroyTexture(texture->texture);
+        free(texture);
         return NULL;
     }
 
@@ -74,6 +117,45 @@ texture_t *texture_create_raw(uint32_t width, uint32_t height, color_t color)
 
     SDL_SetTextureBlendMode(texture->texture, SDL_BLENDMODE_BLEND);
     SDL_UnlockTexture(texture->texture);
+    perf_count(perf_texture_uploads);
+
+    texture->width = width;
+    texture->height = height;
+    texture->quad.w = width;
+    texture->quad.h = height;
+
+    return texture;
+}
+
+texture_t *texture_create_static(uint32_t width, uint32_t height, const void *rgba_pixels)
+{
+    texture_t *texture = (texture_t *)calloc(1, sizeof(texture_t));
+    CHECK(texture, NULL, "Couldn't allocate memory for struct texture");
+    perf_count(perf_allocations);
+    texture->render = _render;
+    texture->set_position = _set_position;
+    texture->set_size = _set_size;
+
+    // static textures are uploaded once and never locked again
+    texture->texture = SDL_CreateTexture((SDL_Renderer *)renderer->sdl_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+
+    if (!texture->texture)
+    {
+        SDL_Log("could not create texture: %s", SDL_GetError());
+        free(texture);
+        return NULL;
+    }
+
+    if (SDL_UpdateTexture(texture->texture, NULL, rgba_pixels, width * sizeof(color_t)))
+    {
+        SDL_Log("unable to upload texture: %s", SDL_GetError());
+        SDL_DestroyTexture(texture->texture);
+        free(texture);
+        return NULL;
+    }
+    perf_count(perf_texture_uploads);
+
+    SDL_SetTextureBlendMode(texture->texture, SDL_BLENDMODE_BLEND);
 
     texture->width = width;
     texture->height = height;
@@ -87,28 +169,50 @@ texture_t *texture_load_from_file(const char *path, const char use_blending)
 {
     texture_t *texture = (texture_t *)calloc(1, sizeof(texture_t));
     CHECK(texture, NULL, "Couldn't allocate memory for struct texture");
+    perf_count(perf_allocations);
     texture->render = _render;
     texture->set_position = _set_position;
     texture->set_size = _set_size;
 
     int width, height, color_channel;
-    unsigned char *data = stbi_load(path, &width, &height, &color_channel, STBI_rgb_alpha);
+    const unsigned char *pixels = NULL;
+    unsigned char *decoded = NULL;
 
-    texture->texture = SDL_CreateTexture((SDL_Renderer *)renderer->sdl_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    // pre-decoded pixels are uploaded straight from the mapped bundle, the png is decoded only as a fallback
+    const bundle_entry_t *entry = bundle_find(path, bundle_texture);
+    if (entry)
+    {
+        width = (int)entry->width;
+        height = (int)entry->height;
+        pixels = (const unsigned char *)bundle_data(entry);
+    } else
+    {
+        decoded = stbi_load(path, &width, &height, &color_channel, STBI_rgb_alpha);
+        pixels = decoded;
+    }
 
-    int pitch = 0;
-    unsigned char *pixel = NULL;
+    if (!pixels)
+    {
+        SDL_Log("Unable to load texture %s", path);
+        free(texture);
+        return NULL;
+    }
+
+    texture->texture = SDL_CreateTexture((SDL_Renderer *)renderer->sdl_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
 
-    if (SDL_LockTexture(texture->texture, NULL, (void **)&pixel, &pitch))
+    if (!texture->texture || SDL_UpdateTexture(texture->texture, NULL, pixels, width * STBI_rgb_alpha))
     {
-        SDL_Log("Unable to lock texture: %s", SDL_GetError());
+        SDL_Log("Unable to upload texture: %s", SDL_GetError());
+        if (texture->texture) SDL_DestroyTexture(texture->texture);
+        stbi_image_free(decoded);
+        free(texture);
         return NULL;
     }
 
-    memset(pixel, 0, width * height * color_channel);
-    memcpy(pixel, data, width * height * color_channel);
+    stbi_image_free(decoded);
+    perf_count(perf_texture_uploads);
+
     if (use_blending) SDL_SetTextureBlendMode(texture->texture, SDL_BLENDMODE_BLEND);
-    SDL_UnlockTexture(texture->texture);
 
     texture->width = width;
     texture->height = height;
@@ -123,7 +227,6 @@ void texture_destroy(texture_t *texture)
     if (texture)
     {
         SDL_DestroyTexture(texture->texture);
-        SDL_free(texture->texture);
         free(texture);
     }
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include <time_manager.h>
+
+void time_manager_start(time_manager_t* manager, const time_control_t* control, const position_t* position)
+{
+    SDL_memset(manager, 0, sizeof(time_manager_t));
+    manager->start = SDL_GetPerformanceCounter();
+
+    const double remaining_ms = SDL_max((double)control->remaining_ms - TIME_MANAGER_OVERHEAD_MS, 1.0);
+    const int moves_to_go = (control->moves_to_go > 0) ? SDL_min(control->moves_to_go, TIME_MANAGER_MOVES_TO_GO) : TIME_MANAGER_MOVES_TO_GO;
+
+    // an even share of what's left, most of the increment comes back on the next move anyway
+    manager->optimal_ms = SDL_min(remaining_ms / moves_to_go + control->increment_ms * 0.75, remaining_ms * 0.5);
+
+    // a hard position can take a few normal moves, the last move before the control can take almost everything
+    manager->maximum_ms = SDL_min(manager->optimal_ms * 3.0, remaining_ms * (moves_to_go == 1 ? 0.9 : 0.2));
+    manager->maximum_ms = SDL_max(manager->maximum_ms, manager->optimal_ms);
+
+    move_t moves[MAX_MOVES];
+    manager->is_forced = position_generate_moves(position, moves, FALSE) == 1;
+}
+
+char time_manager_should_continue(time_manager_t* manager, const search_result_t* result)
+{
+    if (manager->is_forced) return FALSE;
+
+    // the root is searched with a full window, a score drop between iterations is what a fail low would tell
+    const char is_new_best = !move_equals(result->best_move, manager->best_move);
+    const char is_fail_low = result->depth > 1 && !IS_MATE_SCORE(result->score) && result->score <= manager->best_score - TIME_MANAGER_FAIL_LOW_CP;
+
+    manager->instability = manager->instability * 0.5 + ((is_new_best && result->depth > 1) ? 1.0 : 0.0);
+    manager->stable_iterations = is_new_best ? 0 : manager->stable_iterations + 1;
+    manager->best_move = result->best_move;
+    manager->best_score = result->score;
+
+    double target_ms = manager->optimal_ms * (1.0 + manager->instability);
+    if (is_fail_low) target_ms *= 1.5;
+    else if (manager->stable_iterations >= TIME_MANAGER_EASY_ITERATIONS) target_ms *= 0.5;
+    target_ms = SDL_min(target_ms, manager->maximum_ms);
+
+    // every iteration takes a few times longer than the previous one, starting one past half the target would overshoot
+    return time_manager_elapsed_ms(manager) < target_ms * 0.5;
+}
+
+double time_manager_elapsed_ms(const time_manager_t* manager) { return (double)(SDL_GetPerformanceCounter() - manager->start) * 1000.0 / SDL_GetPerformanceFrequency(); }
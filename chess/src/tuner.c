@@ -0,0 +1,369 @@
+#include <tuner.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+
+// eval_params_t seen as an array of ints, see eval.h
+#define MATERIAL_INDEX ((int)(offsetof(eval_params_t, material) / sizeof(int)))
+#define PIECE_SQUARE_INDEX ((int)(offsetof(eval_params_t, piece_square) / sizeof(int)))
+#define BISHOP_PAIR_INDEX ((int)(offsetof(eval_params_t, bishop_pair) / sizeof(int)))
+#define TEMPO_INDEX ((int)(offsetof(eval_params_t, tempo) / sizeof(int)))
+
+#define K_MIN 0.1
+#define K_MAX 3.0
+#define K_STEPS 40
+
+#define ADAM_BETA1 0.9
+#define ADAM_BETA2 0.999
+#define ADAM_EPSILON 1e-8
+
+typedef struct tuner_job {
+    const struct tuner* tuner;
+    int first, last; // slice of the entries
+    double k;
+    char wants_gradient;
+    double error;
+    double gradient[EVAL_PARAMS_COUNT];
+} tuner_job_t;
+
+typedef struct tuner {
+    tuner_options_t options;
+    tuner_entry_t* entries;
+    int count;
+    float weights[EVAL_PARAMS_COUNT];
+
+    int threads_count;
+    SDL_Thread** threads;
+    tuner_job_t* jobs;
+} tuner_t;
+
+#pragma region Parsing
+static char parse_result(const char* token, float* result)
+{
+    if (!SDL_strcmp(token, "1-0")) *result = 1.0f;
+    else if (!SDL_strcmp(token, "0-1")) *result = 0.0f;
+    else if (!SDL_strcmp(token, "1/2-1/2")) *result = 0.5f;
+    else if (SDL_strchr(token, '.')) *result = (float)SDL_atof(token); // a plain integer would be the fullmove number
+    else return FALSE;
+
+    return *result >= 0.0f && *result <= 1.0f;
+}
+
+char tuner_parse_entry(const char* line, tuner_entry_t* entry)
+{
+    char fen[MAX_FEN_SIZE * 2];
+    SDL_strlcpy(fen, line, sizeof(fen));
+
+    // the result is the last token, whatever wraps it
+    int end = (int)SDL_strlen(fen);
+    while (end && SDL_strchr(" \t\r\n;\"]", fen[end - 1])) end--;
+    fen[end] = '\0';
+
+    int start = end;
+    while (start && !SDL_strchr(" \t;\"[,", fen[start - 1])) start--;
+
+    float result = 0.0f;
+    if (!start || !parse_result(fen + start, &result)) return FALSE;
+    fen[start] = '\0';
+
+    position_t position;
+    if (!position_from_fen(&position, fen) || position_in_check(&position)) return FALSE;
+
+    SDL_memset(entry, 0, sizeof(tuner_entry_t));
+    entry->result = result;
+    entry->tempo = position.is_white_to_move ? 1 : -1;
+
+    int bishops[MAX_PLAYERS] = {0};
+    for (int i = 0; i != BOARD_SZ; ++i)
+    {
+        char is_white = FALSE;
+        const piece_type_t type = position_get_piece(&position, i, &is_white);
+        if (type == none) continue;
+        if (entry->count == TUNER_MAX_PIECES) return FALSE;
+
+        // black reads the table upside down, like evaluate does
+        const int square = is_white ? i : i ^ (BOARD_SZ - CELLS_PER_ROW);
+        entry->pieces[entry->count++] = (unsigned short)(square | type << 6 | (is_white ? 1 : 0) << 9);
+
+        if (type == bishop) bishops[is_white ? 1 : 0]++;
+    }
+
+    entry->bishop_pair = (signed char)((bishops[1] >= 2) - (bishops[0] >= 2));
+
+    return TRUE;
+}
+
+static char load_entries(tuner_t* tuner, const char* path)
+{
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(path, &size);
+    CHECK(text, FALSE, "Couldn't read tuning positions");
+
+    int lines = 1;
+    for (size_t i = 0; i != size; ++i) lines += (text[i] == '\n');
+
+    tuner->entries = (tuner_entry_t*)malloc(sizeof(tuner_entry_t) * lines);
+    if (!tuner->entries)
+    {
+        SDL_Log("Couldn't allocate memory for %i tuning positions", lines);
+        SDL_free(text);
+        return FALSE;
+    }
+
+    int skipped = 0;
+    for (char* line = text; line && *line;)
+    {
+        char* next = SDL_strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        if (*line && *line != '\r' && *line != '#')
+        {
+            if (tuner_parse_entry(line, &tuner->entries[tuner->count])) tuner->count++;
+            else skipped++;
+        }
+
+        line = next;
+    }
+
+    SDL_free(text);
+
+    printf("tune: %i positions, %i skipped (in check or unreadable), %.1f MB\n", tuner->count, skipped, sizeof(tuner_entry_t) * (double)tuner->count / (1024.0 * 1024.0));
+    return tuner->count != 0;
+}
+#pragma endregion
+
+#pragma region Error
+// the same sum as evaluate, from white's point of view, with the weights as floats
+static float evaluate_entry(const tuner_entry_t* entry, const float* weights)
+{
+    float score = entry->bishop_pair * weights[BISHOP_PAIR_INDEX] + entry->tempo * weights[TEMPO_INDEX];
+
+    for (int i = 0; i != entry->count; ++i)
+    {
+        const int piece = entry->pieces[i];
+        const int type = (piece >> 6) & 7;
+        const float sign = (piece >> 9) ? 1.0f : -1.0f;
+
+        score += sign * (weights[MATERIAL_INDEX + type] + weights[PIECE_SQUARE_INDEX + type * BOARD_SZ + (piece & (BOARD_SZ - 1))]);
+    }
+
+    return score;
+}
+
+static int tuner_worker(void* data)
+{
+    tuner_job_t* job = (tuner_job_t*)data;
+    const tuner_t* tuner = job->tuner;
+    const float* weights = tuner->weights;
+
+    // the sigmoid's slope per centipawn is s (1 - s) k ln(10) / 400
+    const double exponent = -job->k * SDL_log(10.0) / 400.0;
+
+    for (int i = job->first; i != job->last; ++i)
+    {
+        const tuner_entry_t* entry = &tuner->entries[i];
+        const double sigmoid = 1.0 / (1.0 + SDL_exp(exponent * evaluate_entry(entry, weights)));
+        const double error = entry->result - sigmoid;
+        job->error += error * error;
+
+        if (!job->wants_gradient) continue;
+
+        // every weight the position reads moves the error by the same slope, with the piece's sign
+        const double slope = 2.0 * error * sigmoid * (1.0 - sigmoid) * exponent;
+        job->gradient[BISHOP_PAIR_INDEX] += slope * entry->bishop_pair;
+        job->gradient[TEMPO_INDEX] += slope * entry->tempo;
+
+        for (int j = 0; j != entry->count; ++j)
+        {
+            const int piece = entry->pieces[j];
+            const int type = (piece >> 6) & 7;
+            const double signed_slope = (piece >> 9) ? slope : -slope;
+
+            job->gradient[MATERIAL_INDEX + type] += signed_slope;
+            job->gradient[PIECE_SQUARE_INDEX + type * BOARD_SZ + (piece & (BOARD_SZ - 1))] += signed_slope;
+        }
+    }
+
+    return 0;
+}
+
+// mean squared error over all entries, one contiguous slice per thread, the gradients are summed afterwards
+static double compute_error(tuner_t* tuner, double k, double* gradient)
+{
+    for (int i = 0; i != tuner->threads_count; ++i)
+    {
+        tuner_job_t* job = &tuner->jobs[i];
+        SDL_memset(job, 0, sizeof(tuner_job_t));
+        job->tuner = tuner;
+        job->first = (int)((long long)tuner->count * i / tuner->threads_count);
+        job->last = (int)((long long)tuner->count * (i + 1) / tuner->threads_count);
+        job->k = k;
+        job->wants_gradient = gradient != NULL;
+
+        tuner->threads[i] = SDL_CreateThread(tuner_worker, "tuner", job);
+        if (!tuner->threads[i]) tuner_worker(job);
+    }
+
+    double error = 0.0;
+    if (gradient) SDL_memset(gradient, 0, sizeof(double) * EVAL_PARAMS_COUNT);
+
+    for (int i = 0; i != tuner->threads_count; ++i)
+    {
+        if (tuner->threads[i]) SDL_WaitThread(tuner->threads[i], NULL);
+
+        error += tuner->jobs[i].error;
+        for (int p = 0; gradient && p != EVAL_PARAMS_COUNT; ++p) gradient[p] += tuner->jobs[i].gradient[p];
+    }
+
+    for (int p = 0; gradient && p != EVAL_PARAMS_COUNT; ++p) gradient[p] /= tuner->count;
+
+    return error / tuner->count;
+}
+
+// the scaling constant that makes the starting weights predict the results best, found by golden section
+static double fit_k(tuner_t* tuner)
+{
+    const double ratio = (SDL_sqrt(5.0) - 1.0) / 2.0;
+    double low = K_MIN, high = K_MAX;
+
+    double a = high - ratio * (high - low), b = low + ratio * (high - low);
+    double error_a = compute_error(tuner, a, NULL), error_b = compute_error(tuner, b, NULL);
+
+    for (int i = 0; i != K_STEPS; ++i)
+    {
+        if (error_a < error_b)
+        {
+            high = b;
+            b = a;
+            error_b = error_a;
+            a = high - ratio * (high - low);
+            error_a = compute_error(tuner, a, NULL);
+        } else
+        {
+            low = a;
+            a = b;
+            error_a = error_b;
+            b = low + ratio * (high - low);
+            error_b = compute_error(tuner, b, NULL);
+        }
+    }
+
+    return (low + high) / 2.0;
+}
+
+// adam: each weight gets its own step size, the tables' rare squares move as fast as the material
+static void tune(tuner_t* tuner, double k)
+{
+    static double gradient[EVAL_PARAMS_COUNT], first_moment[EVAL_PARAMS_COUNT], second_moment[EVAL_PARAMS_COUNT];
+    SDL_memset(first_moment, 0, sizeof(first_moment));
+    SDL_memset(second_moment, 0, sizeof(second_moment));
+
+    for (int iteration = 1; iteration <= tuner->options.iterations; ++iteration)
+    {
+        const double error = compute_error(tuner, k, gradient);
+
+        const double correction1 = 1.0 - SDL_pow(ADAM_BETA1, iteration);
+        const double correction2 = 1.0 - SDL_pow(ADAM_BETA2, iteration);
+
+        for (int p = 0; p != EVAL_PARAMS_COUNT; ++p)
+        {
+            first_moment[p] = ADAM_BETA1 * first_moment[p] + (1.0 - ADAM_BETA1) * gradient[p];
+            second_moment[p] = ADAM_BETA2 * second_moment[p] + (1.0 - ADAM_BETA2) * gradient[p] * gradient[p];
+
+            tuner->weights[p] -= (float)(tuner->options.rate * (first_moment[p] / correction1) / (SDL_sqrt(second_moment[p] / correction2) + ADAM_EPSILON));
+        }
+
+        if (iteration == 1 || iteration % TUNER_REPORT_EVERY == 0) printf("tune: iteration %5i error %.6f\n", iteration, error);
+    }
+}
+#pragma endregion
+
+int tuner_main(int argc, char** argv)
+{
+    tuner_t tuner;
+    SDL_memset(&tuner, 0, sizeof(tuner_t));
+    tuner.options.output_path = TUNER_DEFAULT_OUTPUT;
+    tuner.options.iterations = TUNER_DEFAULT_ITERATIONS;
+    tuner.options.rate = TUNER_DEFAULT_RATE;
+    tuner.options.threads = SDL_GetCPUCount();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!SDL_strcmp(argv[i], "--tune") && value) tuner.options.path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--eval") && value) tuner.options.eval_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--output") && value) tuner.options.output_path = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--iterations") && value) tuner.options.iterations = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--rate") && value) tuner.options.rate = SDL_atof(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--threads") && value) tuner.options.threads = SDL_atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Unknown tune option: %s\n", argv[i]);
+            tuner.options.path = NULL;
+            break;
+        }
+    }
+
+    if (!tuner.options.path)
+    {
+        fprintf(stderr, "usage: chess --tune <positions.txt> [--eval file] [--output file] [--iterations n] [--rate r] [--threads n]\n");
+        return 1;
+    }
+
+    position_init();
+
+    eval_params_t params = default_eval_params;
+    if (tuner.options.eval_path && !eval_params_load(&params, tuner.options.eval_path)) return 1;
+
+    const int* values = (const int*)&params;
+    for (int p = 0; p != EVAL_PARAMS_COUNT; ++p) tuner.weights[p] = (float)values[p];
+
+    const Uint64 start_counter = SDL_GetPerformanceCounter();
+
+    if (!load_entries(&tuner, tuner.options.path))
+    {
+        free(tuner.entries);
+        return 1;
+    }
+
+    tuner.threads_count = SDL_max(1, SDL_min(tuner.options.threads, tuner.count));
+    tuner.threads = (SDL_Thread**)calloc(tuner.threads_count, sizeof(SDL_Thread*));
+    tuner.jobs = (tuner_job_t*)calloc(tuner.threads_count, sizeof(tuner_job_t));
+
+    if (!tuner.threads || !tuner.jobs)
+    {
+        SDL_Log("Couldn't allocate tuner workers");
+        free(tuner.threads);
+        free(tuner.jobs);
+        free(tuner.entries);
+        return 1;
+    }
+
+    const double k = fit_k(&tuner);
+    const double start_error = compute_error(&tuner, k, NULL);
+    printf("tune: k %.4f, error %.6f, %i threads\n", k, start_error, tuner.threads_count);
+    fflush(stdout);
+
+    tune(&tuner, k);
+    const double end_error = compute_error(&tuner, k, NULL);
+
+    int* tuned = (int*)&params;
+    for (int p = 0; p != EVAL_PARAMS_COUNT; ++p) tuned[p] = (int)SDL_floor(tuner.weights[p] + 0.5);
+
+    const char is_saved = eval_params_save(&params, tuner.options.output_path);
+
+    printf("tune: error %.6f -> %.6f in %.1f s\n", start_error, end_error, (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency());
+    printf("tune: material rook %i knight %i bishop %i queen %i pawn %i, bishop pair %i, tempo %i\n", params.material[rook], params.material[knight], params.material[bishop],
+           params.material[queen], params.material[pawn], params.bishop_pair, params.tempo);
+    if (is_saved) printf("tune: weights written to %s\n", tuner.options.output_path);
+
+    free(tuner.threads);
+    free(tuner.jobs);
+    free(tuner.entries);
+
+    return is_saved ? 0 : 1;
+}
@@ -0,0 +1,513 @@
+#include <uci_engine.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#define strtok_r strtok_s
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static void push_message(uci_engine_t* engine, const uci_message_t* message)
+{
+    SDL_LockMutex(engine->lock);
+
+    // a full queue drops its oldest message, only info lines pile up that much
+    if (engine->messages_count == UCI_QUEUE_SIZE)
+    {
+        engine->first_message = (engine->first_message + 1) % UCI_QUEUE_SIZE;
+        engine->messages_count--;
+    }
+
+    engine->messages[(engine->first_message + engine->messages_count) % UCI_QUEUE_SIZE] = *message;
+    engine->messages_count++;
+
+    SDL_UnlockMutex(engine->lock);
+}
+
+static void parse_line(uci_engine_t* engine, char* line)
+{
+    uci_message_t message;
+    SDL_memset(&message, 0, sizeof(uci_message_t));
+
+    char* save = NULL;
+    const char* token = strtok_r(line, " \t\r", &save);
+    if (!token) return;
+
+    if (!strcmp(token, "uciok"))
+    {
+        message.type = uci_message_uciok;
+    } else if (!strcmp(token, "readyok"))
+    {
+        message.type = uci_message_readyok;
+    } else if (!strcmp(token, "bestmove"))
+    {
+        message.type = uci_message_bestmove;
+
+        for (token = strtok_r(NULL, " \t\r", &save); token; token = strtok_r(NULL, " \t\r", &save))
+        {
+            if (!strcmp(token, "ponder")) continue;
+            SDL_strlcpy(message.move[0] ? message.ponder : message.move, token, sizeof(message.move));
+        }
+    } else if (!strcmp(token, "info"))
+    {
+        message.type = uci_message_info;
+        char has_score = FALSE;
+
+        // only the keywords read here are followed by a value. The others, lowerbound and upperbound after a score
+        // among them, are skipped one token at a time: a value that isn't a keyword is skipped just as well
+        for (token = strtok_r(NULL, " \t\r", &save); token; token = strtok_r(NULL, " \t\r", &save))
+        {
+            if (!strcmp(token, "string")) return;
+
+            const char is_read = !strcmp(token, "depth") || !strcmp(token, "nodes") || !strcmp(token, "nps") || !strcmp(token, "pv") || !strcmp(token, "score");
+            if (!is_read) continue;
+
+            const char* value = strtok_r(NULL, " \t\r", &save);
+            if (!value) break;
+
+            if (!strcmp(token, "depth")) message.depth = atoi(value);
+            else if (!strcmp(token, "nodes")) message.nodes = strtoull(value, NULL, 10);
+            else if (!strcmp(token, "nps")) message.nps = strtoull(value, NULL, 10);
+            else if (!strcmp(token, "pv"))
+            {
+                // the pv runs to the end of the line, only its first move is kept
+                SDL_strlcpy(message.move, value, sizeof(message.move));
+                break;
+            } else
+            {
+                const char* score = strtok_r(NULL, " \t\r", &save);
+                if (!score) break;
+
+                message.is_mate = !strcmp(value, "mate");
+                message.score = atoi(score);
+                has_score = TRUE;
+            }
+        }
+
+        // currmove and hashfull lines come many times per second and say nothing about the position
+        if (!has_score) return;
+    } else
+    {
+        return;
+    }
+
+    push_message(engine, &message);
+}
+
+static void read_lines(uci_engine_t* engine, const char* data, int count)
+{
+    for (int i = 0; i != count; ++i)
+    {
+        if (data[i] == '\n')
+        {
+            engine->line[engine->line_length] = '\0';
+            parse_line(engine, engine->line);
+            engine->line_length = 0;
+        } else if (engine->line_length < UCI_MAX_LINE - 1)
+        {
+            // an overlong line is cut, the end of a pv is never needed
+            engine->line[engine->line_length++] = data[i];
+        }
+    }
+}
+
+#ifdef _WIN32
+
+static void wake_worker(uci_engine_t* engine) { SetEvent(engine->wake); }
+
+// anonymous pipes can't be waited on, the thread drains them and sleeps on the wake event between rounds. In
+// PIPE_NOWAIT mode reads and writes never block, like the non-blocking descriptors elsewhere
+static int uci_worker(void* data)
+{
+    uci_engine_t* engine = (uci_engine_t*)data;
+    char buffer[UCI_MAX_LINE];
+    Uint32 quit_ticks = 0;
+
+    for (ever)
+    {
+        SDL_LockMutex(engine->lock);
+        const char has_output = engine->output_length != 0;
+        const char is_quitting = engine->is_quitting;
+        SDL_UnlockMutex(engine->lock);
+
+        // quitting waits for the last commands, quit among them, to be written
+        if (is_quitting && !has_output) break;
+        if (is_quitting && !quit_ticks) quit_ticks = SDL_GetTicks();
+        if (is_quitting && SDL_GetTicks() - quit_ticks >= UCI_QUIT_TIMEOUT_MS) break;
+
+        char has_progress = FALSE;
+
+        if (has_output)
+        {
+            SDL_LockMutex(engine->lock);
+
+            DWORD written = 0;
+            if (WriteFile(engine->to_engine, engine->output, (DWORD)engine->output_length, &written, NULL))
+            {
+                engine->output_length -= (int)written;
+                SDL_memmove(engine->output, engine->output + written, engine->output_length);
+                has_progress = written != 0;
+            } else if (GetLastError() != ERROR_NO_DATA)
+            {
+                // nobody reads anymore, the exit shows up on the other pipe
+                engine->output_length = 0;
+            }
+
+            SDL_UnlockMutex(engine->lock);
+        }
+
+        DWORD count = 0;
+        if (ReadFile(engine->from_engine, buffer, sizeof(buffer), &count, NULL))
+        {
+            read_lines(engine, buffer, (int)count);
+            has_progress |= count != 0;
+        } else if (GetLastError() != ERROR_NO_DATA)
+        {
+            const uci_message_t exited = {uci_message_exited};
+            push_message(engine, &exited);
+            break;
+        }
+
+        if (!has_progress) WaitForSingleObject(engine->wake, UCI_POLL_MS);
+    }
+
+    return 0;
+}
+
+static char spawn(uci_engine_t* engine, const char* command)
+{
+    SECURITY_ATTRIBUTES inherited = {sizeof(SECURITY_ATTRIBUTES), NULL, TRUE};
+    HANDLE to[2] = {NULL, NULL}, from[2] = {NULL, NULL};
+
+    if (!CreatePipe(&to[0], &to[1], &inherited, UCI_PIPE_SIZE)) return FALSE;
+    if (!CreatePipe(&from[0], &from[1], &inherited, UCI_PIPE_SIZE))
+    {
+        CloseHandle(to[0]);
+        CloseHandle(to[1]);
+        return FALSE;
+    }
+
+    // the child only gets its own ends
+    SetHandleInformation(to[1], HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(from[0], HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA startup;
+    SDL_memset(&startup, 0, sizeof(STARTUPINFOA));
+    startup.cb = sizeof(STARTUPINFOA);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = to[0];
+    startup.hStdOutput = from[1];
+    startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+    // no shell in between: the command line is split by the program itself, arguments still work
+    char command_line[UCI_MAX_LINE];
+    SDL_strlcpy(command_line, command, sizeof(command_line));
+
+    PROCESS_INFORMATION process;
+    const BOOL is_started = CreateProcessA(NULL, command_line, NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &startup, &process);
+
+    CloseHandle(to[0]);
+    CloseHandle(from[1]);
+
+    if (!is_started)
+    {
+        CloseHandle(to[1]);
+        CloseHandle(from[0]);
+        return FALSE;
+    }
+
+    CloseHandle(process.hThread);
+    engine->process = process.hProcess;
+    engine->to_engine = to[1];
+    engine->from_engine = from[0];
+
+    DWORD mode = PIPE_READMODE_BYTE | PIPE_NOWAIT;
+    return SetNamedPipeHandleState(engine->to_engine, &mode, NULL, NULL) && SetNamedPipeHandleState(engine->from_engine, &mode, NULL, NULL);
+}
+
+static char open_engine(uci_engine_t* engine, const char* command)
+{
+    engine->wake = CreateEventA(NULL, FALSE, FALSE, NULL);
+    if (engine->wake && spawn(engine, command)) return TRUE;
+
+    SDL_Log("Couldn't start the uci engine %s: error %lu", command, GetLastError());
+    return FALSE;
+}
+
+static void close_engine(uci_engine_t* engine)
+{
+    if (engine->to_engine) CloseHandle(engine->to_engine);
+    if (engine->from_engine) CloseHandle(engine->from_engine);
+    if (engine->wake) CloseHandle(engine->wake);
+
+    // an engine that ignores quit and its closed input gets killed
+    if (engine->process)
+    {
+        if (WaitForSingleObject(engine->process, UCI_QUIT_TIMEOUT_MS) != WAIT_OBJECT_0)
+        {
+            TerminateProcess(engine->process, 1);
+            WaitForSingleObject(engine->process, INFINITE);
+        }
+
+        CloseHandle(engine->process);
+    }
+}
+
+#else
+
+static void wake_worker(uci_engine_t* engine)
+{
+    // a full pipe already has the worker awake
+    if (write(engine->wake[1], "", 1) != 1 && errno != EAGAIN) SDL_Log("Couldn't wake up the uci engine thread");
+}
+
+static int uci_worker(void* data)
+{
+    uci_engine_t* engine = (uci_engine_t*)data;
+    char buffer[UCI_MAX_LINE];
+
+    for (ever)
+    {
+        SDL_LockMutex(engine->lock);
+        const char has_output = engine->output_length != 0;
+        const char is_quitting = engine->is_quitting;
+        SDL_UnlockMutex(engine->lock);
+
+        // quitting waits for the last commands, quit among them, to be written
+        if (is_quitting && !has_output) break;
+
+        struct pollfd fds[3] = {{engine->from_engine, POLLIN, 0}, {engine->wake[0], POLLIN, 0}, {engine->to_engine, has_output ? POLLOUT : 0, 0}};
+        const int ready = poll(fds, 3, is_quitting ? UCI_QUIT_TIMEOUT_MS : -1);
+
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0 || (ready == 0 && is_quitting)) break;
+
+        if (fds[1].revents & POLLIN)
+        {
+            while (read(engine->wake[0], buffer, sizeof(buffer)) > 0) { }
+        }
+
+        if (fds[2].revents & (POLLOUT | POLLERR | POLLHUP))
+        {
+            SDL_LockMutex(engine->lock);
+
+            const ssize_t written = write(engine->to_engine, engine->output, engine->output_length);
+            if (written > 0)
+            {
+                engine->output_length -= (int)written;
+                SDL_memmove(engine->output, engine->output + written, engine->output_length);
+            } else if (written < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                // nobody reads anymore, the exit shows up on the other pipe
+                engine->output_length = 0;
+            }
+
+            SDL_UnlockMutex(engine->lock);
+        }
+
+        if (fds[0].revents & (POLLIN | POLLERR | POLLHUP))
+        {
+            const ssize_t count = read(engine->from_engine, buffer, sizeof(buffer));
+
+            if (count > 0)
+            {
+                read_lines(engine, buffer, (int)count);
+            } else if (count == 0 || (errno != EAGAIN && errno != EINTR))
+            {
+                const uci_message_t exited = {uci_message_exited};
+                push_message(engine, &exited);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static char set_non_blocking(int fd) { return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0 && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0; }
+
+static char spawn(uci_engine_t* engine, const char* command)
+{
+    int to[2], from[2];
+    if (pipe(to) != 0) return FALSE;
+    if (pipe(from) != 0)
+    {
+        close(to[0]);
+        close(to[1]);
+        return FALSE;
+    }
+
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(to[0], STDIN_FILENO);
+        dup2(from[1], STDOUT_FILENO);
+        close(to[0]);
+        close(to[1]);
+        close(from[0]);
+        close(from[1]);
+
+        execl("/bin/sh", "sh", "-c", command, (char*)NULL);
+        _exit(127);
+    }
+
+    close(to[0]);
+    close(from[1]);
+
+    if (pid < 0)
+    {
+        close(to[1]);
+        close(from[0]);
+        return FALSE;
+    }
+
+    engine->pid = (int)pid;
+    engine->to_engine = to[1];
+    engine->from_engine = from[0];
+
+    return set_non_blocking(engine->to_engine) && set_non_blocking(engine->from_engine);
+}
+
+static char open_engine(uci_engine_t* engine, const char* command)
+{
+    engine->to_engine = engine->from_engine = engine->wake[0] = engine->wake[1] = -1;
+
+    // a write to an engine that died must fail, not end the game
+    signal(SIGPIPE, SIG_IGN);
+
+    if (spawn(engine, command) && pipe(engine->wake) == 0 && set_non_blocking(engine->wake[0]) && set_non_blocking(engine->wake[1])) return TRUE;
+
+    SDL_Log("Couldn't start the uci engine %s: %s", command, strerror(errno));
+    return FALSE;
+}
+
+static void close_engine(uci_engine_t* engine)
+{
+    if (engine->to_engine >= 0) close(engine->to_engine);
+    if (engine->from_engine >= 0) close(engine->from_engine);
+    if (engine->wake[0] >= 0) close(engine->wake[0]);
+    if (engine->wake[1] >= 0) close(engine->wake[1]);
+
+    // an engine that ignores quit and its closed input gets killed
+    if (engine->pid > 0)
+    {
+        const Uint32 start_ticks = SDL_GetTicks();
+        while (waitpid(engine->pid, NULL, WNOHANG) == 0)
+        {
+            if (SDL_GetTicks() - start_ticks >= UCI_QUIT_TIMEOUT_MS)
+            {
+                kill(engine->pid, SIGKILL);
+                waitpid(engine->pid, NULL, 0);
+                break;
+            }
+
+            SDL_Delay(10);
+        }
+    }
+}
+
+#endif
+
+char uci_engine_new(uci_engine_t* engine, const char* command)
+{
+    SDL_memset(engine, 0, sizeof(uci_engine_t));
+
+    if (!open_engine(engine, command))
+    {
+        uci_engine_destroy(engine);
+        return FALSE;
+    }
+
+    engine->lock = SDL_CreateMutex();
+    engine->thread = engine->lock ? SDL_CreateThread(uci_worker, "uci engine", engine) : NULL;
+
+    if (!engine->thread)
+    {
+        SDL_Log("Couldn't start uci engine thread: [%s]", SDL_GetError());
+        uci_engine_destroy(engine);
+        return FALSE;
+    }
+
+    uci_engine_send(engine, "uci");
+    return TRUE;
+}
+
+void uci_engine_send(uci_engine_t* engine, const char* format, ...)
+{
+    if (!engine->thread) return;
+
+    char line[UCI_MAX_LINE];
+    va_list args;
+    va_start(args, format);
+    const int length = SDL_vsnprintf(line, UCI_MAX_LINE - 1, format, args);
+    va_end(args);
+
+    if (length < 0 || length >= UCI_MAX_LINE - 1)
+    {
+        SDL_Log("Uci command too long, not sent");
+        return;
+    }
+
+    line[length] = '\n';
+
+    SDL_LockMutex(engine->lock);
+    const char has_room = engine->output_length + length + 1 <= UCI_MAX_OUTPUT;
+    if (has_room)
+    {
+        SDL_memcpy(engine->output + engine->output_length, line, length + 1);
+        engine->output_length += length + 1;
+    }
+    SDL_UnlockMutex(engine->lock);
+
+    if (!has_room) SDL_Log("The uci engine doesn't read its input, dropping: %.*s", length, line);
+    else wake_worker(engine);
+}
+
+char uci_engine_poll(uci_engine_t* engine, uci_message_t* message)
+{
+    if (!engine->thread) return FALSE;
+
+    SDL_LockMutex(engine->lock);
+
+    const char has_message = engine->messages_count != 0;
+    if (has_message)
+    {
+        *message = engine->messages[engine->first_message];
+        engine->first_message = (engine->first_message + 1) % UCI_QUEUE_SIZE;
+        engine->messages_count--;
+    }
+
+    SDL_UnlockMutex(engine->lock);
+
+    return has_message;
+}
+
+void uci_engine_destroy(uci_engine_t* engine)
+{
+    if (engine->thread)
+    {
+        uci_engine_send(engine, "quit");
+
+        SDL_LockMutex(engine->lock);
+        engine->is_quitting = TRUE;
+        SDL_UnlockMutex(engine->lock);
+        wake_worker(engine);
+
+        SDL_WaitThread(engine->thread, NULL);
+    }
+
+    close_engine(engine);
+
+    if (engine->lock) SDL_DestroyMutex(engine->lock);
+    SDL_memset(engine, 0, sizeof(uci_engine_t));
+}
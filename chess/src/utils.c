@@ -1,4 +1,5 @@
 #include <board.h>
+#include <input.h>
 #include <utils.h>
 
 #include <SDL.h>
@@ -6,7 +7,7 @@
 int get_index_by_mouse_coords()
 {
     int mouse_x, mouse_y;
-    SDL_GetMouseState(&mouse_x, &mouse_y);
+    input_get_mouse_state(&mouse_x, &mouse_y);
 
     if (mouse_y >= SCREEN_H) return INVALID_INDEX;
 
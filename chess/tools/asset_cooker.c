@@ -0,0 +1,218 @@
+// Asset cooker: bakes every game asset into a single bundle that the game maps at startup.
+// usage: asset_cooker <output bundle> <assets dir> <asset paths relative to the assets dir...>
+
+#define SDL_MAIN_HANDLED
+
+#include <bundle.h>
+#include <private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+// do not change this order
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+typedef struct cooked_asset {
+    bundle_entry_t entry;
+    void* data;
+    void (*free_data)(void* data);
+} cooked_asset_t;
+
+static const char* get_extension(const char* path)
+{
+    const char* dot = strrchr(path, '.');
+    return dot ? dot + 1 : "";
+}
+
+static void free_wav(void* data) { SDL_FreeWAV((Uint8*)data); }
+
+static char cook_texture(const char* path, cooked_asset_t* asset)
+{
+    int width, height, color_channel;
+    unsigned char* pixels = stbi_load(path, &width, &height, &color_channel, STBI_rgb_alpha);
+    CHECK(pixels, FALSE, "Couldn't decode texture");
+
+    asset->entry.type = bundle_texture;
+    asset->entry.width = (uint32_t)width;
+    asset->entry.height = (uint32_t)height;
+    asset->entry.size = (uint32_t)(width * height * STBI_rgb_alpha);
+    asset->data = pixels;
+    asset->free_data = stbi_image_free;
+
+    return TRUE;
+}
+
+static char cook_font(const char* path, cooked_asset_t* asset)
+{
+    size_t size = 0;
+    void* data = SDL_LoadFile(path, &size);
+    CHECK(data, FALSE, "Couldn't read font");
+
+    asset->entry.type = bundle_font;
+    asset->entry.size = (uint32_t)size;
+    asset->data = data;
+    asset->free_data = SDL_free;
+
+    return TRUE;
+}
+
+static char cook_sound(const char* path, cooked_asset_t* asset)
+{
+    SDL_AudioSpec spec;
+    Uint8* samples = NULL;
+    Uint32 length = 0;
+
+    if (!SDL_LoadWAV(path, &spec, &samples, &length))
+    {
+        fprintf(stderr, "Couldn't decode %s: %s\n", path, SDL_GetError());
+        return FALSE;
+    }
+
+    // convert once here to the mixer output format so that the game can play the samples in place
+    SDL_AudioCVT cvt;
+    if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_SAMPLE_FORMAT, AUDIO_CHANNELS, AUDIO_FREQUENCY) < 0)
+    {
+        fprintf(stderr, "Couldn't convert %s: %s\n", path, SDL_GetError());
+        SDL_FreeWAV(samples);
+        return FALSE;
+    }
+
+    asset->entry.type = bundle_sound;
+    asset->entry.width = AUDIO_FREQUENCY;
+    asset->entry.height = AUDIO_CHANNELS;
+    asset->entry.format = AUDIO_SAMPLE_FORMAT;
+
+    if (!cvt.needed)
+    {
+        asset->entry.size = length;
+        asset->data = samples;
+        asset->free_data = free_wav;
+        return TRUE;
+    }
+
+    cvt.len = (int)length;
+    cvt.buf = (Uint8*)SDL_malloc((size_t)cvt.len * cvt.len_mult);
+    CHECK(cvt.buf, FALSE, "Couldn't allocate conversion buffer");
+    SDL_memcpy(cvt.buf, samples, length);
+    SDL_FreeWAV(samples);
+
+    if (SDL_ConvertAudio(&cvt) < 0)
+    {
+        fprintf(stderr, "Couldn't convert %s: %s\n", path, SDL_GetError());
+        SDL_free(cvt.buf);
+        return FALSE;
+    }
+
+    asset->entry.size = (uint32_t)cvt.len_cvt;
+    asset->data = cvt.buf;
+    asset->free_data = SDL_free;
+
+    return TRUE;
+}
+
+static int compare_assets(const void* a, const void* b) { return strncmp(((const cooked_asset_t*)a)->entry.name, ((const cooked_asset_t*)b)->entry.name, BUNDLE_NAME_SZ); }
+
+static uint32_t align_offset(uint32_t offset) { return (offset + BUNDLE_ALIGNMENT - 1) & ~(uint32_t)(BUNDLE_ALIGNMENT - 1); }
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: %s <output bundle> <assets dir> <assets...>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* output_path = argv[1];
+    const char* assets_dir = argv[2];
+    const int assets_count = argc - 3;
+
+    cooked_asset_t* assets = (cooked_asset_t*)calloc(assets_count, sizeof(cooked_asset_t));
+    CHECK(assets, EXIT_FAILURE, "Couldn't allocate memory for assets");
+
+    int cooked_count = 0;
+    for (int i = 0; i != assets_count; ++i)
+    {
+        const char* name = argv[3 + i];
+        const char* extension = get_extension(name);
+
+        if (strlen(name) >= BUNDLE_NAME_SZ)
+        {
+            fprintf(stderr, "Asset name too long: %s\n", name);
+            return EXIT_FAILURE;
+        }
+
+        char path[1024];
+        SDL_snprintf(path, sizeof(path), "%s/%s", assets_dir, name);
+
+        cooked_asset_t* asset = &assets[cooked_count];
+        SDL_strlcpy(asset->entry.name, name, BUNDLE_NAME_SZ);
+
+        char is_cooked = FALSE;
+        if (!strcmp(extension, "comp"))
+            is_cooked = cook_texture(path, asset);
+        else if (!strcmp(extension, "ttf"))
+            is_cooked = cook_font(path, asset);
+        else if (!strcmp(extension, "wav"))
+            is_cooked = cook_sound(path, asset);
+        else
+        {
+            printf("skipping %s\n", name);
+            continue;
+        }
+
+        if (!is_cooked)
+        {
+            fprintf(stderr, "Couldn't cook %s\n", path);
+            return EXIT_FAILURE;
+        }
+
+        cooked_count++;
+    }
+
+    // entries are sorted so that the game can binary search them
+    qsort(assets, cooked_count, sizeof(cooked_asset_t), compare_assets);
+
+    uint32_t offset = align_offset((uint32_t)(sizeof(bundle_header_t) + cooked_count * sizeof(bundle_entry_t)));
+    for (int i = 0; i != cooked_count; ++i)
+    {
+        assets[i].entry.offset = offset;
+        offset = align_offset(offset + assets[i].entry.size);
+    }
+
+    FILE* output = fopen(output_path, "wb");
+    if (!output)
+    {
+        fprintf(stderr, "Couldn't open %s for writing\n", output_path);
+        return EXIT_FAILURE;
+    }
+
+    bundle_header_t header = {BUNDLE_MAGIC, BUNDLE_VERSION, (uint32_t)cooked_count, 0};
+    fwrite(&header, sizeof(header), 1, output);
+
+    for (int i = 0; i != cooked_count; ++i)
+    {
+        fwrite(&assets[i].entry, sizeof(bundle_entry_t), 1, output);
+    }
+
+    const char padding[BUNDLE_ALIGNMENT] = {0};
+    long position = (long)(sizeof(bundle_header_t) + cooked_count * sizeof(bundle_entry_t));
+    for (int i = 0; i != cooked_count; ++i)
+    {
+        fwrite(padding, 1, assets[i].entry.offset - position, output);
+        fwrite(assets[i].data, 1, assets[i].entry.size, output);
+        position = (long)(assets[i].entry.offset + assets[i].entry.size);
+
+        assets[i].free_data(assets[i].data);
+    }
+
+    fclose(output);
+    free(assets);
+
+    printf("cooked %i assets into %s (%u bytes)\n", cooked_count, output_path, (unsigned)position);
+
+    return EXIT_SUCCESS;
+}